@@ -0,0 +1,131 @@
+#include <cstdint>
+#include <vector>
+#include <string>
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <DisjointSets.h>
+
+// Benchmark of DisjointSets policies: latency of unions (two finds and a join) and
+// of finds over random elements, for a ladder of set counts (widths).
+// Usage: DisjointSetBench [width,width,...] [repetitions]
+
+namespace {
+
+    std::uint64_t nextRandom(std::uint64_t &state)
+    {
+        state ^= state << 13;
+        state ^= state >> 7;
+        state ^= state << 17;
+        return state;
+    }
+
+    // Nanoseconds per union and per find, and a checksum of the representatives found.
+    struct Timing {
+        double unionNs;
+        double findNs;
+        std::uint64_t checksum;
+    };
+
+    template <typename Sets>
+    Timing measure(std::uint32_t width, std::uint32_t repetitions)
+    {
+        Timing timing{0, 0, 0};
+        std::uint64_t state = 88172645463325252;
+        std::chrono::steady_clock::duration unionTime{0};
+        std::chrono::steady_clock::duration findTime{0};
+        for (std::uint32_t r = 0; r < repetitions; r++) {
+            Sets sets(width);
+            for (std::uint32_t k = 0; k < width; k++) {
+                sets.pop(1);
+            }
+            std::vector<std::uint32_t> elements(width);
+            for (std::uint32_t &element : elements) {
+                element = static_cast<std::uint32_t>(nextRandom(state) % width);
+            }
+            auto start = std::chrono::steady_clock::now();
+            for (std::uint32_t k = 0; k + 1 < width; k += 2) {
+                std::uint32_t root1 = sets.get(elements[k]);
+                std::uint32_t root2 = sets.get(elements[k + 1]);
+                if (root1 != root2) {
+                    sets.join(root1, root2);
+                }
+            }
+            auto middle = std::chrono::steady_clock::now();
+            for (std::uint32_t element : elements) {
+                timing.checksum += sets.get(element);
+            }
+            auto end = std::chrono::steady_clock::now();
+            unionTime += middle - start;
+            findTime += end - middle;
+        }
+        timing.unionNs = std::chrono::duration<double, std::nano>(unionTime).count() /
+            (static_cast<double>(width >> 1) * repetitions);
+        timing.findNs = std::chrono::duration<double, std::nano>(findTime).count() /
+            (static_cast<double>(width) * repetitions);
+        return timing;
+    }
+
+    template <typename FindPolicy, typename UnionPolicy, typename Layout>
+    void report(std::string const &name, std::uint32_t width, std::uint32_t repetitions,
+        std::uint64_t &checksum)
+    {
+        Timing timing = measure<DisjointSets<FindPolicy, UnionPolicy, Layout>>(
+            width, repetitions);
+        checksum += timing.checksum;
+        std::cout << "  " << name << " union " << timing.unionNs << " ns, find " <<
+            timing.findNs << " ns\n";
+    }
+
+    template <typename FindPolicy, typename UnionPolicy>
+    void reportLayouts(std::string const &name, std::uint32_t width, std::uint32_t repetitions,
+        std::uint64_t &checksum)
+    {
+        report<FindPolicy, UnionPolicy, DisjointSetPolicy::SeparateArrays>(
+            name + " soa", width, repetitions, checksum);
+        report<FindPolicy, UnionPolicy, DisjointSetPolicy::InterleavedArray>(
+            name + " aos", width, repetitions, checksum);
+    }
+
+}
+
+int main(int argc, char **argv)
+{
+    std::vector<std::uint32_t> widths{64, 1024, 16384, 262144, 4194304};
+    if (argc > 1) {
+        widths.clear();
+        std::string list = argv[1];
+        std::size_t begin = 0;
+        while (begin < list.size()) {
+            std::size_t end = list.find(',', begin);
+            if (end == std::string::npos) {
+                end = list.size();
+            }
+            widths.push_back(static_cast<std::uint32_t>(std::stoul(list.substr(begin, end - begin))));
+            begin = end + 1;
+        }
+    }
+    std::uint32_t repetitions = argc > 2 ? static_cast<std::uint32_t>(std::stoul(argv[2])) : 0;
+    std::uint64_t checksum = 0;
+    for (std::uint32_t width : widths) {
+        // About 2^24 elements per measurement unless given.
+        std::uint32_t widthRepetitions = repetitions != 0 ? repetitions :
+            static_cast<std::uint32_t>(std::max<std::uint64_t>(1, (1 << 24) / std::max(width, 1u)));
+        std::cout << "width " << width << ", repetitions " << widthRepetitions << '\n';
+        using namespace DisjointSetPolicy;
+        reportLayouts<NoCompression, UnionByDegree>(
+            "none        degree", width, widthRepetitions, checksum);
+        reportLayouts<PathHalving, UnionByDegree>(
+            "halving     degree", width, widthRepetitions, checksum);
+        reportLayouts<PathCompression, UnionByDegree>(
+            "compression degree", width, widthRepetitions, checksum);
+        reportLayouts<NoCompression, UnionByRank>(
+            "none        rank  ", width, widthRepetitions, checksum);
+        reportLayouts<PathHalving, UnionByRank>(
+            "halving     rank  ", width, widthRepetitions, checksum);
+        reportLayouts<PathCompression, UnionByRank>(
+            "compression rank  ", width, widthRepetitions, checksum);
+    }
+    std::cout << "checksum " << checksum << '\n';
+    return 0;
+}
\ No newline at end of file
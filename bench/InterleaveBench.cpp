@@ -0,0 +1,106 @@
+#include <cstdint>
+#include <vector>
+#include <string>
+#include <utility>
+#include <chrono>
+#include <iostream>
+#include <BitInterleave.h>
+
+// Benchmark of BMP row encoding and decoding: the per-cell loop formerly used by
+// Maze::toBMP and Maze(fileName) against the BitInterleave kernels.
+// Usage: InterleaveBench [width] [repetitions]
+
+namespace {
+
+    void naiveInterleave(std::uint64_t const *even, std::uint64_t const *odd,
+        std::uint32_t count, char *row)
+    {
+        for (std::uint32_t j = 0; j < (count + 3) >> 2; j++) {
+            row[j] = 0;
+        }
+        for (std::uint32_t j = 0; j < count; j++) {
+            if ((even[j >> 6] >> (j & 63)) & 1) {
+                row[j >> 2] |= 1 << (7 - ((j & 3) << 1));
+            }
+            if ((odd[j >> 6] >> (j & 63)) & 1) {
+                row[j >> 2] |= 1 << (6 - ((j & 3) << 1));
+            }
+        }
+    }
+
+    void naiveDeinterleave(char const *row, std::uint32_t count,
+        std::uint64_t *even, std::uint64_t *odd)
+    {
+        for (std::uint32_t w = 0; w < (count + 63) >> 6; w++) {
+            even[w] = 0;
+            odd[w] = 0;
+        }
+        for (std::uint32_t j = 0; j < count; j++) {
+            if (row[j >> 2] & (1 << (7 - ((j & 3) << 1)))) {
+                even[j >> 6] |= static_cast<std::uint64_t>(1) << (j & 63);
+            }
+            if (row[j >> 2] & (1 << (6 - ((j & 3) << 1)))) {
+                odd[j >> 6] |= static_cast<std::uint64_t>(1) << (j & 63);
+            }
+        }
+    }
+
+    // Throughput in GB/s of BMP row bytes produced or consumed.
+    template <typename Function>
+    double measure(Function const &function, std::uint32_t width, std::uint32_t repetitions)
+    {
+        auto start = std::chrono::steady_clock::now();
+        for (std::uint32_t r = 0; r < repetitions; r++) {
+            function();
+        }
+        std::chrono::duration<double> seconds = std::chrono::steady_clock::now() - start;
+        return static_cast<double>((width + 3) >> 2) * repetitions / seconds.count() / 1e9;
+    }
+
+}
+
+int main(int argc, char **argv)
+{
+    std::uint32_t width = argc > 1 ? static_cast<std::uint32_t>(std::stoul(argv[1])) : 65536;
+    std::uint32_t repetitions = argc > 2 ? static_cast<std::uint32_t>(std::stoul(argv[2])) : 2000;
+    std::uint32_t words = (width + 63) >> 6;
+    std::vector<std::uint64_t> even(words);
+    std::vector<std::uint64_t> odd(words);
+    std::uint64_t state = 88172645463325252;
+    for (std::uint32_t w = 0; w < words; w++) {
+        state ^= state << 13;
+        state ^= state >> 7;
+        state ^= state << 17;
+        even[w] = state;
+        odd[w] = ~state * 0x9E3779B97F4A7C15;
+    }
+    std::vector<char> row((width + 3) >> 2);
+    std::vector<std::uint64_t> evenOut(words);
+    std::vector<std::uint64_t> oddOut(words);
+    std::uint64_t checksum = 0;
+    std::cout << "width " << width << ", repetitions " << repetitions << '\n';
+    std::cout << "naive  encode " << measure([&]() {
+        naiveInterleave(even.data(), odd.data(), width, row.data());
+        checksum += static_cast<std::uint8_t>(row[0]);
+    }, width, repetitions) << " GB/s, decode " << measure([&]() {
+        naiveDeinterleave(row.data(), width, evenOut.data(), oddOut.data());
+        checksum += evenOut[0];
+    }, width, repetitions) << " GB/s\n";
+    std::vector<std::pair<BitInterleave::Implementation, std::string>> implementations =
+        {{BitInterleave::Scalar, "scalar"}, {BitInterleave::BMI2, "bmi2  "}};
+    for (auto const &implementation : implementations) {
+        if (!BitInterleave::setImplementation(implementation.first)) {
+            std::cout << implementation.second << " not supported\n";
+            continue;
+        }
+        std::cout << implementation.second << " encode " << measure([&]() {
+            BitInterleave::interleave(even.data(), odd.data(), width, row.data());
+            checksum += static_cast<std::uint8_t>(row[0]);
+        }, width, repetitions) << " GB/s, decode " << measure([&]() {
+            BitInterleave::deinterleave(row.data(), width, evenOut.data(), oddOut.data());
+            checksum += evenOut[0];
+        }, width, repetitions) << " GB/s\n";
+    }
+    std::cout << "checksum " << checksum << '\n';
+    return 0;
+}
\ No newline at end of file
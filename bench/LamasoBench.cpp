@@ -0,0 +1,286 @@
+#include <cstdint>
+#include <cstdio>
+#include <vector>
+#include <string>
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <Path.h>
+#include <Maze.h>
+#include <Utilities.h>
+
+// Benchmarks of path and maze generation, solving and BMP input/output over a ladder
+// of square table sizes and seeds, with warmup runs, timed iterations and percentiles.
+// Results are written as JSON, progress goes to standard error.
+// Usage: LamasoBench [options]
+//   --sizes 1024,4096,16384,65536  table sides
+//   --seeds 1,2,3                  random seeds
+//   --warmup 1                     untimed runs before the timed iterations
+//   --iterations 5                 timed runs
+//   --path-max 4096                largest side for random path generation and Path::cells
+//   --solve-max 16384              largest side for Maze::solve
+//   --only tree,solve              run only the listed benchmarks
+//   --bmp LamasoBench.bmp          temporary BMP file
+//   --output results.json          output file (standard output if omitted)
+// Benchmarks: path, cells, tree, density, solve, toBMP, loadBMP.
+
+namespace {
+
+    struct Options {
+        std::vector<std::uint32_t> sizes{1024, 4096, 16384, 65536};
+        std::vector<std::int32_t> seeds{1, 2, 3};
+        std::uint32_t warmup = 1;
+        std::uint32_t iterations = 5;
+        std::uint32_t pathMax = 4096;
+        std::uint32_t solveMax = 16384;
+        std::vector<std::string> only;
+        std::string bmpFileName = "LamasoBench.bmp";
+        std::string outputFileName;
+    };
+
+    // Timings of one benchmark for one size and seed, in milliseconds.
+    struct Result {
+        std::string name;
+        std::uint32_t side;
+        std::int32_t seed;
+        std::vector<double> milliseconds;
+        // Benchmark-specific value (path length, cell count, ...) to detect changed output.
+        std::uint64_t check;
+    };
+
+    template <typename Value>
+    std::vector<Value> parseList(std::string const &text)
+    {
+        std::vector<Value> values;
+        std::stringstream stream(text);
+        std::string item;
+        while (std::getline(stream, item, ',')) {
+            if (!item.empty()) {
+                values.push_back(static_cast<Value>(std::stoll(item)));
+            }
+        }
+        return values;
+    }
+
+    std::vector<std::string> parseNames(std::string const &text)
+    {
+        std::vector<std::string> names;
+        std::stringstream stream(text);
+        std::string item;
+        while (std::getline(stream, item, ',')) {
+            if (!item.empty()) {
+                names.push_back(item);
+            }
+        }
+        return names;
+    }
+
+    // Return false if an option is unknown or has no value.
+    bool parseOptions(int argc, char **argv, Options &options)
+    {
+        for (int k = 1; k < argc; k++) {
+            std::string option = argv[k];
+            if (k + 1 == argc) {
+                return false;
+            }
+            std::string value = argv[++k];
+            if (option == "--sizes") {
+                options.sizes = parseList<std::uint32_t>(value);
+            }
+            else if (option == "--seeds") {
+                options.seeds = parseList<std::int32_t>(value);
+            }
+            else if (option == "--warmup") {
+                options.warmup = static_cast<std::uint32_t>(std::stoul(value));
+            }
+            else if (option == "--iterations") {
+                options.iterations = std::max<std::uint32_t>(1, std::stoul(value));
+            }
+            else if (option == "--path-max") {
+                options.pathMax = static_cast<std::uint32_t>(std::stoul(value));
+            }
+            else if (option == "--solve-max") {
+                options.solveMax = static_cast<std::uint32_t>(std::stoul(value));
+            }
+            else if (option == "--only") {
+                options.only = parseNames(value);
+            }
+            else if (option == "--bmp") {
+                options.bmpFileName = value;
+            }
+            else if (option == "--output") {
+                options.outputFileName = value;
+            }
+            else {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    class Runner {
+
+        Options const &m_options;
+
+        std::vector<Result> m_results;
+
+    public:
+
+        Runner(Options const &options) :
+            m_options{options}
+        {}
+
+        bool enabled(std::string const &name) const
+        {
+            return m_options.only.empty() ||
+                std::find(m_options.only.begin(), m_options.only.end(), name) !=
+                m_options.only.end();
+        }
+
+        // Run function (returning the check value) warmup + iterations times
+        // and record the timed iterations.
+        template <typename Function>
+        void run(std::string const &name, std::uint32_t side, std::int32_t seed,
+            Function const &function)
+        {
+            if (!enabled(name)) {
+                return;
+            }
+            std::cerr << name << " " << side << " x " << side << ", seed " << seed << " ..." <<
+                std::flush;
+            Result result{name, side, seed, {}, 0};
+            for (std::uint32_t r = 0; r < m_options.warmup; r++) {
+                result.check = function();
+            }
+            for (std::uint32_t r = 0; r < m_options.iterations; r++) {
+                auto start = std::chrono::steady_clock::now();
+                result.check = function();
+                std::chrono::duration<double, std::milli> duration =
+                    std::chrono::steady_clock::now() - start;
+                result.milliseconds.push_back(duration.count());
+            }
+            std::sort(result.milliseconds.begin(), result.milliseconds.end());
+            std::cerr << " " << percentile(result.milliseconds, 50) << " ms\n";
+            m_results.push_back(result);
+        }
+
+        // Nearest-rank percentile of sorted values.
+        static double percentile(std::vector<double> const &sorted, std::uint32_t p)
+        {
+            std::uint64_t rank = (static_cast<std::uint64_t>(p) * sorted.size() + 99) / 100;
+            return sorted[rank == 0 ? 0 : rank - 1];
+        }
+
+        void writeJSON(std::ostream &stream) const
+        {
+            stream << "{\n";
+            stream << "  \"benchmark\": \"LamasoBench\",\n";
+            stream << "  \"hardwareThreads\": " << Utilities::threadCount(0) << ",\n";
+            stream << "  \"warmup\": " << m_options.warmup << ",\n";
+            stream << "  \"iterations\": " << m_options.iterations << ",\n";
+            stream << "  \"results\": [";
+            for (std::uint64_t k = 0; k < m_results.size(); k++) {
+                Result const &result = m_results[k];
+                double sum = 0;
+                for (double value : result.milliseconds) {
+                    sum += value;
+                }
+                stream << (k == 0 ? "\n" : ",\n");
+                stream << "    {\"name\": \"" << result.name << "\", \"height\": " <<
+                    result.side << ", \"width\": " << result.side << ", \"seed\": " <<
+                    result.seed << ", \"check\": " << result.check <<
+                    ", \"minMs\": " << result.milliseconds.front() <<
+                    ", \"meanMs\": " << sum / result.milliseconds.size() <<
+                    ", \"p50Ms\": " << percentile(result.milliseconds, 50) <<
+                    ", \"p90Ms\": " << percentile(result.milliseconds, 90) <<
+                    ", \"p99Ms\": " << percentile(result.milliseconds, 99) <<
+                    ", \"maxMs\": " << result.milliseconds.back() << "}";
+            }
+            stream << "\n  ]\n}\n";
+        }
+
+    };
+
+}
+
+int main(int argc, char **argv)
+{
+    Options options;
+    if (!parseOptions(argc, argv, options)) {
+        std::cerr << "Invalid options. See the usage in bench/LamasoBench.cpp.\n";
+        return 1;
+    }
+    Runner runner(options);
+    for (std::uint32_t side : options.sizes) {
+        for (std::int32_t seed : options.seeds) {
+            if (side <= options.pathMax && side > 2) {
+                Path path;
+                runner.run("path", side, seed, [&]() {
+                    path = Path(side, side, seed, 0, 0, side - 1, side - 1, 0, 0);
+                    return path.length();
+                });
+                if (runner.enabled("cells")) {
+                    if (!runner.enabled("path")) {
+                        path = Path(side, side, seed, 0, 0, side - 1, side - 1, 0, 0);
+                    }
+                    runner.run("cells", side, seed, [&]() {
+                        PathCells cells = path.cells();
+                        std::uint64_t cellCount = 0;
+                        for (std::uint32_t i = 0; i < side; i++) {
+                            cellCount += cells[i].size();
+                        }
+                        return cellCount;
+                    });
+                }
+            }
+            Path emptyPath(side, side, 0, 0, Path::Directions());
+            runner.run("density", side, seed, [&]() {
+                Maze maze(emptyPath, seed, 100);
+                return static_cast<std::uint64_t>(maze.hasWall(side - 1, side - 1, Path::Up));
+            });
+            bool needsTree = runner.enabled("tree") ||
+                (side <= options.solveMax && runner.enabled("solve")) ||
+                runner.enabled("toBMP") || runner.enabled("loadBMP");
+            if (!needsTree) {
+                continue;
+            }
+            Maze maze(emptyPath, seed);
+            runner.run("tree", side, seed, [&]() {
+                maze = Maze(emptyPath, seed);
+                return static_cast<std::uint64_t>(maze.hasWall(side - 1, side - 1, Path::Up));
+            });
+            if (side <= options.solveMax) {
+                runner.run("solve", side, seed, [&]() {
+                    return maze.solve(0, 0, side - 1, side - 1).length();
+                });
+            }
+            runner.run("toBMP", side, seed, [&]() {
+                return static_cast<std::uint64_t>(maze.toBMP(options.bmpFileName));
+            });
+            if (runner.enabled("loadBMP")) {
+                if (!runner.enabled("toBMP")) {
+                    maze.toBMP(options.bmpFileName);
+                }
+                runner.run("loadBMP", side, seed, [&]() {
+                    Maze loaded(options.bmpFileName);
+                    return static_cast<std::uint64_t>(loaded.getHeight());
+                });
+            }
+            std::remove(options.bmpFileName.c_str());
+        }
+    }
+    if (options.outputFileName.empty()) {
+        runner.writeJSON(std::cout);
+        return 0;
+    }
+    std::ofstream file(options.outputFileName);
+    runner.writeJSON(file);
+    file.close();
+    if (!file) {
+        std::cerr << "Could not write " << options.outputFileName << ".\n";
+        return 1;
+    }
+    return 0;
+}
\ No newline at end of file
@@ -0,0 +1,64 @@
+#include <cstdint>
+#include <string>
+#include <fstream>
+#include <algorithm>
+#include <Utilities.h>
+#include <PositionalFile.h>
+#include <Metrics.h>
+#include <BMPBandWriter.h>
+
+std::uint64_t BMPBandWriter::writeHeader(std::string const &fileName,
+    std::uint32_t height, std::uint32_t width)
+{
+    Metrics::PhaseTimer timer(Metrics::Write);
+    std::ofstream file;
+    if (!Utilities::writeBMP(fileName, (width << 1) + 1, (height << 1) + 1, file)) {
+        return 0;
+    }
+    std::uint64_t dataOffset = static_cast<std::uint64_t>(file.tellp());
+    file.close();
+    return file ? dataOffset : 0;
+}
+
+BMPBandWriter::BMPBandWriter(std::string const &fileName, std::uint32_t height, std::uint32_t width) :
+    m_height{height},
+    m_rowBytes{((width >> 4) + 1) << 2},
+    m_dataOffset{writeHeader(fileName, height, width)},
+    m_file{m_dataOffset != 0 ? fileName : std::string(),
+        m_dataOffset + ((static_cast<std::uint64_t>(height) << 1) + 1) * m_rowBytes},
+    m_bandHeight{1}
+{
+    std::uint64_t bandHeight = std::max<std::uint64_t>(
+        bandBytes / (static_cast<std::uint64_t>(m_rowBytes) << 1) & ~static_cast<std::uint64_t>(63), 64);
+    m_bandHeight = static_cast<std::uint32_t>(std::min<std::uint64_t>(bandHeight, std::max(height, 1u)));
+}
+
+bool BMPBandWriter::isOpen() const
+{
+    return m_file.isOpen();
+}
+
+std::uint32_t BMPBandWriter::getRowBytes() const
+{
+    return m_rowBytes;
+}
+
+std::uint32_t BMPBandWriter::getBandHeight() const
+{
+    return m_bandHeight;
+}
+
+bool BMPBandWriter::writeBottomBorder(char const *row) const
+{
+    Metrics::PhaseTimer timer(Metrics::Write);
+    return m_file.write(m_dataOffset, row, m_rowBytes);
+}
+
+bool BMPBandWriter::writeRows(std::uint32_t firstRow, std::uint32_t rowEnd, char const *rows) const
+{
+    Metrics::PhaseTimer timer(Metrics::Write);
+    // Maze row i is stored after the bottom border and the rows below it.
+    std::uint64_t firstBMPRow = (static_cast<std::uint64_t>(m_height - rowEnd) << 1) + 1;
+    return m_file.write(m_dataOffset + firstBMPRow * m_rowBytes, rows,
+        static_cast<std::uint64_t>(rowEnd - firstRow) * m_rowBytes << 1);
+}
\ No newline at end of file
@@ -0,0 +1,95 @@
+#ifndef BMPBANDWRITER_H
+#define BMPBANDWRITER_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <atomic>
+#include <algorithm>
+#include <Utilities.h>
+#include <PositionalFile.h>
+
+// Writer of the BMP image of a maze or a path of size height x width (see Maze::toBMP),
+// in which bands of rows are encoded by several threads and each band is written at its
+// offset in the file as soon as it is encoded, so that encoding and writing overlap.
+// The header is written by Utilities::writeBMP, and the file is then sized for all rows.
+// Writing the header and the rows is timed as Metrics::Write, while encoding is left
+// to be timed by the callers.
+// As in BMP files, rows are stored from the bottom up: the bottom border, then for each
+// maze row from the last one, its BMP row with cells (row2) and the one above it (row1).
+class BMPBandWriter {
+
+    std::uint32_t m_height;
+
+    // Bytes of a BMP row.
+    std::uint32_t m_rowBytes;
+
+    // Offset of the image data, 0 if the header could not be written.
+    std::uint64_t m_dataOffset;
+
+    PositionalFile m_file;
+
+    // Maze rows per band.
+    std::uint32_t m_bandHeight;
+
+    // Create the file and write the header, returning the image data offset, or 0 if failed.
+    static std::uint64_t writeHeader(std::string const &fileName,
+        std::uint32_t height, std::uint32_t width);
+
+public:
+
+    // Approximate size of the encoded rows of a band.
+    static constexpr std::uint64_t bandBytes = static_cast<std::uint64_t>(4) << 20;
+
+    // Create (or overwrite) a BMP file for a maze or a path of given size.
+    BMPBandWriter(std::string const &fileName, std::uint32_t height, std::uint32_t width);
+
+    // Return true if the file has been created.
+    bool isOpen() const;
+
+    // Bytes of a BMP row.
+    std::uint32_t getRowBytes() const;
+
+    // Maze rows per band, a multiple of 64 (see PathRowCursor) unless all rows are one band.
+    std::uint32_t getBandHeight() const;
+
+    // Write the BMP row of the bottom border. Return false if failed.
+    bool writeBottomBorder(char const *row) const;
+
+    // Write the BMP rows of maze rows [firstRow, rowEnd), given in the order of the file
+    // (row2 and row1 of row rowEnd - 1 first). May be called by several threads at once
+    // for different rows. Return false if failed.
+    bool writeRows(std::uint32_t firstRow, std::uint32_t rowEnd, char const *rows) const;
+
+    // Encode and write all maze rows band by band, by up to threadCount threads (all hardware
+    // threads if threadCount = 0). For each band, encodeBand(thread, firstRow, rowEnd, rows)
+    // is called by the thread of given index (smaller than Utilities::threadCount(threadCount))
+    // to fill rows as in writeRows. Buffers of each thread are zero-initialized and reused
+    // for its following bands. Return false if failed.
+    template <typename EncodeBand>
+    bool write(std::uint32_t threadCount, EncodeBand const &encodeBand) const;
+
+};
+
+template <typename EncodeBand>
+bool BMPBandWriter::write(std::uint32_t threadCount, EncodeBand const &encodeBand) const
+{
+    std::atomic<bool> failed{false};
+    std::vector<std::vector<char>> buffers(Utilities::threadCount(threadCount));
+    Utilities::indexedParallelFor((m_height + m_bandHeight - 1) / m_bandHeight, 1, threadCount,
+        [&](std::uint32_t thread, std::uint64_t begin, std::uint64_t end) {
+            std::vector<char> &rows = buffers[thread];
+            for (std::uint64_t band = begin; band < end && !failed; band++) {
+                std::uint32_t firstRow = static_cast<std::uint32_t>(band) * m_bandHeight;
+                std::uint32_t rowEnd = std::min(firstRow + m_bandHeight, m_height);
+                rows.resize(static_cast<std::uint64_t>(rowEnd - firstRow) * m_rowBytes << 1);
+                encodeBand(thread, firstRow, rowEnd, rows.data());
+                if (!writeRows(firstRow, rowEnd, rows.data())) {
+                    failed = true;
+                }
+            }
+        });
+    return !failed;
+}
+
+#endif
\ No newline at end of file
@@ -0,0 +1,59 @@
+#include <cstdint>
+#include <vector>
+#include <string>
+#include <fstream>
+#include <algorithm>
+#include <Utilities.h>
+#include <MazeImage.h>
+#include <Metrics.h>
+#include <BMPMazeRowSink.h>
+
+BMPMazeRowSink::BMPMazeRowSink(std::string const &fileName) :
+    m_fileName{fileName},
+    m_width{0},
+    m_bmpWidthBytes{0},
+    m_rowCount{0}
+{}
+
+bool BMPMazeRowSink::begin(std::uint32_t height, std::uint32_t width)
+{
+    std::int32_t bmpHeight = (height << 1) + 1;
+    std::int32_t bmpWidth = (width << 1) + 1;
+    if (!Utilities::writeBMP(m_fileName, bmpWidth, -bmpHeight, m_file)) {
+        return false;
+    }
+    m_width = width;
+    m_rowCount = 0;
+    m_bmpWidthBytes = (((bmpWidth - 1) >> 5) + 1) << 2;
+    m_row1.assign(m_bmpWidthBytes, 0);
+    m_row2.assign(m_bmpWidthBytes, 0);
+    m_scratch.assign(MazeImage::scratchWords(width), 0);
+    m_row1[0] = 64;
+    return static_cast<bool>(m_file.write(m_row1.data(), m_bmpWidthBytes));
+}
+
+bool BMPMazeRowSink::writeRow(std::uint64_t const *verticalWalls,
+    std::uint64_t const *horizontalWalls)
+{
+    {
+        Metrics::PhaseTimer timer(Metrics::Encode);
+        MazeImage::encodeRows(m_width, m_rowCount == 0, verticalWalls, horizontalWalls,
+            m_scratch.data(), m_row1.data(), m_row2.data());
+    }
+    Metrics::PhaseTimer timer(Metrics::Write);
+    if (m_rowCount++ != 0 && !m_file.write(m_row1.data(), m_bmpWidthBytes)) {
+        return false;
+    }
+    return static_cast<bool>(m_file.write(m_row2.data(), m_bmpWidthBytes));
+}
+
+bool BMPMazeRowSink::end()
+{
+    Metrics::PhaseTimer timer(Metrics::Write);
+    MazeImage::encodeBottomBorder(m_width, m_row1.data());
+    if (!m_file.write(m_row1.data(), m_bmpWidthBytes)) {
+        return false;
+    }
+    m_file.close();
+    return static_cast<bool>(m_file);
+}
\ No newline at end of file
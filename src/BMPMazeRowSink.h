@@ -0,0 +1,49 @@
+#ifndef BMPMAZEROWSINK_H
+#define BMPMAZEROWSINK_H
+
+#include <cstdint>
+#include <vector>
+#include <string>
+#include <fstream>
+#include <TreeMazeGenerator.h>
+
+// Maze row sink writing a BMP file in the format of Maze::toBMP, but stored top-down
+// (with negative height), so that rows are written in the order they are received.
+class BMPMazeRowSink : public MazeRowSink {
+
+    // Output file name.
+    std::string m_fileName;
+
+    // Output file.
+    std::ofstream m_file;
+
+    // Maze width.
+    std::uint32_t m_width;
+
+    // Number of bytes in a BMP row.
+    std::uint32_t m_bmpWidthBytes;
+
+    // Number of rows received so far.
+    std::uint32_t m_rowCount;
+
+    // Buffers for the BMP row with horizontal walls and the BMP row with cells.
+    std::vector<char> m_row1;
+    std::vector<char> m_row2;
+
+    // Scratch memory for MazeImage::encodeRows.
+    std::vector<std::uint64_t> m_scratch;
+
+public:
+
+    BMPMazeRowSink(std::string const &fileName);
+
+    bool begin(std::uint32_t height, std::uint32_t width) override;
+
+    bool writeRow(std::uint64_t const *verticalWalls,
+        std::uint64_t const *horizontalWalls) override;
+
+    bool end() override;
+
+};
+
+#endif
\ No newline at end of file
@@ -0,0 +1,273 @@
+#include <cstdint>
+#include <atomic>
+#include <BitInterleave.h>
+
+#if defined(__GNUC__) && defined(__x86_64__)
+#include <cpuid.h>
+#include <immintrin.h>
+#define BITINTERLEAVE_BMI2 __attribute__((target("bmi2")))
+#elif defined(_MSC_VER) && defined(_M_X64)
+#include <intrin.h>
+#include <immintrin.h>
+#define BITINTERLEAVE_BMI2
+#endif
+
+namespace {
+
+    std::uint64_t const evenBits = 0x5555555555555555;
+
+    // Move bit k of a 32-bit value to bit 2k.
+    std::uint64_t spread(std::uint64_t x)
+    {
+        x = (x | (x << 16)) & 0x0000ffff0000ffff;
+        x = (x | (x << 8)) & 0x00ff00ff00ff00ff;
+        x = (x | (x << 4)) & 0x0f0f0f0f0f0f0f0f;
+        x = (x | (x << 2)) & 0x3333333333333333;
+        return (x | (x << 1)) & evenBits;
+    }
+
+    // Move bit 2k to bit k (inverse of spread).
+    std::uint64_t compact(std::uint64_t x)
+    {
+        x &= evenBits;
+        x = (x | (x >> 1)) & 0x3333333333333333;
+        x = (x | (x >> 2)) & 0x0f0f0f0f0f0f0f0f;
+        x = (x | (x >> 4)) & 0x00ff00ff00ff00ff;
+        x = (x | (x >> 8)) & 0x0000ffff0000ffff;
+        return (x | (x >> 16)) & 0x00000000ffffffff;
+    }
+
+    // Reverse the order of bit pairs within each byte. Applied to a word holding
+    // bit j of odd in bit 2j and bit j of even in bit 2j + 1, this gives BMP pixel order.
+    std::uint64_t reversePairs(std::uint64_t x)
+    {
+        x = ((x >> 2) & 0x3333333333333333) | ((x & 0x3333333333333333) << 2);
+        return ((x >> 4) & 0x0f0f0f0f0f0f0f0f) | ((x & 0x0f0f0f0f0f0f0f0f) << 4);
+    }
+
+    // Store the lowest byteCount bytes of x, least significant byte first.
+    void store(char *row, std::uint64_t x, std::uint32_t byteCount)
+    {
+        for (std::uint32_t k = 0; k < byteCount; k++) {
+            row[k] = static_cast<char>(x >> (k << 3));
+        }
+    }
+
+    // Load byteCount bytes, least significant byte first.
+    std::uint64_t load(char const *row, std::uint32_t byteCount)
+    {
+        std::uint64_t x = 0;
+        for (std::uint32_t k = 0; k < byteCount; k++) {
+            x |= static_cast<std::uint64_t>(static_cast<std::uint8_t>(row[k])) << (k << 3);
+        }
+        return x;
+    }
+
+    // Mask of the lowest count bits, 0 < count <= 64.
+    std::uint64_t lowBits(std::uint32_t count)
+    {
+        return count == 64 ? ~static_cast<std::uint64_t>(0) :
+            (static_cast<std::uint64_t>(1) << count) - 1;
+    }
+
+    // Interleave 32 bits of even and odd into 64 pixels.
+    struct ScalarKernel {
+        static std::uint64_t interleave(std::uint64_t even, std::uint64_t odd)
+        {
+            return reversePairs(spread(odd) | (spread(even) << 1));
+        }
+        static void deinterleave(std::uint64_t pixels, std::uint64_t &even, std::uint64_t &odd)
+        {
+            pixels = reversePairs(pixels);
+            even = compact(pixels >> 1);
+            odd = compact(pixels);
+        }
+    };
+
+#ifdef BITINTERLEAVE_BMI2
+    struct BMI2Kernel {
+        BITINTERLEAVE_BMI2 static std::uint64_t interleave(std::uint64_t even, std::uint64_t odd)
+        {
+            return reversePairs(_pdep_u64(odd, evenBits) | _pdep_u64(even, evenBits << 1));
+        }
+        BITINTERLEAVE_BMI2 static void deinterleave(std::uint64_t pixels,
+            std::uint64_t &even, std::uint64_t &odd)
+        {
+            pixels = reversePairs(pixels);
+            even = _pext_u64(pixels, evenBits << 1);
+            odd = _pext_u64(pixels, evenBits);
+        }
+    };
+#endif
+
+    template <typename Kernel>
+    void interleaveRow(std::uint64_t const *even, std::uint64_t const *odd,
+        std::uint32_t count, char *row)
+    {
+        std::uint32_t wordCount = count >> 6;
+        for (std::uint32_t w = 0; w < wordCount; w++) {
+            store(row, Kernel::interleave(even[w] & 0xffffffff, odd[w] & 0xffffffff), 8);
+            store(row + 8, Kernel::interleave(even[w] >> 32, odd[w] >> 32), 8);
+            row += 16;
+        }
+        std::uint32_t rest = count & 63;
+        if (rest != 0) {
+            std::uint64_t mask = lowBits(rest);
+            std::uint64_t evenWord = even[wordCount] & mask;
+            std::uint64_t oddWord = odd[wordCount] & mask;
+            std::uint32_t byteCount = (rest + 3) >> 2;
+            store(row, Kernel::interleave(evenWord & 0xffffffff, oddWord & 0xffffffff),
+                byteCount < 8 ? byteCount : 8);
+            if (byteCount > 8) {
+                store(row + 8, Kernel::interleave(evenWord >> 32, oddWord >> 32), byteCount - 8);
+            }
+        }
+    }
+
+    template <typename Kernel>
+    void deinterleaveRow(char const *row, std::uint32_t count,
+        std::uint64_t *even, std::uint64_t *odd)
+    {
+        std::uint32_t wordCount = count >> 6;
+        std::uint64_t evenLow, oddLow, evenHigh, oddHigh;
+        for (std::uint32_t w = 0; w < wordCount; w++) {
+            Kernel::deinterleave(load(row, 8), evenLow, oddLow);
+            Kernel::deinterleave(load(row + 8, 8), evenHigh, oddHigh);
+            even[w] = evenLow | (evenHigh << 32);
+            odd[w] = oddLow | (oddHigh << 32);
+            row += 16;
+        }
+        std::uint32_t rest = count & 63;
+        if (rest != 0) {
+            std::uint32_t byteCount = (rest + 3) >> 2;
+            Kernel::deinterleave(load(row, byteCount < 8 ? byteCount : 8), evenLow, oddLow);
+            evenHigh = 0;
+            oddHigh = 0;
+            if (byteCount > 8) {
+                Kernel::deinterleave(load(row + 8, byteCount - 8), evenHigh, oddHigh);
+            }
+            std::uint64_t mask = lowBits(rest);
+            even[wordCount] = (evenLow | (evenHigh << 32)) & mask;
+            odd[wordCount] = (oddLow | (oddHigh << 32)) & mask;
+        }
+    }
+
+    bool supportsBMI2()
+    {
+#if defined(__GNUC__) && defined(__x86_64__)
+        __builtin_cpu_init();
+        return __builtin_cpu_supports("bmi2");
+#elif defined(_MSC_VER) && defined(_M_X64)
+        int info[4];
+        __cpuidex(info, 7, 0);
+        return (info[1] & (1 << 8)) != 0;
+#else
+        return false;
+#endif
+    }
+
+    // PDEP and PEXT are microcoded on AMD processors before Zen 3 (family 19h) and on
+    // Hygon ones (Zen 1 derivatives), where they are much slower than the scalar version.
+    bool fastBMI2()
+    {
+        if (!supportsBMI2()) {
+            return false;
+        }
+        unsigned int vendor;
+        unsigned int signature;
+#if defined(__GNUC__) && defined(__x86_64__)
+        unsigned int eax, ebx, ecx, edx;
+        if (!__get_cpuid(0, &eax, &ebx, &ecx, &edx)) {
+            return false;
+        }
+        vendor = ebx;
+        if (!__get_cpuid(1, &eax, &ebx, &ecx, &edx)) {
+            return false;
+        }
+        signature = eax;
+#elif defined(_MSC_VER) && defined(_M_X64)
+        int info[4];
+        __cpuid(info, 0);
+        vendor = static_cast<unsigned int>(info[1]);
+        __cpuid(info, 1);
+        signature = static_cast<unsigned int>(info[0]);
+#else
+        return false;
+#endif
+        unsigned int family = (signature >> 8) & 0xf;
+        if (family == 0xf) {
+            family += (signature >> 20) & 0xff;
+        }
+        // First four characters of "AuthenticAMD" and "HygonGenuine".
+        bool amd = vendor == 0x68747541;
+        bool hygon = vendor == 0x6f677948;
+        return !hygon && (!amd || family >= 0x19);
+    }
+
+    using InterleaveFunction = void (*)(std::uint64_t const *, std::uint64_t const *,
+        std::uint32_t, char *);
+
+    using DeinterleaveFunction = void (*)(char const *, std::uint32_t,
+        std::uint64_t *, std::uint64_t *);
+
+    struct Dispatch {
+        BitInterleave::Implementation implementation;
+        InterleaveFunction interleave;
+        DeinterleaveFunction deinterleave;
+    };
+
+    Dispatch const scalarDispatch =
+        {BitInterleave::Scalar, interleaveRow<ScalarKernel>, deinterleaveRow<ScalarKernel>};
+
+#ifdef BITINTERLEAVE_BMI2
+    Dispatch const bmi2Dispatch =
+        {BitInterleave::BMI2, interleaveRow<BMI2Kernel>, deinterleaveRow<BMI2Kernel>};
+#endif
+
+    Dispatch const *dispatchFor(BitInterleave::Implementation implementation)
+    {
+#ifdef BITINTERLEAVE_BMI2
+        if (implementation == BitInterleave::BMI2) {
+            return &bmi2Dispatch;
+        }
+#endif
+        return &scalarDispatch;
+    }
+
+    // Selected implementation, switched atomically between the constant tables above
+    // so that setImplementation may run concurrently with encoding and decoding.
+    std::atomic<Dispatch const *> &dispatch()
+    {
+        static std::atomic<Dispatch const *> selected{
+            dispatchFor(fastBMI2() ? BitInterleave::BMI2 : BitInterleave::Scalar)};
+        return selected;
+    }
+
+}
+
+void BitInterleave::interleave(std::uint64_t const *even, std::uint64_t const *odd,
+    std::uint32_t count, char *row)
+{
+    dispatch().load(std::memory_order_relaxed)->interleave(even, odd, count, row);
+}
+
+void BitInterleave::deinterleave(char const *row, std::uint32_t count,
+    std::uint64_t *even, std::uint64_t *odd)
+{
+    dispatch().load(std::memory_order_relaxed)->deinterleave(row, count, even, odd);
+}
+
+BitInterleave::Implementation BitInterleave::implementation()
+{
+    return dispatch().load(std::memory_order_relaxed)->implementation;
+}
+
+bool BitInterleave::setImplementation(Implementation implementation)
+{
+    if (implementation == BMI2 && !supportsBMI2()) {
+        return false;
+    }
+    Dispatch const *selected = dispatchFor(implementation);
+    dispatch().store(selected, std::memory_order_relaxed);
+    return selected->implementation == implementation;
+}
\ No newline at end of file
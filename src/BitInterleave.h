@@ -0,0 +1,38 @@
+#ifndef BITINTERLEAVE_H
+#define BITINTERLEAVE_H
+
+#include <cstdint>
+
+// Conversion between pairs of bit arrays and rows of monochrome BMP images,
+// in which pixels are stored from the most significant bit of each byte.
+// Bit arrays store bit j in bit (j & 63) of the (j >> 6)-th 64-bit word.
+// The implementation is selected at runtime: BMI2 (PDEP/PEXT) on processors where
+// these instructions are fast, otherwise a portable word-at-a-time scalar version.
+// BMI2 can still be requested with setImplementation wherever it is supported.
+namespace BitInterleave {
+
+    enum Implementation {Scalar, BMI2};
+
+    // Write the first 2 * count pixels of a BMP row, where pixel 2j is bit j of even
+    // and pixel 2j + 1 is bit j of odd. Exactly (count + 3) / 4 bytes are written,
+    // with bits beyond the last pixel cleared. Bits of even and odd beyond count are ignored.
+    void interleave(std::uint64_t const *even, std::uint64_t const *odd,
+        std::uint32_t count, char *row);
+
+    // Read the first 2 * count pixels of a BMP row into even and odd (inverse of interleave).
+    // The first (count + 63) / 64 words of even and odd are overwritten,
+    // with bits beyond count cleared.
+    void deinterleave(char const *row, std::uint32_t count,
+        std::uint64_t *even, std::uint64_t *odd);
+
+    // Implementation in use.
+    Implementation implementation();
+
+    // Use given implementation. Return false if it is not supported by the processor.
+    // Safe to call while other threads encode or decode: each of their calls uses
+    // either the previous or the new implementation, with identical results.
+    bool setImplementation(Implementation implementation);
+
+}
+
+#endif
\ No newline at end of file
@@ -0,0 +1,30 @@
+#include <cstdint>
+#include <algorithm>
+#include <BitPlanes.h>
+
+BitPlanes::BitPlanes() :
+    m_height{0},
+    m_width{0},
+    m_planeCount{0},
+    m_rowWords{0}
+{}
+
+BitPlanes::BitPlanes(std::uint32_t height, std::uint32_t width, std::uint32_t planeCount) :
+    m_height{height},
+    m_width{width},
+    m_planeCount{planeCount}
+{
+    // Round each row up to a whole number of cache lines (8 words).
+    m_rowWords = ((getUsedRowWords() + 7) >> 3) << 3;
+    m_words.resize(static_cast<std::uint64_t>(m_height) * m_planeCount * m_rowWords, 0);
+}
+
+std::uint64_t BitPlanes::byteSize() const
+{
+    return m_words.size() * sizeof(std::uint64_t);
+}
+
+void BitPlanes::clear()
+{
+    std::fill(m_words.begin(), m_words.end(), 0);
+}
\ No newline at end of file
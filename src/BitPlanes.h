@@ -0,0 +1,187 @@
+#ifndef BITPLANES_H
+#define BITPLANES_H
+
+#include <cstdint>
+#include <cstddef>
+#include <new>
+#include <vector>
+#if defined(_MSC_VER) && !defined(__GNUC__)
+#include <intrin.h>
+#endif
+
+// Standard allocator returning memory aligned to a cache line.
+template <typename T>
+struct CacheAlignedAllocator {
+
+    using value_type = T;
+
+    static constexpr std::size_t alignment = 64;
+
+    CacheAlignedAllocator() = default;
+
+    template <typename U>
+    CacheAlignedAllocator(CacheAlignedAllocator<U> const &) {}
+
+    T *allocate(std::size_t count)
+    {
+        return static_cast<T *>(
+            ::operator new(count * sizeof(T), std::align_val_t{alignment}));
+    }
+
+    void deallocate(T *pointer, std::size_t)
+    {
+        ::operator delete(pointer, std::align_val_t{alignment});
+    }
+
+    template <typename U>
+    bool operator==(CacheAlignedAllocator<U> const &) const
+    {
+        return true;
+    }
+
+    template <typename U>
+    bool operator!=(CacheAlignedAllocator<U> const &) const
+    {
+        return false;
+    }
+
+};
+
+// A set of bit-planes of size m x n stored in one contiguous, cache-line-aligned buffer.
+// Rows of all planes are interleaved: the i-th rows of planes 0, 1, ... are stored
+// one after another, and each of them starts at a cache line boundary.
+// Bit j of a row is bit (j & 63) of the (j >> 6)-th 64-bit word of the row.
+// Bits of a row beyond the width are always zero.
+class BitPlanes {
+
+    // Height.
+    std::uint32_t m_height;
+
+    // Width.
+    std::uint32_t m_width;
+
+    // Number of planes.
+    std::uint32_t m_planeCount;
+
+    // Number of 64-bit words per row of a single plane, including padding.
+    std::uint32_t m_rowWords;
+
+    // Plane data.
+    std::vector<std::uint64_t, CacheAlignedAllocator<std::uint64_t>> m_words;
+
+public:
+
+    // Empty set of planes.
+    BitPlanes();
+
+    // Planes of size height x width with all bits cleared.
+    BitPlanes(std::uint32_t height, std::uint32_t width, std::uint32_t planeCount);
+
+    std::uint32_t getHeight() const;
+
+    std::uint32_t getWidth() const;
+
+    std::uint32_t getPlaneCount() const;
+
+    // Number of 64-bit words per row of a single plane, including padding.
+    std::uint32_t getRowWords() const;
+
+    // Number of 64-bit words per row of a single plane, excluding padding.
+    std::uint32_t getUsedRowWords() const;
+
+    // Allocated memory in bytes.
+    std::uint64_t byteSize() const;
+
+    // Pointer to the first word of the i-th row of a plane.
+    std::uint64_t *row(std::uint32_t i, std::uint32_t plane);
+
+    std::uint64_t const *row(std::uint32_t i, std::uint32_t plane) const;
+
+    // Bit (i, j) of a plane.
+    bool get(std::uint32_t i, std::uint32_t j, std::uint32_t plane) const;
+
+    // Set bit (i, j) of a plane.
+    void set(std::uint32_t i, std::uint32_t j, std::uint32_t plane, bool value);
+
+    // Clear all bits.
+    void clear();
+
+    // Number of set bits in a word.
+    static std::uint32_t bitCount(std::uint64_t word);
+
+    // Number of zero bits below the lowest set bit of a nonzero word.
+    static std::uint32_t trailingZeros(std::uint64_t word);
+
+};
+
+inline std::uint32_t BitPlanes::getHeight() const
+{
+    return m_height;
+}
+
+inline std::uint32_t BitPlanes::getWidth() const
+{
+    return m_width;
+}
+
+inline std::uint32_t BitPlanes::getPlaneCount() const
+{
+    return m_planeCount;
+}
+
+inline std::uint32_t BitPlanes::getRowWords() const
+{
+    return m_rowWords;
+}
+
+inline std::uint32_t BitPlanes::getUsedRowWords() const
+{
+    return (m_width + 63) >> 6;
+}
+
+inline std::uint64_t *BitPlanes::row(std::uint32_t i, std::uint32_t plane)
+{
+    return m_words.data() +
+        (static_cast<std::uint64_t>(i) * m_planeCount + plane) * m_rowWords;
+}
+
+inline std::uint64_t const *BitPlanes::row(std::uint32_t i, std::uint32_t plane) const
+{
+    return m_words.data() +
+        (static_cast<std::uint64_t>(i) * m_planeCount + plane) * m_rowWords;
+}
+
+inline bool BitPlanes::get(std::uint32_t i, std::uint32_t j, std::uint32_t plane) const
+{
+    return (row(i, plane)[j >> 6] >> (j & 63)) & 1;
+}
+
+inline void BitPlanes::set(std::uint32_t i, std::uint32_t j, std::uint32_t plane, bool value)
+{
+    std::uint64_t &word = row(i, plane)[j >> 6];
+    std::uint64_t mask = static_cast<std::uint64_t>(1) << (j & 63);
+    word = value ? word | mask : word & ~mask;
+}
+
+inline std::uint32_t BitPlanes::bitCount(std::uint64_t word)
+{
+    word -= (word >> 1) & 0x5555555555555555;
+    word = (word & 0x3333333333333333) + ((word >> 2) & 0x3333333333333333);
+    word = (word + (word >> 4)) & 0x0F0F0F0F0F0F0F0F;
+    return static_cast<std::uint32_t>((word * 0x0101010101010101) >> 56);
+}
+
+inline std::uint32_t BitPlanes::trailingZeros(std::uint64_t word)
+{
+#if defined(__GNUC__)
+    return static_cast<std::uint32_t>(__builtin_ctzll(word));
+#elif defined(_MSC_VER) && defined(_M_X64)
+    unsigned long index;
+    _BitScanForward64(&index, word);
+    return static_cast<std::uint32_t>(index);
+#else
+    return bitCount((word & (~word + 1)) - 1);
+#endif
+}
+
+#endif
\ No newline at end of file
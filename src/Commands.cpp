@@ -2,11 +2,19 @@
 #include <iostream>
 #include <string>
 #include <vector>
+#include <fstream>
 #include <chrono>
+#include <memory>
 #include <Commands.h>
 #include <Path.h>
 #include <Maze.h>
+#include <MappedMaze.h>
+#include <LMZFile.h>
+#include <TreeMazeGenerator.h>
+#include <BMPMazeRowSink.h>
+#include <LMZMazeRowSink.h>
 #include <Utilities.h>
+#include <Metrics.h>
 
 std::int64_t integerInput()
 {
@@ -60,17 +68,48 @@ void Commands::newMaze()
         std::cout << "Wall density (0 - 65535): ";
         density = integerInput();
     }
+    if (tree) {
+        std::cout << "Stream maze directly to file? (y = Yes, n = No) ";
+        if (stringInput() == "y") {
+            std::cout << "Maze file (.lmz for tiled maze file): ";
+            std::string mazeFileName = stringInput();
+            std::cout << "Creating and saving maze ...";
+            auto t1 = std::chrono::high_resolution_clock::now();
+            MazeParameters parameters{MazeParameters::Tree, seed, 0, probabilitySet, 1};
+            std::unique_ptr<MazeRowSink> sink;
+            if (LMZFile::hasExtension(mazeFileName)) {
+                sink = std::make_unique<LMZMazeRowSink>(mazeFileName, parameters);
+            }
+            else {
+                sink = std::make_unique<BMPMazeRowSink>(mazeFileName);
+            }
+            bool saved = TreeMazeGenerator::generate(path, seed, probabilitySet, *sink);
+            auto t2 = std::chrono::high_resolution_clock::now();
+            auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(t2 - t1);
+            std::cout << (saved ? " Finished" : " Failed!") <<
+                " in " << duration.count() << " milliseconds.\n";
+            return;
+        }
+    }
+    std::uint32_t stripCount = 1;
+    if (tree) {
+        std::cout << "Number of strips generated in parallel "
+            "(1 = serial generation, 0 = one per hardware thread): ";
+        stripCount = integerInput();
+    }
     std::cout << "Creating maze ...";
     auto t1 = std::chrono::high_resolution_clock::now();
-    Maze maze = tree ? Maze(path, seed, probabilitySet) : Maze(path, seed, density);
+    Maze maze = tree ? Maze(path, seed, probabilitySet, stripCount) : Maze(path, seed, density);
     auto t2 = std::chrono::high_resolution_clock::now();
     auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(t2 - t1);
     std::cout << "\nFinished in " << duration.count() << " milliseconds.\n";
-    std::cout << "Maze file (empty if no saving): ";
+    std::cout << "Maze file (empty if no saving, .lmz for tiled maze file): ";
     std::string mazeFileName = stringInput();
     if (!mazeFileName.empty()) {
         std::cout << "Saving ...";
-        std::cout << (maze.toBMP(mazeFileName) ? " Finished." : " Failed!") << "\n";
+        bool saved = LMZFile::hasExtension(mazeFileName) ?
+            maze.toLMZ(mazeFileName) : maze.toBMP(mazeFileName);
+        std::cout << (saved ? " Finished." : " Failed!") << "\n";
     }
 }
 
@@ -124,21 +163,41 @@ void Commands::solveMaze()
     std::uint32_t i2 = integerInput();
     std::cout << "End column: ";
     std::uint32_t j2 = integerInput();
-    Maze maze(mazeFileName);
+    MappedMaze maze(mazeFileName);
     if (maze.getHeight() == 1 && maze.getWidth() == 1) {
         std::cout << "Empty maze. Possible failure when reading file.\n\n";
         return;
     }
+    std::cout << "Algorithm (1 = Always turn left, 2 = Shortest path (BFS), "
+        "3 = Shortest path (bidirectional A*)): ";
+    std::uint8_t algorithm = integerInput();
+    // BFS needs the whole maze in memory, so decode it before timing the search.
+    std::unique_ptr<Maze> decodedMaze;
+    if (algorithm == 2) {
+        std::cout << "Decoding ...\n";
+        decodedMaze = std::make_unique<Maze>(maze);
+    }
     std::cout << "Solving ...";
+    MazeSolver::Statistics statistics;
     auto t1 = std::chrono::high_resolution_clock::now();
-    Path path = maze.solve(i1, j1, i2, j2);
+    Path path = algorithm == 2 ?
+        decodedMaze->solveShortest(i1, j1, i2, j2, 0, &statistics) :
+        algorithm == 3 ?
+        maze.solveAStar(i1, j1, i2, j2, &statistics) :
+        maze.solve(i1, j1, i2, j2, &statistics);
     auto t2 = std::chrono::high_resolution_clock::now();
     auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(t2 - t1);
     std::cout << "\nFinished in " << duration.count() << " milliseconds.\n";
     std::cout << "Path length: " << path.length() << "\n";
-    float avgHeight = (j1 == j2) ? 0 : path.integral() /
+    std::cout << "Cells expanded: " << statistics.expandedCells << "\n";
+    Path::Statistics pathStatistics = path.stats();
+    float avgHeight = (j1 == j2) ? 0 : pathStatistics.integral /
         (static_cast<float>(j2) - static_cast<float>(j1));
     std::cout << "Average path i-component: " << avgHeight << "\n";
+    std::cout << "Rows: " << pathStatistics.minRow << " - " << pathStatistics.maxRow <<
+        ", columns: " << pathStatistics.minColumn << " - " << pathStatistics.maxColumn << "\n";
+    std::cout << "Turns: " << pathStatistics.leftTurns << " left, " <<
+        pathStatistics.rightTurns << " right\n";
     std::cout << "Save as (empty if no saving): ";
     std::string pathFileName = stringInput();
     if (!pathFileName.empty()) {
@@ -147,15 +206,73 @@ void Commands::solveMaze()
     }
 }
 
+void Commands::solveQueries()
+{
+    std::cout << "\nSolve queries\n";
+    std::cout << "Maze file name: ";
+    std::string mazeFileName = stringInput();
+    std::cout << "Query file name: ";
+    std::string queryFileName = stringInput();
+    std::cout << "Algorithm (1 = Always turn left, 2 = Shortest path (bidirectional A*)): ";
+    MazeSolver::Algorithm algorithm = integerInput() == 1 ?
+        MazeSolver::WallFollower : MazeSolver::BidirectionalAStar;
+    std::cout << "Result file name: ";
+    std::string resultFileName = stringInput();
+    std::vector<MazeSolver::Query> queries;
+    {
+        std::ifstream file(queryFileName);
+        if (!file) {
+            std::cout << "Could not read query file.\n";
+            return;
+        }
+        MazeSolver::Query query;
+        while (file >> query.i1 >> query.j1 >> query.i2 >> query.j2) {
+            queries.push_back(query);
+        }
+        if (!file.eof()) {
+            std::cout << "Invalid query " << queries.size() + 1 << ".\n";
+            return;
+        }
+    }
+    std::cout << "Loading maze ...";
+    Maze maze(mazeFileName);
+    if (maze.getHeight() == 1 && maze.getWidth() == 1) {
+        std::cout << "\nEmpty maze. Possible failure when reading file.\n";
+        return;
+    }
+    std::cout << "\nSolving " << queries.size() << " queries ...";
+    auto t1 = std::chrono::high_resolution_clock::now();
+    std::vector<MazeSolver::Summary> summaries = maze.solveBatchSummaries(queries, algorithm);
+    auto t2 = std::chrono::high_resolution_clock::now();
+    auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(t2 - t1);
+    std::cout << "\nFinished in " << duration.count() << " milliseconds.\n";
+    std::cout << "Saving ...";
+    std::ofstream file(resultFileName);
+    for (std::uint64_t k = 0; k < queries.size() && file; k++) {
+        MazeSolver::Query const &query = queries[k];
+        file << query.i1 << ' ' << query.j1 << ' ' << query.i2 << ' ' << query.j2 << ' ';
+        if (summaries[k].solved) {
+            file << summaries[k].length << ' ' << summaries[k].integral << '\n';
+        }
+        else {
+            file << "-\n";
+        }
+    }
+    file.close();
+    std::cout << (file ? " Finished." : " Failed!") << "\n";
+}
+
 bool Commands::commandPrompt()
 {
     std::cout << "Commands:\n";
     std::cout << "1 New maze\n";
     std::cout << "2 New path\n";
     std::cout << "3 Solve maze\n";
-    std::cout << "4 Exit\n";
+    std::cout << "4 Solve queries\n";
+    std::cout << "5 Exit\n";
     std::cout << "Command: ";
     std::uint8_t command = integerInput();
+    Metrics::reset();
     if (command == 1) {
         newMaze();
     }
@@ -166,11 +283,17 @@ bool Commands::commandPrompt()
         solveMaze();
     }
     else if (command == 4) {
+        solveQueries();
+    }
+    else if (command == 5) {
         return false;
     }
     else {
         std::cout << "Unknown command.\n";
     }
+    if (Metrics::enabled && command >= 1 && command <= 4) {
+        std::cout << "Metrics: " << Metrics::toJSON() << "\n";
+    }
     std::cout << "\n";
     return true;
 }
\ No newline at end of file
@@ -13,6 +13,9 @@ namespace Commands {
     // Prompt for maze file and solve the maze.
     void solveMaze();
 
+    // Prompt for maze file and query file, solve all queries, and save their results.
+    void solveQueries();
+
     // Prompt and execute command. Return false if exit is called.
     bool commandPrompt();
 
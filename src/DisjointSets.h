@@ -0,0 +1,435 @@
+#ifndef DISJOINTSETS_H
+#define DISJOINTSETS_H
+
+#include <cstdint>
+#include <vector>
+#include <utility>
+#include <type_traits>
+#include <algorithm>
+#include <istream>
+#include <ostream>
+#include <Utilities.h>
+
+// Policies of DisjointSets.
+namespace DisjointSetPolicy {
+
+    // Find policies, following parent links from value to the representative of its set
+    // and notifying the counting policy of each link followed.
+
+    // Leave the parent links unchanged.
+    struct NoCompression {
+        template <typename Counting, typename Storage>
+        static std::uint32_t find(Storage &storage, std::uint32_t value);
+    };
+
+    // Link every other element on the path to its grandparent.
+    struct PathHalving {
+        template <typename Counting, typename Storage>
+        static std::uint32_t find(Storage &storage, std::uint32_t value);
+    };
+
+    // Link every element on the path to the representative (two passes).
+    struct PathCompression {
+        template <typename Counting, typename Storage>
+        static std::uint32_t find(Storage &storage, std::uint32_t value);
+    };
+
+    // Union policies, choosing which of two representatives stays one.
+
+    // Keep the representative with greater degree, the first one if equal.
+    struct UnionByDegree {
+        static constexpr bool usesRank = false;
+        template <typename Storage>
+        static bool keepSecond(Storage &storage, std::uint32_t value1, std::uint32_t value2);
+    };
+
+    // Keep the representative with greater rank (upper bound of tree height),
+    // the first one if equal.
+    struct UnionByRank {
+        static constexpr bool usesRank = true;
+        template <typename Storage>
+        static bool keepSecond(Storage &storage, std::uint32_t value1, std::uint32_t value2);
+    };
+
+    // Counting policies, notified of get, join and pop calls and of parent links
+    // followed by get (for example to collect statistics).
+
+    // Ignore all notifications.
+    struct NoCounting {
+        static void get() {}
+        static void hop() {}
+        static void join() {}
+        static void pop() {}
+    };
+
+    // Layout policies, storing parents, degrees and ranks (if used) of elements.
+
+    // Structure of arrays: one vector per field.
+    struct SeparateArrays {
+        template <bool hasRank>
+        class Storage {
+            std::vector<std::uint32_t> m_parents;
+            std::vector<std::uint32_t> m_degrees;
+            std::vector<std::uint32_t> m_ranks;
+        public:
+            void resize(std::uint32_t size);
+            std::uint32_t &parent(std::uint32_t value) { return m_parents[value]; }
+            std::uint32_t &degree(std::uint32_t value) { return m_degrees[value]; }
+            std::uint32_t &rank(std::uint32_t value) { return m_ranks[value]; }
+            std::uint32_t parent(std::uint32_t value) const { return m_parents[value]; }
+            std::uint32_t degree(std::uint32_t value) const { return m_degrees[value]; }
+            std::uint32_t rank(std::uint32_t value) const { return m_ranks[value]; }
+        };
+    };
+
+    // Array of structures: the fields of an element are adjacent in memory.
+    struct InterleavedArray {
+        template <bool hasRank>
+        class Storage {
+            struct Element {
+                std::uint32_t parent;
+                std::uint32_t degree;
+            };
+            struct RankedElement {
+                std::uint32_t parent;
+                std::uint32_t degree;
+                std::uint32_t rank;
+            };
+            std::vector<typename std::conditional<hasRank, RankedElement, Element>::type> m_elements;
+        public:
+            void resize(std::uint32_t size);
+            std::uint32_t &parent(std::uint32_t value) { return m_elements[value].parent; }
+            std::uint32_t &degree(std::uint32_t value) { return m_elements[value].degree; }
+            std::uint32_t &rank(std::uint32_t value);
+            std::uint32_t parent(std::uint32_t value) const { return m_elements[value].parent; }
+            std::uint32_t degree(std::uint32_t value) const { return m_elements[value].degree; }
+            std::uint32_t rank(std::uint32_t value) const;
+        };
+    };
+
+}
+
+// Disjoint sets given by a vector of parent links, in which the parent of a representative
+// is itself and every other link points to a smaller element, so that the representative
+// of a set is its smallest element.
+namespace DisjointSetForest {
+
+    // Return the representative of the set containing value, halving the path to it.
+    std::uint32_t find(std::vector<std::uint32_t> &parents, std::uint32_t value);
+
+    // Join sets with given (distinct) representatives, keeping the smaller one.
+    // Return the representative of the union.
+    std::uint32_t join(std::vector<std::uint32_t> &parents, std::uint32_t root1, std::uint32_t root2);
+
+    // Replace each parent link by the number of the element's set, with sets numbered
+    // from 0 in the order of their representatives. Return the number of sets.
+    std::uint32_t number(std::vector<std::uint32_t> &parents);
+
+}
+
+// Disjoint sets of elements 0 to size - 1 with recycled elements. Elements are handed
+// out by pop and returned by join, which puts the element losing its representative
+// role into a ring buffer; pop takes elements from the ring in the order they were put
+// there (initially 0 to size - 1). The user keeps each element referenced until it
+// comes out of the ring again. Each representative has a degree, maintained by the user
+// (for example a reference count) and added up by join.
+// Parent links are only changed by join and pop, and by find policies which link
+// elements to their ancestors; either way, get returns the same representatives for
+// all find policies, and for a fixed union policy the same sequence of calls produces
+// the same sets and the same ring order.
+template <typename FindPolicy = DisjointSetPolicy::PathHalving,
+    typename UnionPolicy = DisjointSetPolicy::UnionByDegree,
+    typename Layout = DisjointSetPolicy::SeparateArrays,
+    typename Counting = DisjointSetPolicy::NoCounting>
+class DisjointSets {
+
+    using Storage = typename Layout::template Storage<UnionPolicy::usesRank>;
+
+    std::uint32_t m_size;
+    std::uint32_t m_popIndex;
+    std::uint32_t m_pushIndex;
+
+    // Ring buffer of elements to be handed out by pop.
+    std::vector<std::uint32_t> m_free;
+
+    Storage m_storage;
+
+public:
+
+    DisjointSets(std::uint32_t size);
+
+    std::uint32_t size() const;
+
+    // Representative of the set containing value.
+    std::uint32_t get(std::uint32_t value);
+
+    // Join the sets of (distinct) representatives value1 and value2, swapping them if
+    // needed so that value1 is the representative of the union afterwards. The degree
+    // of the union is the sum of their degrees, and value2 is put into the ring.
+    void join(std::uint32_t &value1, std::uint32_t &value2);
+
+    // Take the next element from the ring as a new single-element set with given degree.
+    std::uint32_t pop(std::uint32_t degree);
+
+    // Degree of a representative.
+    std::uint32_t &degree(std::uint32_t value);
+
+    // Write the elements, the ring and the sets to a binary stream. Return false if failed.
+    bool save(std::ostream &stream) const;
+
+    // Read disjoint sets written by save with the same policies, replacing these.
+    // Return false if failed.
+    bool load(std::istream &stream);
+
+};
+
+template <typename Counting, typename Storage>
+std::uint32_t DisjointSetPolicy::NoCompression::find(Storage &storage, std::uint32_t value)
+{
+    while (value != storage.parent(value)) {
+        value = storage.parent(value);
+        Counting::hop();
+    }
+    return value;
+}
+
+template <typename Counting, typename Storage>
+std::uint32_t DisjointSetPolicy::PathHalving::find(Storage &storage, std::uint32_t value)
+{
+    while (value != storage.parent(value)) {
+        std::uint32_t grandparent = storage.parent(storage.parent(value));
+        storage.parent(value) = grandparent;
+        value = grandparent;
+        Counting::hop();
+    }
+    return value;
+}
+
+template <typename Counting, typename Storage>
+std::uint32_t DisjointSetPolicy::PathCompression::find(Storage &storage, std::uint32_t value)
+{
+    std::uint32_t root = value;
+    while (root != storage.parent(root)) {
+        root = storage.parent(root);
+        Counting::hop();
+    }
+    while (value != root) {
+        std::uint32_t parent = storage.parent(value);
+        storage.parent(value) = root;
+        value = parent;
+    }
+    return root;
+}
+
+template <typename Storage>
+bool DisjointSetPolicy::UnionByDegree::keepSecond(Storage &storage,
+    std::uint32_t value1, std::uint32_t value2)
+{
+    return storage.degree(value1) < storage.degree(value2);
+}
+
+template <typename Storage>
+bool DisjointSetPolicy::UnionByRank::keepSecond(Storage &storage,
+    std::uint32_t value1, std::uint32_t value2)
+{
+    if (storage.rank(value1) == storage.rank(value2)) {
+        storage.rank(value1)++;
+        return false;
+    }
+    return storage.rank(value1) < storage.rank(value2);
+}
+
+template <bool hasRank>
+void DisjointSetPolicy::SeparateArrays::Storage<hasRank>::resize(std::uint32_t size)
+{
+    m_parents.resize(size);
+    m_degrees.resize(size);
+    if (hasRank) {
+        m_ranks.resize(size);
+    }
+}
+
+template <bool hasRank>
+void DisjointSetPolicy::InterleavedArray::Storage<hasRank>::resize(std::uint32_t size)
+{
+    m_elements.resize(size);
+}
+
+template <bool hasRank>
+std::uint32_t &DisjointSetPolicy::InterleavedArray::Storage<hasRank>::rank(std::uint32_t value)
+{
+    if constexpr (hasRank) {
+        return m_elements[value].rank;
+    }
+    else {
+        // Never called: union policies without rank do not use it.
+        return m_elements[value].degree;
+    }
+}
+
+template <bool hasRank>
+std::uint32_t DisjointSetPolicy::InterleavedArray::Storage<hasRank>::rank(std::uint32_t value) const
+{
+    if constexpr (hasRank) {
+        return m_elements[value].rank;
+    }
+    else {
+        return 0;
+    }
+}
+
+template <typename FindPolicy, typename UnionPolicy, typename Layout, typename Counting>
+DisjointSets<FindPolicy, UnionPolicy, Layout, Counting>::DisjointSets(std::uint32_t size) :
+    m_size{size},
+    m_popIndex{0},
+    m_pushIndex{0}
+{
+    m_free.resize(size);
+    for (std::uint32_t i = 0; i < size; i++) {
+        m_free[i] = i;
+    }
+    m_storage.resize(size);
+}
+
+template <typename FindPolicy, typename UnionPolicy, typename Layout, typename Counting>
+std::uint32_t DisjointSets<FindPolicy, UnionPolicy, Layout, Counting>::size() const
+{
+    return m_size;
+}
+
+template <typename FindPolicy, typename UnionPolicy, typename Layout, typename Counting>
+inline std::uint32_t DisjointSets<FindPolicy, UnionPolicy, Layout, Counting>::get(
+    std::uint32_t value)
+{
+    Counting::get();
+    return FindPolicy::template find<Counting>(m_storage, value);
+}
+
+template <typename FindPolicy, typename UnionPolicy, typename Layout, typename Counting>
+inline void DisjointSets<FindPolicy, UnionPolicy, Layout, Counting>::join(
+    std::uint32_t &value1, std::uint32_t &value2)
+{
+    Counting::join();
+    if (UnionPolicy::keepSecond(m_storage, value1, value2)) {
+        std::swap(value1, value2);
+    }
+    m_free[m_pushIndex++] = value2;
+    if (m_pushIndex == m_size) {
+        m_pushIndex = 0;
+    }
+    m_storage.parent(value2) = value1;
+    m_storage.degree(value1) += m_storage.degree(value2);
+}
+
+template <typename FindPolicy, typename UnionPolicy, typename Layout, typename Counting>
+inline std::uint32_t DisjointSets<FindPolicy, UnionPolicy, Layout, Counting>::pop(
+    std::uint32_t degree)
+{
+    Counting::pop();
+    std::uint32_t value = m_free[m_popIndex++];
+    if (m_popIndex == m_size) {
+        m_popIndex = 0;
+    }
+    m_storage.parent(value) = value;
+    m_storage.degree(value) = degree;
+    if (UnionPolicy::usesRank) {
+        m_storage.rank(value) = 0;
+    }
+    return value;
+}
+
+template <typename FindPolicy, typename UnionPolicy, typename Layout, typename Counting>
+inline std::uint32_t &DisjointSets<FindPolicy, UnionPolicy, Layout, Counting>::degree(
+    std::uint32_t value)
+{
+    return m_storage.degree(value);
+}
+
+template <typename FindPolicy, typename UnionPolicy, typename Layout, typename Counting>
+bool DisjointSets<FindPolicy, UnionPolicy, Layout, Counting>::save(std::ostream &stream) const
+{
+    std::uint32_t header[3] = {m_size, m_popIndex, m_pushIndex};
+    if (!Utilities::writeUint32s(stream, header, 3) ||
+        !Utilities::writeUint32s(stream, m_free.data(), m_size))
+    {
+        return false;
+    }
+    std::vector<std::uint32_t> values(m_size);
+    for (std::uint32_t field = 0; field < (UnionPolicy::usesRank ? 3 : 2); field++) {
+        for (std::uint32_t k = 0; k < m_size; k++) {
+            values[k] = field == 0 ? m_storage.parent(k) :
+                field == 1 ? m_storage.degree(k) : m_storage.rank(k);
+        }
+        if (!Utilities::writeUint32s(stream, values.data(), m_size)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+template <typename FindPolicy, typename UnionPolicy, typename Layout, typename Counting>
+bool DisjointSets<FindPolicy, UnionPolicy, Layout, Counting>::load(std::istream &stream)
+{
+    std::uint32_t header[3];
+    if (!Utilities::readUint32s(stream, header, 3) || header[1] >= std::max(header[0], 1u) ||
+        header[2] >= std::max(header[0], 1u))
+    {
+        return false;
+    }
+    std::vector<std::uint32_t> free(header[0]);
+    std::vector<std::uint32_t> values(header[0]);
+    if (!Utilities::readUint32s(stream, free.data(), header[0])) {
+        return false;
+    }
+    Storage storage;
+    storage.resize(header[0]);
+    for (std::uint32_t field = 0; field < (UnionPolicy::usesRank ? 3 : 2); field++) {
+        if (!Utilities::readUint32s(stream, values.data(), header[0])) {
+            return false;
+        }
+        for (std::uint32_t k = 0; k < header[0]; k++) {
+            if (field == 0 && (values[k] >= header[0] || free[k] >= header[0])) {
+                return false;
+            }
+            (field == 0 ? storage.parent(k) : field == 1 ? storage.degree(k) : storage.rank(k)) =
+                values[k];
+        }
+    }
+    m_size = header[0];
+    m_popIndex = header[1];
+    m_pushIndex = header[2];
+    m_free = std::move(free);
+    m_storage = std::move(storage);
+    return true;
+}
+
+inline std::uint32_t DisjointSetForest::find(std::vector<std::uint32_t> &parents, std::uint32_t value)
+{
+    while (value != parents[value]) {
+        parents[value] = parents[parents[value]];
+        value = parents[value];
+    }
+    return value;
+}
+
+inline std::uint32_t DisjointSetForest::join(std::vector<std::uint32_t> &parents,
+    std::uint32_t root1, std::uint32_t root2)
+{
+    if (root2 < root1) {
+        std::swap(root1, root2);
+    }
+    parents[root2] = root1;
+    return root1;
+}
+
+inline std::uint32_t DisjointSetForest::number(std::vector<std::uint32_t> &parents)
+{
+    // Each link points to a smaller element, which has already been numbered.
+    std::uint32_t count = 0;
+    for (std::uint32_t k = 0; k < parents.size(); k++) {
+        parents[k] = parents[k] == k ? count++ : parents[parents[k]];
+    }
+    return count;
+}
+
+#endif
\ No newline at end of file
@@ -0,0 +1,614 @@
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <map>
+#include <algorithm>
+#include <sstream>
+#include <fstream>
+#include <iostream>
+#include <chrono>
+#include <stdexcept>
+#include <JobRunner.h>
+#include <Utilities.h>
+#include <Metrics.h>
+#include <LMZFile.h>
+#include <TiledMaze.h>
+#include <ProceduralMaze.h>
+
+namespace {
+
+    std::uint64_t parseUnsigned(std::string const &text)
+    {
+        std::size_t length;
+        std::uint64_t value = std::stoull(text, &length);
+        if (length != text.size() || text[0] == '-') {
+            throw std::invalid_argument(text);
+        }
+        return value;
+    }
+
+    // Comma-separated unsigned integers.
+    std::vector<std::uint64_t> parseList(std::string const &text)
+    {
+        std::vector<std::uint64_t> values;
+        std::stringstream stream(text);
+        std::string item;
+        while (std::getline(stream, item, ',')) {
+            values.push_back(parseUnsigned(item));
+        }
+        return values;
+    }
+
+    // Cell given as I,J.
+    void parseCell(std::string const &text, std::uint32_t &i, std::uint32_t &j)
+    {
+        std::vector<std::uint64_t> values = parseList(text);
+        if (values.size() != 2) {
+            throw std::invalid_argument(text);
+        }
+        i = static_cast<std::uint32_t>(values[0]);
+        j = static_cast<std::uint32_t>(values[1]);
+    }
+
+    std::string option(std::map<std::string, std::string> const &options,
+        std::string const &key, std::string const &defaultValue)
+    {
+        auto found = options.find(key);
+        return found == options.end() ? defaultValue : found->second;
+    }
+
+}
+
+JobRunner::JobRunner() :
+    m_lineNumber{0}
+{}
+
+bool JobRunner::fail(std::string const &message) const
+{
+    std::cerr << "Line " << m_lineNumber << ": " << message << "\n";
+    return false;
+}
+
+Path const *JobRunner::path(std::string const &name) const
+{
+    auto found = m_paths.find(name);
+    return found == m_paths.end() ? nullptr : &found->second;
+}
+
+Maze const *JobRunner::maze(std::string const &name) const
+{
+    auto found = m_mazes.find(name);
+    return found == m_mazes.end() ? nullptr : &found->second;
+}
+
+bool JobRunner::newPath(Job const &job)
+{
+    if (job.names.size() != 1) {
+        return fail("expected: path NAME options");
+    }
+    std::string const &name = job.names[0];
+    std::string fileName = option(job.options, "file", "");
+    Path path;
+    if (!fileName.empty()) {
+        path = Path(fileName);
+        if (path.getHeight() == 1 && path.getWidth() == 1) {
+            return fail("could not read path file " + fileName);
+        }
+    }
+    else {
+        std::uint32_t height = parseUnsigned(option(job.options, "height", "0"));
+        std::uint32_t width = parseUnsigned(option(job.options, "width", "0"));
+        if (height == 0 || width == 0) {
+            return fail("path height and width must be given");
+        }
+        std::uint32_t i1 = 0;
+        std::uint32_t j1 = 0;
+        std::uint32_t i2 = height - 1;
+        std::uint32_t j2 = width - 1;
+        parseCell(option(job.options, "from", "0,0"), i1, j1);
+        if (job.options.count("to") != 0) {
+            parseCell(job.options.at("to"), i2, j2);
+        }
+        if (i1 >= height || i2 >= height || j1 >= width || j2 >= width) {
+            return fail("path cells outside of the table");
+        }
+        std::vector<std::uint64_t> persistency =
+            parseList(option(job.options, "persistency", "0,0"));
+        if (persistency.size() != 2) {
+            return fail("expected persistency=COUNT,STRENGTH");
+        }
+        std::int32_t seed = std::stoi(option(job.options, "seed", "0"));
+        path = Path(height, width, seed, i1, j1, i2, j2,
+            static_cast<std::uint16_t>(persistency[0]),
+            static_cast<std::uint16_t>(persistency[1]));
+    }
+    std::cout << "path " << name << ": " << path.getHeight() << " x " << path.getWidth() <<
+        ", length " << path.length();
+    m_paths.insert_or_assign(name, std::move(path));
+    return true;
+}
+
+bool JobRunner::newMaze(Job const &job)
+{
+    if (job.names.size() != 1) {
+        return fail("expected: maze NAME options");
+    }
+    std::string const &name = job.names[0];
+    std::string fileName = option(job.options, "file", "");
+    if (!fileName.empty()) {
+        std::uint32_t threadCount = parseUnsigned(option(job.options, "threads", "0"));
+        std::vector<std::uint64_t> region = parseList(option(job.options, "region", "0,0,0,0"));
+        if (region.size() != 4) {
+            return fail("expected region=I,J,H,W");
+        }
+        Maze maze = job.options.count("region") != 0 ?
+            Maze(LMZFile(fileName), static_cast<std::uint32_t>(region[0]),
+                static_cast<std::uint32_t>(region[1]), static_cast<std::uint32_t>(region[2]),
+                static_cast<std::uint32_t>(region[3]), threadCount) :
+            LMZFile::isLMZ(fileName) ? Maze(LMZFile(fileName), threadCount) : Maze(fileName);
+        if (maze.getHeight() == 1 && maze.getWidth() == 1) {
+            return fail("could not read maze file " + fileName);
+        }
+        std::cout << "maze " << name << ": " << maze.getHeight() << " x " << maze.getWidth();
+        m_mazes.insert_or_assign(name, std::move(maze));
+        return true;
+    }
+    Path emptyPath;
+    Path const *path = &emptyPath;
+    if (job.options.count("path") != 0) {
+        path = this->path(job.options.at("path"));
+        if (path == nullptr) {
+            return fail("unknown path " + job.options.at("path"));
+        }
+    }
+    else {
+        std::uint32_t height = parseUnsigned(option(job.options, "height", "0"));
+        std::uint32_t width = parseUnsigned(option(job.options, "width", "0"));
+        if (height == 0 || width == 0) {
+            return fail("maze path or height and width must be given");
+        }
+        emptyPath = Path(height, width, 0, 0, Path::Directions());
+    }
+    std::int32_t seed = std::stoi(option(job.options, "seed", "0"));
+    std::uint32_t threadCount = parseUnsigned(option(job.options, "threads", "0"));
+    bool tree = job.options.count("density") == 0;
+    if (tree) {
+        std::vector<std::uint64_t> values =
+            parseList(option(job.options, "probabilities", "163,118,123,123,94,103"));
+        if (values.size() != 6) {
+            return fail("expected six probabilities");
+        }
+        std::vector<std::uint8_t> probabilitySet(values.begin(), values.end());
+        if (job.options.count("checkpoints") != 0) {
+            return newProceduralMaze(job, *path, seed, probabilitySet);
+        }
+        std::uint32_t stripCount = parseUnsigned(option(job.options, "strips", "1"));
+        m_mazes.insert_or_assign(name,
+            Maze(*path, seed, probabilitySet, stripCount, threadCount));
+    }
+    else {
+        std::uint16_t density = parseUnsigned(job.options.at("density"));
+        m_mazes.insert_or_assign(name, Maze(*path, seed, density, threadCount));
+    }
+    std::cout << "maze " << name << ": " << path->getHeight() << " x " << path->getWidth() <<
+        (tree ? " tree" : " density");
+    return true;
+}
+
+bool JobRunner::newProceduralMaze(Job const &job, Path const &path, std::int32_t seed,
+    std::vector<std::uint8_t> const &probabilitySet)
+{
+    std::string const &name = job.names[0];
+    std::uint32_t checkpointInterval = parseUnsigned(job.options.at("checkpoints"));
+    if (checkpointInterval == 0) {
+        return fail("expected checkpoints=K with K > 0");
+    }
+    std::vector<std::uint64_t> region = parseList(option(job.options, "region", ""));
+    if (region.size() != 4) {
+        return fail("expected region=I,J,H,W");
+    }
+    if (region[2] == 0 || region[3] == 0 || region[0] + region[2] > path.getHeight() ||
+        region[1] + region[3] > path.getWidth())
+    {
+        return fail("region outside of the maze");
+    }
+    ProceduralMaze procedural(path, seed, probabilitySet, checkpointInterval,
+        option(job.options, "resume", ""));
+    Maze maze(procedural, static_cast<std::uint32_t>(region[0]),
+        static_cast<std::uint32_t>(region[1]), static_cast<std::uint32_t>(region[2]),
+        static_cast<std::uint32_t>(region[3]));
+    ProceduralMaze::Statistics const &statistics = procedural.getStatistics();
+    std::cout << "maze " << name << ": " << maze.getHeight() << " x " << maze.getWidth() <<
+        " region of " << path.getHeight() << " x " << path.getWidth() << " tree, " <<
+        procedural.checkpointCount() << " checkpoints (" << procedural.checkpointBytes() <<
+        " bytes), " << statistics.generatedRows << " rows generated";
+    m_mazes.insert_or_assign(name, std::move(maze));
+    return true;
+}
+
+bool JobRunner::solve(Job const &job)
+{
+    if (job.options.count("file") != 0) {
+        return solveTiled(job);
+    }
+    if (job.names.size() != 2) {
+        return fail("expected: solve NAME MAZE options");
+    }
+    Maze const *maze = this->maze(job.names[1]);
+    if (maze == nullptr) {
+        return fail("unknown maze " + job.names[1]);
+    }
+    if (job.options.count("from") == 0 || job.options.count("to") == 0) {
+        return fail("solve cells must be given with from=I,J and to=I,J");
+    }
+    std::uint32_t i1;
+    std::uint32_t j1;
+    std::uint32_t i2;
+    std::uint32_t j2;
+    parseCell(job.options.at("from"), i1, j1);
+    parseCell(job.options.at("to"), i2, j2);
+    if (i1 >= maze->getHeight() || i2 >= maze->getHeight() ||
+        j1 >= maze->getWidth() || j2 >= maze->getWidth())
+    {
+        return fail("solve cells outside of the maze");
+    }
+    std::string algorithm = option(job.options, "algorithm", "astar");
+    MazeSolver::Statistics statistics;
+    Path path;
+    if (algorithm == "left") {
+        path = maze->solve(i1, j1, i2, j2, &statistics);
+    }
+    else if (algorithm == "bfs") {
+        path = maze->solveShortest(i1, j1, i2, j2, 0, &statistics);
+    }
+    else if (algorithm == "astar") {
+        path = maze->solveAStar(i1, j1, i2, j2, &statistics);
+    }
+    else {
+        return fail("unknown algorithm " + algorithm);
+    }
+    bool solved = path.length() != 0 || (i1 == i2 && j1 == j2);
+    std::cout << "solve " << job.names[0] << ": ";
+    if (solved) {
+        std::cout << "length " << path.length();
+    }
+    else {
+        std::cout << "no solution";
+    }
+    std::cout << ", " << statistics.expandedCells << " cells expanded";
+    m_paths.insert_or_assign(job.names[0], std::move(path));
+    return true;
+}
+
+bool JobRunner::solveTiled(Job const &job)
+{
+    if (job.names.size() != 1) {
+        return fail("expected: solve NAME file=FILE options");
+    }
+    std::string const &fileName = job.options.at("file");
+    std::uint64_t cacheBytes = static_cast<std::uint64_t>(
+        parseUnsigned(option(job.options, "cache", "64"))) << 20;
+    TiledMaze maze(fileName, cacheBytes);
+    if (!maze.isOpen()) {
+        return fail("could not read tiled maze file " + fileName);
+    }
+    if (job.options.count("from") == 0 || job.options.count("to") == 0) {
+        return fail("solve cells must be given with from=I,J and to=I,J");
+    }
+    std::uint32_t i1;
+    std::uint32_t j1;
+    std::uint32_t i2;
+    std::uint32_t j2;
+    parseCell(job.options.at("from"), i1, j1);
+    parseCell(job.options.at("to"), i2, j2);
+    if (i1 >= maze.getHeight() || i2 >= maze.getHeight() ||
+        j1 >= maze.getWidth() || j2 >= maze.getWidth())
+    {
+        return fail("solve cells outside of the maze");
+    }
+    std::string algorithm = option(job.options, "algorithm", "astar");
+    MazeSolver::Statistics statistics;
+    Path path;
+    if (algorithm == "left") {
+        path = maze.solve(i1, j1, i2, j2, &statistics);
+    }
+    else if (algorithm == "astar") {
+        path = maze.solveAStar(i1, j1, i2, j2, &statistics);
+    }
+    else {
+        return fail("unknown algorithm " + algorithm);
+    }
+    bool solved = path.length() != 0 || (i1 == i2 && j1 == j2);
+    std::cout << "solve " << job.names[0] << ": ";
+    if (solved) {
+        std::cout << "length " << path.length();
+    }
+    else {
+        std::cout << "no solution";
+    }
+    TiledMaze::CacheStatistics const &cache = maze.getStatistics();
+    std::cout << ", " << statistics.expandedCells << " cells expanded, " <<
+        cache.misses << " tiles read (" << cache.bytesRead << " bytes, " <<
+        cache.prefetches << " prefetched), hit rate " << cache.hitRate() << " in " <<
+        maze.getCacheCapacity() << " cached tiles";
+    m_paths.insert_or_assign(job.names[0], std::move(path));
+    return true;
+}
+
+bool JobRunner::queries(Job const &job)
+{
+    if (job.names.size() != 1) {
+        return fail("expected: queries MAZE options");
+    }
+    Maze const *maze = this->maze(job.names[0]);
+    if (maze == nullptr) {
+        return fail("unknown maze " + job.names[0]);
+    }
+    std::vector<MazeSolver::Query> queries;
+    if (job.options.count("file") != 0) {
+        std::ifstream file(job.options.at("file"));
+        if (!file) {
+            return fail("could not read query file " + job.options.at("file"));
+        }
+        MazeSolver::Query query;
+        while (file >> query.i1 >> query.j1 >> query.i2 >> query.j2) {
+            queries.push_back(query);
+        }
+        if (!file.eof()) {
+            return fail("invalid query " + std::to_string(queries.size() + 1));
+        }
+    }
+    else if (job.options.count("random") != 0) {
+        std::uint64_t count = parseUnsigned(job.options.at("random"));
+        std::int32_t seed = std::stoi(option(job.options, "seed", "0"));
+        queries.resize(count);
+        for (MazeSolver::Query &query : queries) {
+            query.i1 = Utilities::randUint32(seed) % maze->getHeight();
+            query.j1 = Utilities::randUint32(seed) % maze->getWidth();
+            query.i2 = Utilities::randUint32(seed) % maze->getHeight();
+            query.j2 = Utilities::randUint32(seed) % maze->getWidth();
+        }
+    }
+    else {
+        return fail("queries must be given with file=FILE or random=COUNT");
+    }
+    for (MazeSolver::Query const &query : queries) {
+        if (query.i1 >= maze->getHeight() || query.i2 >= maze->getHeight() ||
+            query.j1 >= maze->getWidth() || query.j2 >= maze->getWidth())
+        {
+            return fail("query cells outside of the maze");
+        }
+    }
+    std::string algorithm = option(job.options, "algorithm", "astar");
+    if (algorithm != "left" && algorithm != "astar") {
+        return fail("unknown algorithm " + algorithm);
+    }
+    std::vector<MazeSolver::Summary> summaries = maze->solveBatchSummaries(queries,
+        algorithm == "left" ? MazeSolver::WallFollower : MazeSolver::BidirectionalAStar);
+    std::uint64_t solvedCount = 0;
+    std::uint64_t totalLength = 0;
+    for (MazeSolver::Summary const &summary : summaries) {
+        if (summary.solved) {
+            solvedCount++;
+            totalLength += summary.length;
+        }
+    }
+    std::string outputFileName = option(job.options, "output", "");
+    if (!outputFileName.empty()) {
+        std::ofstream file(outputFileName);
+        for (std::uint64_t k = 0; k < queries.size() && file; k++) {
+            MazeSolver::Query const &query = queries[k];
+            file << query.i1 << ' ' << query.j1 << ' ' << query.i2 << ' ' << query.j2 << ' ';
+            if (summaries[k].solved) {
+                file << summaries[k].length << ' ' << summaries[k].integral << '\n';
+            }
+            else {
+                file << "-\n";
+            }
+        }
+        file.close();
+        if (!file) {
+            return fail("could not write " + outputFileName);
+        }
+    }
+    std::cout << "queries " << job.names[0] << ": " << solvedCount << " of " <<
+        queries.size() << " solved, total length " << totalLength;
+    return true;
+}
+
+bool JobRunner::save(Job const &job)
+{
+    if (job.names.size() != 2) {
+        return fail("expected: save NAME FILE");
+    }
+    std::string const &name = job.names[0];
+    std::string const &fileName = job.names[1];
+    bool saved;
+    if (Maze const *maze = this->maze(name)) {
+        std::uint32_t tileSize = parseUnsigned(
+            option(job.options, "tile", std::to_string(LMZFile::defaultTileSize)));
+        saved = LMZFile::hasExtension(fileName) ? maze->toLMZ(fileName, tileSize) : maze->toBMP(fileName);
+    }
+    else if (Path const *path = this->path(name)) {
+        saved = path->toBMP(fileName);
+    }
+    else {
+        return fail("unknown path or maze " + name);
+    }
+    if (!saved) {
+        return fail("could not write " + fileName);
+    }
+    std::cout << "save " << name << ": " << fileName;
+    return true;
+}
+
+bool JobRunner::stats(Job const &job)
+{
+    if (job.names.size() != 1) {
+        return fail("expected: stats PATH");
+    }
+    Path const *path = this->path(job.names[0]);
+    if (path == nullptr) {
+        return fail("unknown path " + job.names[0]);
+    }
+    Path::Statistics statistics = path->stats();
+    std::cout << "stats " << job.names[0] << ": length " << path->length() <<
+        ", integral " << statistics.integral <<
+        ", rows " << statistics.minRow << " - " << statistics.maxRow <<
+        ", columns " << statistics.minColumn << " - " << statistics.maxColumn <<
+        ", turns " << statistics.leftTurns << " left " << statistics.rightTurns << " right";
+    return true;
+}
+
+bool JobRunner::components(Job const &job)
+{
+    if (job.names.size() != 1) {
+        return fail("expected: components MAZE");
+    }
+    Maze const *maze = this->maze(job.names[0]);
+    if (maze == nullptr) {
+        return fail("unknown maze " + job.names[0]);
+    }
+    std::uint32_t threadCount = parseUnsigned(option(job.options, "threads", "0"));
+    Maze::Components components = maze->components(threadCount);
+    if (components.labels.empty()) {
+        return fail("maze " + job.names[0] + " has too many cells for components");
+    }
+    std::uint64_t largest = 0;
+    std::uint64_t isolatedCells = 0;
+    for (Maze::Components::Component const &component : components.components) {
+        largest = std::max(largest, component.size);
+        if (component.size == 1) {
+            isolatedCells++;
+        }
+    }
+    std::cout << "components " << job.names[0] << ": " << components.components.size() <<
+        " components, largest " << largest << " cells, " << isolatedCells << " isolated cells";
+    return true;
+}
+
+bool JobRunner::drop(Job const &job)
+{
+    if (job.names.size() != 1) {
+        return fail("expected: drop NAME");
+    }
+    if (m_mazes.erase(job.names[0]) + m_paths.erase(job.names[0]) == 0) {
+        return fail("unknown path or maze " + job.names[0]);
+    }
+    std::cout << "drop " << job.names[0];
+    return true;
+}
+
+bool JobRunner::runJob(Job const &job)
+{
+    if (job.command == "path") {
+        return newPath(job);
+    }
+    if (job.command == "maze") {
+        return newMaze(job);
+    }
+    if (job.command == "solve") {
+        return solve(job);
+    }
+    if (job.command == "queries") {
+        return queries(job);
+    }
+    if (job.command == "save") {
+        return save(job);
+    }
+    if (job.command == "stats") {
+        return stats(job);
+    }
+    if (job.command == "components") {
+        return components(job);
+    }
+    if (job.command == "drop") {
+        return drop(job);
+    }
+    return fail("unknown command " + job.command);
+}
+
+bool JobRunner::runLine(std::string const &line)
+{
+    m_lineNumber++;
+    std::stringstream stream(line);
+    Job job;
+    if (!(stream >> job.command) || job.command[0] == '#') {
+        return true;
+    }
+    std::string word;
+    while (stream >> word) {
+        std::size_t separator = word.find('=');
+        if (separator == std::string::npos) {
+            job.names.push_back(word);
+        }
+        else {
+            job.options[word.substr(0, separator)] = word.substr(separator + 1);
+        }
+    }
+    Metrics::reset();
+    auto t1 = std::chrono::high_resolution_clock::now();
+    bool succeeded;
+    try {
+        succeeded = runJob(job);
+    }
+    catch (std::logic_error const &) {
+        std::cout << std::flush;
+        return fail("invalid number");
+    }
+    auto t2 = std::chrono::high_resolution_clock::now();
+    auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(t2 - t1);
+    if (succeeded) {
+        std::cout << " (" << duration.count() << " ms)\n";
+        if (Metrics::enabled) {
+            std::cout << "metrics: " << Metrics::toJSON() << "\n";
+        }
+    }
+    return succeeded;
+}
+
+bool JobRunner::run(std::istream &jobs)
+{
+    m_lineNumber = 0;
+    std::string line;
+    while (std::getline(jobs, line)) {
+        if (!runLine(line)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool JobRunner::runFile(std::string const &fileName)
+{
+    std::ifstream file(fileName);
+    if (!file) {
+        std::cerr << "Could not read job file " << fileName << "\n";
+        return false;
+    }
+    return run(file);
+}
+
+bool JobRunner::runArguments(int argc, char **argv)
+{
+    JobRunner runner;
+    for (int k = 1; k < argc; k += 2) {
+        std::string argument = argv[k];
+        if (k + 1 == argc || (argument != "--job" && argument != "--exec")) {
+            std::cerr << "Usage: Main [--job FILE | --exec LINE] ...\n";
+            return false;
+        }
+        if (argument == "--job") {
+            if (!runner.runFile(argv[k + 1])) {
+                return false;
+            }
+        }
+        else {
+            runner.m_lineNumber = 0;
+            if (!runner.runLine(argv[k + 1])) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
\ No newline at end of file
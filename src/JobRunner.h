@@ -0,0 +1,121 @@
+#ifndef JOBRUNNER_H
+#define JOBRUNNER_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <map>
+#include <istream>
+#include <Path.h>
+#include <Maze.h>
+
+// Non-interactive runner of jobs, which keeps named paths and mazes in memory
+// between jobs, so that later jobs use them without saving and reloading BMP files.
+// Each job is one line of whitespace-separated words: a command, names, and options
+// of the form key=value. Empty lines and lines starting with # are ignored.
+// Commands:
+//   path NAME height=H width=W [seed=S] [from=I,J] [to=I,J] [persistency=COUNT,STRENGTH]
+//       random path, from the upper left to the lower right corner by default
+//   path NAME file=FILE
+//       load path from a BMP file
+//   maze NAME (path=PATH | height=H width=W) [seed=S] [density=D]
+//       [probabilities=P1,P2,P3,P4,P5,P6] [strips=N] [threads=N]
+//       tree maze with given path inside, or a maze with given wall density
+//   maze NAME (path=PATH | height=H width=W) [seed=S] [probabilities=P1,P2,P3,P4,P5,P6]
+//       checkpoints=K region=I,J,H,W [resume=FILE]
+//       only the region of size H x W with upper left cell (I, J) of a tree maze, generated
+//       from generator checkpoints saved every K rows (see ProceduralMaze); checkpoints are
+//       also written to FILE, and generation resumes from it if it was interrupted
+//   maze NAME file=FILE [region=I,J,H,W] [threads=N]
+//       load maze from a BMP file or a tiled maze file (see LMZFile),
+//       or only the region of size H x W with upper left cell (I, J) from a tiled maze file
+//   solve NAME MAZE from=I,J to=I,J [algorithm=left|bfs|astar]
+//       solve a maze and keep the solution as path NAME
+//   solve NAME file=FILE from=I,J to=I,J [algorithm=left|astar] [cache=MB]
+//       solve a maze in a tiled maze file without loading it (see TiledMaze), with a cache
+//       of decoded tiles of about MB megabytes (64 by default), and print cache statistics
+//   queries MAZE (file=FILE | random=COUNT [seed=S]) [algorithm=left|astar] [output=FILE]
+//       solve a batch of queries from a query file (see Commands::solveQueries)
+//       or between random cells, and optionally save the results
+//   save NAME FILE [tile=SIZE]
+//       save path or maze NAME as a BMP file, or maze NAME as a tiled maze file
+//       with tiles of SIZE x SIZE cells if FILE ends with .lmz
+//   stats PATH
+//       print length, integral, bounding box and turns of a path
+//   components MAZE [threads=N]
+//       print the number of connected components of a maze and the largest one
+//   drop NAME
+//       release path or maze NAME
+// After each job, its result and duration are printed to standard output, followed
+// by its counters and phase timings as JSON if built with LAMASO_METRICS.
+class JobRunner {
+
+    // Parsed job line.
+    struct Job {
+        std::string command;
+        std::vector<std::string> names;
+        std::map<std::string, std::string> options;
+    };
+
+    std::map<std::string, Path> m_paths;
+
+    std::map<std::string, Maze> m_mazes;
+
+    // Number of job lines read so far.
+    std::uint64_t m_lineNumber;
+
+    bool newPath(Job const &job);
+
+    bool newMaze(Job const &job);
+
+    // Tree maze region of a procedural maze, for newMaze with checkpoints=K.
+    bool newProceduralMaze(Job const &job, Path const &path, std::int32_t seed,
+        std::vector<std::uint8_t> const &probabilitySet);
+
+    bool solve(Job const &job);
+
+    bool solveTiled(Job const &job);
+
+    bool queries(Job const &job);
+
+    bool save(Job const &job);
+
+    bool stats(Job const &job);
+
+    bool components(Job const &job);
+
+    bool drop(Job const &job);
+
+    // Run a parsed job and print its result, without timing.
+    bool runJob(Job const &job);
+
+    // Print an error message for the current line and return false.
+    bool fail(std::string const &message) const;
+
+public:
+
+    JobRunner();
+
+    // Run jobs, one per line, until the end of the stream or the first failing job.
+    // Return false if a job failed.
+    bool run(std::istream &jobs);
+
+    // As run, reading jobs from a file. Return false if the file could not be read.
+    bool runFile(std::string const &fileName);
+
+    // Run one job line and print its result and duration. Return false if the job failed.
+    bool runLine(std::string const &line);
+
+    // Path or maze of given name, or nullptr if there is none.
+    Path const *path(std::string const &name) const;
+
+    Maze const *maze(std::string const &name) const;
+
+    // Run jobs given by command-line arguments: --job FILE runs a job file
+    // and --exec LINE runs one job line, in the given order, with shared names.
+    // Return false if the arguments are invalid or a job failed.
+    static bool runArguments(int argc, char **argv);
+
+};
+
+#endif
\ No newline at end of file
@@ -0,0 +1,348 @@
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <fstream>
+#include <utility>
+#include <algorithm>
+#include <Utilities.h>
+#include <MappedFile.h>
+#include <BitPlanes.h>
+#include <Metrics.h>
+#include <LMZFile.h>
+
+namespace {
+
+    char const signature[4] = {'L', 'M', 'Z', '1'};
+
+    std::uint64_t readLittleEndian(char const *bytes, std::uint32_t size)
+    {
+        std::uint64_t value = 0;
+        for (std::uint32_t k = size; k-- > 0;) {
+            value = (value << 8) | static_cast<std::uint8_t>(bytes[k]);
+        }
+        return value;
+    }
+
+    void writeLittleEndian(std::uint64_t value, std::uint32_t size, char *bytes)
+    {
+        for (std::uint32_t k = 0; k < size; k++) {
+            bytes[k] = char(value >> (k << 3));
+        }
+    }
+
+}
+
+LMZFile::LMZFile(std::string const &fileName) :
+    m_height{1},
+    m_width{1},
+    m_tileHeight{defaultTileSize},
+    m_tileWidth{defaultTileSize}
+{
+    MappedFile file(fileName);
+    if (!file.isOpen() || file.size() < headerSize ||
+        std::memcmp(file.data(), signature, sizeof(signature)) != 0)
+    {
+        return;
+    }
+    char const *header = file.data();
+    std::uint32_t height = static_cast<std::uint32_t>(readLittleEndian(header + 4, 4));
+    std::uint32_t width = static_cast<std::uint32_t>(readLittleEndian(header + 8, 4));
+    std::uint32_t tileHeight = static_cast<std::uint32_t>(readLittleEndian(header + 12, 4));
+    std::uint32_t tileWidth = static_cast<std::uint32_t>(readLittleEndian(header + 16, 4));
+    if (height == 0 || width == 0 || tileHeight == 0 || tileHeight > maxTileSize ||
+        tileWidth == 0 || tileWidth > maxTileSize || (tileWidth & 63) != 0)
+    {
+        return;
+    }
+    MazeParameters parameters;
+    std::uint8_t generator = static_cast<std::uint8_t>(header[20]);
+    if (generator > MazeParameters::Tree) {
+        return;
+    }
+    parameters.generator = static_cast<MazeParameters::Generator>(generator);
+    parameters.density = static_cast<std::uint16_t>(readLittleEndian(header + 22, 2));
+    parameters.seed = static_cast<std::int32_t>(readLittleEndian(header + 24, 4));
+    if (parameters.generator == MazeParameters::Tree) {
+        parameters.probabilitySet.assign(header + 28, header + 34);
+    }
+    parameters.stripCount = static_cast<std::uint32_t>(readLittleEndian(header + 36, 4));
+    std::uint64_t tileCount = ((static_cast<std::uint64_t>(height) + tileHeight - 1) / tileHeight) *
+        ((static_cast<std::uint64_t>(width) + tileWidth - 1) / tileWidth);
+    if ((file.size() - headerSize) / indexEntrySize < tileCount) {
+        return;
+    }
+    std::vector<TileEntry> tiles(tileCount);
+    for (std::uint64_t k = 0; k < tileCount; k++) {
+        char const *entry = header + headerSize + k * indexEntrySize;
+        tiles[k].offset = readLittleEndian(entry, 8);
+        tiles[k].size = static_cast<std::uint32_t>(readLittleEndian(entry + 8, 4));
+        tiles[k].codec = static_cast<Codec>(entry[12]);
+        if (tiles[k].codec > RunLength || tiles[k].offset > file.size() ||
+            tiles[k].size > file.size() - tiles[k].offset)
+        {
+            return;
+        }
+    }
+    m_height = height;
+    m_width = width;
+    m_tileHeight = tileHeight;
+    m_tileWidth = tileWidth;
+    m_parameters = std::move(parameters);
+    m_file = std::move(file);
+    m_tiles = std::move(tiles);
+}
+
+bool LMZFile::isOpen() const
+{
+    return m_file.isOpen();
+}
+
+bool LMZFile::readTile(std::uint32_t tileRow, std::uint32_t tileColumn, std::uint64_t *words) const
+{
+    if (!isOpen()) {
+        return false;
+    }
+    Metrics::PhaseTimer timer(Metrics::Load);
+    TileEntry const &tile = m_tiles[static_cast<std::uint64_t>(tileRow) * tileColumns() + tileColumn];
+    std::uint64_t wordCount = tileWords(tileRow);
+    std::uint8_t const *code = reinterpret_cast<std::uint8_t const *>(m_file.data() + tile.offset);
+    std::uint8_t *bytes = reinterpret_cast<std::uint8_t *>(words);
+    if (tile.codec == Raw) {
+        if (tile.size != wordCount << 3) {
+            return false;
+        }
+        std::memcpy(bytes, code, tile.size);
+    }
+    else if (!decodeRunLength(code, tile.size, bytes, wordCount << 3)) {
+        return false;
+    }
+    for (std::uint64_t k = 0; k < wordCount; k++) {
+        words[k] = readLittleEndian(reinterpret_cast<char const *>(bytes + (k << 3)), 8);
+    }
+    return true;
+}
+
+void LMZFile::prefetchTile(std::uint32_t tileRow, std::uint32_t tileColumn) const
+{
+    if (isOpen()) {
+        TileEntry const &tile = m_tiles[static_cast<std::uint64_t>(tileRow) * tileColumns() + tileColumn];
+        m_file.prefetch(tile.offset, tile.size);
+    }
+}
+
+bool LMZFile::isLMZ(std::string const &fileName)
+{
+    std::ifstream file(fileName, std::ios::binary);
+    char bytes[sizeof(signature)];
+    return file.read(bytes, sizeof(bytes)) && std::memcmp(bytes, signature, sizeof(signature)) == 0;
+}
+
+bool LMZFile::hasExtension(std::string const &fileName)
+{
+    return fileName.size() >= 4 && fileName.compare(fileName.size() - 4, 4, ".lmz") == 0;
+}
+
+LMZFile::Writer::Writer() :
+    m_height{0},
+    m_width{0},
+    m_tileSize{0},
+    m_threadCount{0},
+    m_tileRow{0},
+    m_offset{0}
+{}
+
+bool LMZFile::Writer::begin(std::string const &fileName, std::uint32_t height, std::uint32_t width,
+    MazeParameters const &parameters, std::uint32_t tileSize, std::uint32_t threadCount)
+{
+    Metrics::PhaseTimer timer(Metrics::Write);
+    m_height = height;
+    m_width = width;
+    m_tileSize = (std::clamp<std::uint32_t>(tileSize, 1, maxTileSize) + 63) & ~63u;
+    m_threadCount = threadCount;
+    m_tileRow = 0;
+    m_index.assign(static_cast<std::uint64_t>(tileRows()) * tileColumns() * indexEntrySize, 0);
+    m_offset = headerSize + m_index.size();
+    m_file.open(fileName, std::ios::binary);
+    if (!m_file) {
+        return false;
+    }
+    char header[headerSize] = {};
+    std::memcpy(header, signature, sizeof(signature));
+    writeLittleEndian(m_height, 4, header + 4);
+    writeLittleEndian(m_width, 4, header + 8);
+    writeLittleEndian(m_tileSize, 4, header + 12);
+    writeLittleEndian(m_tileSize, 4, header + 16);
+    header[20] = char(parameters.generator);
+    writeLittleEndian(parameters.density, 2, header + 22);
+    writeLittleEndian(static_cast<std::uint32_t>(parameters.seed), 4, header + 24);
+    for (std::uint32_t k = 0; k < 6 && k < parameters.probabilitySet.size(); k++) {
+        header[28 + k] = char(parameters.probabilitySet[k]);
+    }
+    writeLittleEndian(parameters.stripCount, 4, header + 36);
+    return m_file.write(header, headerSize) && m_file.write(m_index.data(), m_index.size());
+}
+
+std::uint32_t LMZFile::Writer::getTileSize() const
+{
+    return m_tileSize;
+}
+
+std::uint32_t LMZFile::Writer::tileRows() const
+{
+    return static_cast<std::uint32_t>((static_cast<std::uint64_t>(m_height) + m_tileSize - 1) /
+        m_tileSize);
+}
+
+std::uint32_t LMZFile::Writer::tileColumns() const
+{
+    return static_cast<std::uint32_t>((static_cast<std::uint64_t>(m_width) + m_tileSize - 1) /
+        m_tileSize);
+}
+
+std::uint32_t LMZFile::Writer::nextTileRowHeight() const
+{
+    return std::min(m_tileSize, m_height - m_tileRow * m_tileSize);
+}
+
+bool LMZFile::Writer::writeTileRow(BitPlanes const &walls,
+    std::uint32_t verticalPlane, std::uint32_t horizontalPlane, std::uint32_t firstRow)
+{
+    std::uint32_t tileColumns = this->tileColumns();
+    std::uint32_t tileRowWords = m_tileSize >> 6;
+    std::uint32_t usedRowWords = walls.getUsedRowWords();
+    std::uint32_t rowEnd = firstRow + nextTileRowHeight();
+    m_codes.resize(tileColumns);
+    {
+        Metrics::PhaseTimer timer(Metrics::Encode);
+        Utilities::parallelFor(tileColumns, 1, m_threadCount,
+            [&](std::uint64_t begin, std::uint64_t end) {
+                std::vector<std::uint8_t> raw;
+                for (std::uint64_t c = begin; c < end; c++) {
+                    raw.assign(static_cast<std::uint64_t>(rowEnd - firstRow) * tileRowWords << 4, 0);
+                    std::uint8_t *bytes = raw.data();
+                    for (std::uint32_t i = firstRow; i < rowEnd; i++) {
+                        for (std::uint32_t plane : {verticalPlane, horizontalPlane}) {
+                            std::uint64_t const *row = walls.row(i, plane);
+                            for (std::uint64_t w = c * tileRowWords; w < (c + 1) * tileRowWords; w++) {
+                                std::uint64_t word = w < usedRowWords ? row[w] : 0;
+                                writeLittleEndian(word, 8, reinterpret_cast<char *>(bytes));
+                                bytes += 8;
+                            }
+                        }
+                    }
+                    TileCode &code = m_codes[c];
+                    code.bytes.clear();
+                    encodeRunLength(raw.data(), raw.size(), code.bytes);
+                    code.codec = RunLength;
+                    if (code.bytes.size() >= raw.size()) {
+                        code.bytes.swap(raw);
+                        code.codec = Raw;
+                    }
+                }
+            });
+    }
+    Metrics::PhaseTimer timer(Metrics::Write);
+    for (std::uint32_t c = 0; c < tileColumns; c++) {
+        char *entry = m_index.data() + (static_cast<std::uint64_t>(m_tileRow) * tileColumns + c) *
+            indexEntrySize;
+        writeLittleEndian(m_offset, 8, entry);
+        writeLittleEndian(m_codes[c].bytes.size(), 4, entry + 8);
+        entry[12] = char(m_codes[c].codec);
+        if (!m_file.write(reinterpret_cast<char const *>(m_codes[c].bytes.data()),
+            m_codes[c].bytes.size()))
+        {
+            return false;
+        }
+        m_offset += m_codes[c].bytes.size();
+    }
+    m_tileRow++;
+    return true;
+}
+
+bool LMZFile::Writer::end()
+{
+    Metrics::PhaseTimer timer(Metrics::Write);
+    if (m_tileRow != tileRows()) {
+        return false;
+    }
+    m_file.seekp(headerSize);
+    m_file.write(m_index.data(), m_index.size());
+    m_file.close();
+    return !m_file.fail();
+}
+
+bool LMZFile::write(std::string const &fileName, BitPlanes const &walls,
+    std::uint32_t verticalPlane, std::uint32_t horizontalPlane,
+    MazeParameters const &parameters, std::uint32_t tileSize, std::uint32_t threadCount)
+{
+    Writer writer;
+    if (!writer.begin(fileName, walls.getHeight(), walls.getWidth(), parameters, tileSize,
+        threadCount))
+    {
+        return false;
+    }
+    for (std::uint32_t i = 0; i < walls.getHeight(); i += writer.getTileSize()) {
+        if (!writer.writeTileRow(walls, verticalPlane, horizontalPlane, i)) {
+            return false;
+        }
+    }
+    return writer.end();
+}
+
+void LMZFile::encodeRunLength(std::uint8_t const *bytes, std::uint64_t size,
+    std::vector<std::uint8_t> &code)
+{
+    std::uint64_t k = 0;
+    while (k < size) {
+        std::uint64_t run = 1;
+        while (k + run < size && run < 130 && bytes[k + run] == bytes[k]) {
+            run++;
+        }
+        if (run >= 3) {
+            code.push_back(static_cast<std::uint8_t>(run + 125));
+            code.push_back(bytes[k]);
+            k += run;
+            continue;
+        }
+        // Literal bytes up to the next run of at least 3 equal bytes.
+        std::uint64_t literalEnd = k + 1;
+        while (literalEnd < size && literalEnd - k < 128 &&
+            !(literalEnd + 2 < size && bytes[literalEnd] == bytes[literalEnd + 1] &&
+                bytes[literalEnd] == bytes[literalEnd + 2]))
+        {
+            literalEnd++;
+        }
+        code.push_back(static_cast<std::uint8_t>(literalEnd - k - 1));
+        code.insert(code.end(), bytes + k, bytes + literalEnd);
+        k = literalEnd;
+    }
+}
+
+bool LMZFile::decodeRunLength(std::uint8_t const *code, std::uint64_t codeSize,
+    std::uint8_t *bytes, std::uint64_t size)
+{
+    std::uint64_t k = 0;
+    std::uint64_t position = 0;
+    while (k < codeSize) {
+        std::uint32_t control = code[k++];
+        if (control < 128) {
+            std::uint64_t count = control + 1;
+            if (count > codeSize - k || count > size - position) {
+                return false;
+            }
+            std::memcpy(bytes + position, code + k, count);
+            k += count;
+            position += count;
+        }
+        else {
+            std::uint64_t count = control - 125;
+            if (k == codeSize || count > size - position) {
+                return false;
+            }
+            std::memset(bytes + position, code[k++], count);
+            position += count;
+        }
+    }
+    return position == size;
+}
\ No newline at end of file
@@ -0,0 +1,250 @@
+#ifndef LMZFILE_H
+#define LMZFILE_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <fstream>
+#include <algorithm>
+#include <MappedFile.h>
+#include <BitPlanes.h>
+#include <MazeParameters.h>
+
+// Maze stored in a memory-mapped tiled maze file (.lmz), from which single tiles
+// can be decoded without reading the rest of the file.
+// File layout, with all numbers little-endian:
+//   header (48 bytes):
+//     0  "LMZ1"
+//     4  uint32 height, uint32 width
+//     12 uint32 tile height, uint32 tile width (a multiple of 64)
+//     20 uint8 generator, uint8 0, uint16 density, int32 seed (see MazeParameters)
+//     28 uint8[6] probability set, uint16 0, uint32 strip count
+//     40 uint64 0
+//   tile index: for each tile row by row, uint64 offset, uint32 size, uint8 codec, uint8[3] 0
+//   tiles: data of each tile, coded on its own by the codec given in the index.
+// Tiles cover tile height rows and tile width columns (fewer in the last tile row).
+// A decoded tile holds, for each of its rows, tile width / 64 words of vertical walls
+// and then tile width / 64 words of horizontal walls of the row (see Maze::verticalWalls
+// and Maze::horizontalWalls), with bits past the maze width cleared. Each word is stored
+// as 8 bytes, lowest byte first.
+class LMZFile {
+
+public:
+
+    // Tile codecs.
+    enum Codec : std::uint8_t {
+        // Decoded bytes as they are.
+        Raw,
+        // Runs of equal bytes and literal bytes (see encodeRunLength).
+        RunLength
+    };
+
+private:
+
+    struct TileEntry {
+        std::uint64_t offset;
+        std::uint32_t size;
+        Codec codec;
+    };
+
+    std::uint32_t m_height;
+    std::uint32_t m_width;
+    std::uint32_t m_tileHeight;
+    std::uint32_t m_tileWidth;
+
+    MazeParameters m_parameters;
+
+    // Mapped file.
+    MappedFile m_file;
+
+    // Tile index, tile rows first.
+    std::vector<TileEntry> m_tiles;
+
+public:
+
+    static constexpr std::uint32_t headerSize = 48;
+
+    static constexpr std::uint32_t indexEntrySize = 16;
+
+    static constexpr std::uint32_t defaultTileSize = 256;
+
+    // Maximum tile height and tile width.
+    static constexpr std::uint32_t maxTileSize = 4096;
+
+    // Map a tiled maze file and read its header and tile index.
+    // Return 1 x 1 maze with no tiles if could not read file.
+    LMZFile(std::string const &fileName);
+
+    // Return true if the file has been mapped and its header and index are valid.
+    bool isOpen() const;
+
+    std::uint32_t getHeight() const;
+
+    std::uint32_t getWidth() const;
+
+    std::uint32_t getTileHeight() const;
+
+    std::uint32_t getTileWidth() const;
+
+    // Generator parameters stored in the header.
+    MazeParameters const &getParameters() const;
+
+    // Number of tile rows and tile columns.
+    std::uint32_t tileRows() const;
+
+    std::uint32_t tileColumns() const;
+
+    // Number of maze rows covered by tiles in the given tile row.
+    std::uint32_t tileRowHeight(std::uint32_t tileRow) const;
+
+    // Number of 64-bit words of a decoded tile in the given tile row.
+    std::uint64_t tileWords(std::uint32_t tileRow) const;
+
+    // Number of stored (coded) bytes of a tile.
+    std::uint32_t tileBytes(std::uint32_t tileRow, std::uint32_t tileColumn) const;
+
+    // Decode a tile into tileWords(tileRow) words. Return false if the tile is corrupt.
+    bool readTile(std::uint32_t tileRow, std::uint32_t tileColumn, std::uint64_t *words) const;
+
+    // Ask the operating system to read the coded bytes of a tile in the background.
+    void prefetchTile(std::uint32_t tileRow, std::uint32_t tileColumn) const;
+
+    // Return true if the file starts with the tiled maze file signature.
+    static bool isLMZ(std::string const &fileName);
+
+    // Return true if the file name ends with ".lmz".
+    static bool hasExtension(std::string const &fileName);
+
+    // Writer of a tiled maze file one tile row at a time, so that the whole maze
+    // need not be in memory. Tiles are square.
+    class Writer {
+
+        struct TileCode {
+            std::vector<std::uint8_t> bytes;
+            Codec codec;
+        };
+
+        std::uint32_t m_height;
+        std::uint32_t m_width;
+        std::uint32_t m_tileSize;
+        std::uint32_t m_threadCount;
+
+        // Number of tile rows written so far.
+        std::uint32_t m_tileRow;
+
+        // Offset of the next tile in the file.
+        std::uint64_t m_offset;
+
+        std::ofstream m_file;
+
+        // Tile index, written by end.
+        std::vector<char> m_index;
+
+        // Coded tiles of the last tile row.
+        std::vector<TileCode> m_codes;
+
+    public:
+
+        Writer();
+
+        // Create (or overwrite) a file for a maze of given size with tiles of tileSize
+        // rounded up to a multiple of 64 (at most maxTileSize), coded by up to threadCount
+        // threads (all hardware threads if threadCount = 0), and write its header.
+        // Return false if failed.
+        bool begin(std::string const &fileName, std::uint32_t height, std::uint32_t width,
+            MazeParameters const &parameters, std::uint32_t tileSize = defaultTileSize,
+            std::uint32_t threadCount = 0);
+
+        // Tile height and width.
+        std::uint32_t getTileSize() const;
+
+        std::uint32_t tileRows() const;
+
+        std::uint32_t tileColumns() const;
+
+        // Number of maze rows covered by the next tile row.
+        std::uint32_t nextTileRowHeight() const;
+
+        // Code the next tile row from nextTileRowHeight() rows of planes verticalPlane
+        // and horizontalPlane of walls starting at row firstRow, and write it.
+        // Each tile is coded with the shorter of the codecs. Return false if failed.
+        bool writeTileRow(BitPlanes const &walls, std::uint32_t verticalPlane,
+            std::uint32_t horizontalPlane, std::uint32_t firstRow);
+
+        // Write the tile index after all tile rows. Return false if failed.
+        bool end();
+
+    };
+
+    // Write planes verticalPlane and horizontalPlane of walls (see MazeRowSink::writeRow)
+    // as a tiled maze file with square tiles of tileSize rounded up to a multiple of 64
+    // (at most maxTileSize) using Writer. Return false if failed.
+    static bool write(std::string const &fileName, BitPlanes const &walls,
+        std::uint32_t verticalPlane, std::uint32_t horizontalPlane,
+        MazeParameters const &parameters, std::uint32_t tileSize = defaultTileSize,
+        std::uint32_t threadCount = 0);
+
+    // Append run-length code of bytes to code: a control byte c < 128 is followed by
+    // c + 1 literal bytes, and a control byte c >= 128 by one byte repeated c - 125 times.
+    static void encodeRunLength(std::uint8_t const *bytes, std::uint64_t size,
+        std::vector<std::uint8_t> &code);
+
+    // Decode run-length code into exactly size bytes. Return false if the code is corrupt.
+    static bool decodeRunLength(std::uint8_t const *code, std::uint64_t codeSize,
+        std::uint8_t *bytes, std::uint64_t size);
+
+};
+
+inline std::uint32_t LMZFile::getHeight() const
+{
+    return m_height;
+}
+
+inline std::uint32_t LMZFile::getWidth() const
+{
+    return m_width;
+}
+
+inline std::uint32_t LMZFile::getTileHeight() const
+{
+    return m_tileHeight;
+}
+
+inline std::uint32_t LMZFile::getTileWidth() const
+{
+    return m_tileWidth;
+}
+
+inline MazeParameters const &LMZFile::getParameters() const
+{
+    return m_parameters;
+}
+
+inline std::uint32_t LMZFile::tileRows() const
+{
+    return static_cast<std::uint32_t>((static_cast<std::uint64_t>(m_height) + m_tileHeight - 1) /
+        m_tileHeight);
+}
+
+inline std::uint32_t LMZFile::tileColumns() const
+{
+    return static_cast<std::uint32_t>((static_cast<std::uint64_t>(m_width) + m_tileWidth - 1) /
+        m_tileWidth);
+}
+
+inline std::uint32_t LMZFile::tileRowHeight(std::uint32_t tileRow) const
+{
+    return std::min(m_tileHeight, m_height - tileRow * m_tileHeight);
+}
+
+inline std::uint64_t LMZFile::tileWords(std::uint32_t tileRow) const
+{
+    return static_cast<std::uint64_t>(tileRowHeight(tileRow)) * (m_tileWidth >> 5);
+}
+
+inline std::uint32_t LMZFile::tileBytes(std::uint32_t tileRow, std::uint32_t tileColumn) const
+{
+    return m_tiles[static_cast<std::uint64_t>(tileRow) * tileColumns() + tileColumn].size;
+}
+
+#endif
\ No newline at end of file
@@ -0,0 +1,52 @@
+#include <cstdint>
+#include <string>
+#include <algorithm>
+#include <BitPlanes.h>
+#include <LMZFile.h>
+#include <LMZMazeRowSink.h>
+
+LMZMazeRowSink::LMZMazeRowSink(std::string const &fileName, MazeParameters const &parameters,
+    std::uint32_t tileSize, std::uint32_t threadCount) :
+    m_fileName{fileName},
+    m_parameters{parameters},
+    m_tileSize{tileSize},
+    m_threadCount{threadCount},
+    m_rowCount{0},
+    m_bandRowCount{0}
+{}
+
+bool LMZMazeRowSink::begin(std::uint32_t height, std::uint32_t width)
+{
+    if (!m_writer.begin(m_fileName, height, width, m_parameters, m_tileSize, m_threadCount)) {
+        return false;
+    }
+    m_band = BitPlanes(std::min(m_writer.getTileSize(), height), width, 2);
+    m_rowCount = 0;
+    m_bandRowCount = 0;
+    return true;
+}
+
+bool LMZMazeRowSink::writeRow(std::uint64_t const *verticalWalls,
+    std::uint64_t const *horizontalWalls)
+{
+    std::uint32_t words = m_band.getUsedRowWords();
+    std::copy_n(verticalWalls, words, m_band.row(m_bandRowCount, 0));
+    if (m_rowCount == 0) {
+        std::fill_n(m_band.row(m_bandRowCount, 1), words, 0);
+    }
+    else {
+        std::copy_n(horizontalWalls, words, m_band.row(m_bandRowCount, 1));
+    }
+    m_rowCount++;
+    m_bandRowCount++;
+    if (m_bandRowCount == m_writer.nextTileRowHeight()) {
+        m_bandRowCount = 0;
+        return m_writer.writeTileRow(m_band, 0, 1, 0);
+    }
+    return true;
+}
+
+bool LMZMazeRowSink::end()
+{
+    return m_writer.end();
+}
\ No newline at end of file
@@ -0,0 +1,48 @@
+#ifndef LMZMAZEROWSINK_H
+#define LMZMAZEROWSINK_H
+
+#include <cstdint>
+#include <string>
+#include <TreeMazeGenerator.h>
+#include <BitPlanes.h>
+#include <MazeParameters.h>
+#include <LMZFile.h>
+
+// Maze row sink writing a tiled maze file (see LMZFile), which keeps only one tile row
+// of the maze in memory, so that mazes larger than the memory can be generated.
+class LMZMazeRowSink : public MazeRowSink {
+
+    // Output file name.
+    std::string m_fileName;
+
+    MazeParameters m_parameters;
+
+    std::uint32_t m_tileSize;
+
+    std::uint32_t m_threadCount;
+
+    LMZFile::Writer m_writer;
+
+    // Rows of the current tile row, with planes 0 (vertical walls) and 1 (horizontal walls).
+    BitPlanes m_band;
+
+    // Number of rows received so far, and of them in the current tile row.
+    std::uint32_t m_rowCount;
+    std::uint32_t m_bandRowCount;
+
+public:
+
+    // Sink writing tiles of given size (see LMZFile::Writer::begin) and generator parameters.
+    LMZMazeRowSink(std::string const &fileName, MazeParameters const &parameters,
+        std::uint32_t tileSize = LMZFile::defaultTileSize, std::uint32_t threadCount = 0);
+
+    bool begin(std::uint32_t height, std::uint32_t width) override;
+
+    bool writeRow(std::uint64_t const *verticalWalls,
+        std::uint64_t const *horizontalWalls) override;
+
+    bool end() override;
+
+};
+
+#endif
\ No newline at end of file
@@ -1,9 +1,13 @@
 #include <iostream>
 #include <string>
 #include <Commands.h>
+#include <JobRunner.h>
 
-int main()
+int main(int argc, char **argv)
 {
+    if (argc > 1) {
+        return JobRunner::runArguments(argc, argv) ? 0 : 1;
+    }
     std::cout << "Lamaso 8.0\n\nJanez Ster\n\n";
     while (Commands::commandPrompt()) {}
     return 0;
@@ -0,0 +1,150 @@
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <algorithm>
+#include <MappedFile.h>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+MappedFile::MappedFile() :
+    m_data{nullptr},
+    m_size{0},
+    m_fileHandle{nullptr},
+    m_mappingHandle{nullptr}
+{}
+
+MappedFile::MappedFile(std::string const &fileName) :
+    MappedFile()
+{
+#ifdef _WIN32
+    HANDLE file = CreateFileA(fileName.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr,
+        OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+    if (file == INVALID_HANDLE_VALUE) {
+        return;
+    }
+    m_fileHandle = file;
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(file, &size) || size.QuadPart == 0) {
+        close();
+        return;
+    }
+    m_size = static_cast<std::uint64_t>(size.QuadPart);
+    HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (mapping == nullptr) {
+        close();
+        return;
+    }
+    m_mappingHandle = mapping;
+    m_data = static_cast<char const *>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+    if (m_data == nullptr) {
+        close();
+    }
+#else
+    int file = ::open(fileName.c_str(), O_RDONLY);
+    if (file < 0) {
+        return;
+    }
+    struct stat status;
+    if (fstat(file, &status) != 0 || status.st_size == 0) {
+        ::close(file);
+        return;
+    }
+    void *data = mmap(nullptr, status.st_size, PROT_READ, MAP_SHARED, file, 0);
+    ::close(file);
+    if (data == MAP_FAILED) {
+        return;
+    }
+    m_data = static_cast<char const *>(data);
+    m_size = static_cast<std::uint64_t>(status.st_size);
+#endif
+}
+
+MappedFile::MappedFile(MappedFile &&other) noexcept :
+    m_data{std::exchange(other.m_data, nullptr)},
+    m_size{std::exchange(other.m_size, 0)},
+    m_fileHandle{std::exchange(other.m_fileHandle, nullptr)},
+    m_mappingHandle{std::exchange(other.m_mappingHandle, nullptr)}
+{}
+
+MappedFile &MappedFile::operator=(MappedFile &&other) noexcept
+{
+    if (this != &other) {
+        close();
+        m_data = std::exchange(other.m_data, nullptr);
+        m_size = std::exchange(other.m_size, 0);
+        m_fileHandle = std::exchange(other.m_fileHandle, nullptr);
+        m_mappingHandle = std::exchange(other.m_mappingHandle, nullptr);
+    }
+    return *this;
+}
+
+MappedFile::~MappedFile()
+{
+    close();
+}
+
+void MappedFile::close()
+{
+#ifdef _WIN32
+    if (m_data != nullptr) {
+        UnmapViewOfFile(m_data);
+    }
+    if (m_mappingHandle != nullptr) {
+        CloseHandle(m_mappingHandle);
+    }
+    if (m_fileHandle != nullptr) {
+        CloseHandle(m_fileHandle);
+    }
+#else
+    if (m_data != nullptr) {
+        munmap(const_cast<char *>(m_data), m_size);
+    }
+#endif
+    m_data = nullptr;
+    m_size = 0;
+    m_fileHandle = nullptr;
+    m_mappingHandle = nullptr;
+}
+
+bool MappedFile::isOpen() const
+{
+    return m_data != nullptr;
+}
+
+char const *MappedFile::data() const
+{
+    return m_data;
+}
+
+std::uint64_t MappedFile::size() const
+{
+    return m_size;
+}
+
+void MappedFile::prefetch(std::uint64_t offset, std::uint64_t size) const
+{
+    if (m_data == nullptr || offset >= m_size || size == 0) {
+        return;
+    }
+    size = std::min(size, m_size - offset);
+#ifdef _WIN32
+#if _WIN32_WINNT >= 0x0602
+    WIN32_MEMORY_RANGE_ENTRY range;
+    range.VirtualAddress = const_cast<char *>(m_data + offset);
+    range.NumberOfBytes = static_cast<SIZE_T>(size);
+    PrefetchVirtualMemory(GetCurrentProcess(), 1, &range, 0);
+#endif
+#else
+    // madvise needs a page-aligned start address.
+    std::uint64_t pageSize = static_cast<std::uint64_t>(sysconf(_SC_PAGESIZE));
+    std::uint64_t begin = offset & ~(pageSize - 1);
+    madvise(const_cast<char *>(m_data + begin), offset + size - begin, MADV_WILLNEED);
+#endif
+}
\ No newline at end of file
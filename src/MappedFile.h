@@ -0,0 +1,55 @@
+#ifndef MAPPEDFILE_H
+#define MAPPEDFILE_H
+
+#include <cstdint>
+#include <string>
+
+// Read-only memory mapping of a whole file.
+class MappedFile {
+
+    // Mapped file contents, or nullptr if not mapped.
+    char const *m_data;
+
+    // File size in bytes.
+    std::uint64_t m_size;
+
+    // Operating system handles of the file and of the mapping.
+    void *m_fileHandle;
+    void *m_mappingHandle;
+
+    void close();
+
+public:
+
+    // Empty mapping.
+    MappedFile();
+
+    // Map given file. Result is empty if failed.
+    MappedFile(std::string const &fileName);
+
+    MappedFile(MappedFile const &) = delete;
+
+    MappedFile(MappedFile &&other) noexcept;
+
+    MappedFile &operator=(MappedFile const &) = delete;
+
+    MappedFile &operator=(MappedFile &&other) noexcept;
+
+    ~MappedFile();
+
+    // Return true if the file is mapped.
+    bool isOpen() const;
+
+    // Mapped file contents.
+    char const *data() const;
+
+    // File size in bytes.
+    std::uint64_t size() const;
+
+    // Ask the operating system to start reading given bytes of the file in the background,
+    // so that they are in memory when accessed. Does nothing if not supported.
+    void prefetch(std::uint64_t offset, std::uint64_t size) const;
+
+};
+
+#endif
\ No newline at end of file
@@ -0,0 +1,77 @@
+#include <cstdint>
+#include <string>
+#include <fstream>
+#include <utility>
+#include <algorithm>
+#include <Utilities.h>
+#include <MappedFile.h>
+#include <MazeImage.h>
+#include <MazeSolver.h>
+#include <MappedMaze.h>
+
+MappedMaze::MappedMaze(std::string const &fileName) :
+    m_height{1},
+    m_width{1},
+    m_image{nullptr},
+    m_bmpWidthBytes{0},
+    m_topDown{false}
+{
+    std::int32_t widthBMP;
+    std::int32_t heightBMP;
+    {
+        std::ifstream file;
+        if (!Utilities::readBMP(fileName, widthBMP, heightBMP, file)) {
+            return;
+        }
+    }
+    bool topDown = heightBMP < 0;
+    if (topDown) {
+        heightBMP = -heightBMP;
+    }
+    if ((heightBMP & 1) == 0 || (widthBMP & 1) == 0) {
+        return;
+    }
+    std::uint32_t bmpWidthBytes = (((widthBMP - 1) >> 5) + 1) << 2;
+    MappedFile file(fileName);
+    if (!file.isOpen() ||
+        file.size() < 14 + 40 + 8 + static_cast<std::uint64_t>(heightBMP) * bmpWidthBytes)
+    {
+        return;
+    }
+    m_height = heightBMP >> 1;
+    m_width = widthBMP >> 1;
+    m_file = std::move(file);
+    m_image = m_file.data() + 14 + 40 + 8;
+    m_bmpWidthBytes = bmpWidthBytes;
+    m_topDown = topDown;
+}
+
+bool MappedMaze::isOpen() const
+{
+    return m_image != nullptr;
+}
+
+void MappedMaze::decodeRow(std::uint32_t i, std::uint64_t *scratch,
+    std::uint64_t *verticalWalls, std::uint64_t *horizontalWalls) const
+{
+    if (!isOpen()) {
+        std::fill_n(verticalWalls, (m_width + 63) >> 6, 0);
+        std::fill_n(horizontalWalls, (m_width + 63) >> 6, 0);
+        return;
+    }
+    MazeImage::decodeRows(m_width, i == 0,
+        bmpRow(static_cast<std::uint64_t>(i) << 1), bmpRow((static_cast<std::uint64_t>(i) << 1) + 1),
+        scratch, verticalWalls, horizontalWalls);
+}
+
+Path MappedMaze::solve(std::uint32_t i1, std::uint32_t j1,
+    std::uint32_t i2, std::uint32_t j2, MazeSolver::Statistics *statistics) const
+{
+    return MazeSolver::wallFollower(*this, i1, j1, i2, j2, statistics);
+}
+
+Path MappedMaze::solveAStar(std::uint32_t i1, std::uint32_t j1,
+    std::uint32_t i2, std::uint32_t j2, MazeSolver::Statistics *statistics) const
+{
+    return MazeSolver::pagedBidirectionalAStar(*this, i1, j1, i2, j2, statistics);
+}
\ No newline at end of file
@@ -0,0 +1,115 @@
+#ifndef MAPPEDMAZE_H
+#define MAPPEDMAZE_H
+
+#include <cstdint>
+#include <string>
+#include <MappedFile.h>
+#include <Path.h>
+#include <MazeSolver.h>
+
+// Maze stored in a memory-mapped BMP file (in the format of Maze::toBMP).
+// Walls are decoded from the image on demand, so that queries can start
+// as soon as the file is mapped.
+class MappedMaze {
+
+    // Height.
+    std::uint32_t m_height;
+
+    // Width.
+    std::uint32_t m_width;
+
+    // Mapped BMP file.
+    MappedFile m_file;
+
+    // First byte of image data.
+    char const *m_image;
+
+    // Number of bytes in a BMP row.
+    std::uint32_t m_bmpWidthBytes;
+
+    // True if BMP rows are stored from top to bottom.
+    bool m_topDown;
+
+    // The y-th BMP row, counted from the top.
+    char const *bmpRow(std::uint64_t y) const;
+
+    // Return true if pixel x of a BMP row is black.
+    static bool isBlack(char const *bmpRow, std::uint64_t x);
+
+public:
+
+    // Map maze from a BMP file. Return 1 x 1 maze if could not read file.
+    MappedMaze(std::string const &fileName);
+
+    // Return true if the file has been mapped successfully.
+    bool isOpen() const;
+
+    std::uint32_t getHeight() const;
+
+    std::uint32_t getWidth() const;
+
+    // Return true if the (i, j)-th cell cannot be left toward given direction,
+    // either because of a wall or because of the maze border.
+    bool hasWall(std::uint32_t i, std::uint32_t j, Path::Direction direction) const;
+
+    // Decode walls of the i-th row into verticalWalls and horizontalWalls
+    // (see Maze::verticalWalls and Maze::horizontalWalls),
+    // overwriting their first (width + 63) / 64 words. Scratch must hold
+    // MazeImage::scratchWords(width) words, and may be reused between calls.
+    void decodeRow(std::uint32_t i, std::uint64_t *scratch,
+        std::uint64_t *verticalWalls, std::uint64_t *horizontalWalls) const;
+
+    // Find path between given cells using "always turn left" algoritm (see Maze::solve).
+    Path solve(std::uint32_t i1, std::uint32_t j1, std::uint32_t i2, std::uint32_t j2,
+        MazeSolver::Statistics *statistics = nullptr) const;
+
+    // Find a shortest path between given cells using bidirectional A* search
+    // (see Maze::solveAStar), decoding only walls of the expanded cells. The search state
+    // is kept only for pages of cells it reaches (see MazeSolver::pagedBidirectionalAStar),
+    // so memory follows the number of expanded cells, not the maze size.
+    Path solveAStar(std::uint32_t i1, std::uint32_t j1, std::uint32_t i2, std::uint32_t j2,
+        MazeSolver::Statistics *statistics = nullptr) const;
+
+};
+
+inline char const *MappedMaze::bmpRow(std::uint64_t y) const
+{
+    std::uint64_t bmpHeight = (static_cast<std::uint64_t>(m_height) << 1) + 1;
+    return m_image + (m_topDown ? y : bmpHeight - 1 - y) * m_bmpWidthBytes;
+}
+
+inline bool MappedMaze::isBlack(char const *bmpRow, std::uint64_t x)
+{
+    return (bmpRow[x >> 3] & (1 << (7 - (x & 7)))) == 0;
+}
+
+inline std::uint32_t MappedMaze::getHeight() const
+{
+    return m_height;
+}
+
+inline std::uint32_t MappedMaze::getWidth() const
+{
+    return m_width;
+}
+
+inline bool MappedMaze::hasWall(std::uint32_t i, std::uint32_t j,
+    Path::Direction direction) const
+{
+    switch (direction) {
+        case Path::Up:
+            return i == 0 || isBlack(bmpRow(static_cast<std::uint64_t>(i) << 1),
+                (static_cast<std::uint64_t>(j) << 1) + 1);
+        case Path::Down:
+            return i == m_height - 1 || isBlack(bmpRow((static_cast<std::uint64_t>(i) + 1) << 1),
+                (static_cast<std::uint64_t>(j) << 1) + 1);
+        case Path::Left:
+            return j == 0 || isBlack(bmpRow((static_cast<std::uint64_t>(i) << 1) + 1),
+                static_cast<std::uint64_t>(j) << 1);
+        default:
+            return j == m_width - 1 || isBlack(bmpRow((static_cast<std::uint64_t>(i) << 1) + 1),
+                (static_cast<std::uint64_t>(j) + 1) << 1);
+    }
+}
+
+#endif
\ No newline at end of file
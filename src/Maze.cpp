@@ -1,367 +1,372 @@
 #include <cstdint>
 #include <vector>
-#include <utility>
 #include <string>
 #include <fstream>
+#include <algorithm>
+#include <atomic>
 #include <Utilities.h>
 #include <Path.h>
+#include <MazeImage.h>
+#include <TreeMazeGenerator.h>
+#include <MappedMaze.h>
+#include <LMZFile.h>
+#include <ProceduralMaze.h>
+#include <BMPBandWriter.h>
+#include <MazeParameters.h>
+#include <MazeSolver.h>
+#include <Metrics.h>
+#include <DisjointSets.h>
 #include <Maze.h>
 
-std::uint32_t Maze::getHeight() const
-{
-    return m_height;
-}
+namespace {
 
-std::uint32_t Maze::getWidth() const
-{
-    return m_width;
-}
+// Provisional labels of cells in a horizontal strip of a maze.
+struct StripLabels {
+
+    // Parent links of disjoint sets of labels (see DisjointSetForest).
+    std::vector<std::uint32_t> parents;
+
+    // Number of cells and bounding box of the cells with each label.
+    std::vector<Maze::Components::Component> cells;
 
-Maze::Maze(std::string const &fileName)
+};
+
+// Label cells of rows [begin, end) of a maze, ignoring walls above the first row, storing
+// the label of the (i, j)-th cell as labels[i * width + j]. Each run of cells connected
+// horizontally gets the label of the first cell above it connected to it, or a new label
+// if there is none. Labels are numbered from 0 in the order of their first runs, and
+// labels of runs connected through the row above are joined.
+StripLabels labelStrip(Maze const &maze,
+    std::uint32_t begin, std::uint32_t end, std::uint32_t *labels)
 {
-    m_height = 1;
-    m_width = 1;
-    m_horizontalWalls = {{false}};
-    m_verticalWalls = {{false}};
-    std::int32_t widthBMP;
-    std::int32_t heightBMP;
-    std::ifstream file;
-    if (!Utilities::readBMP(fileName, widthBMP, heightBMP, file)) {
-        return;
-    }
-    std::uint32_t bmpWidthBytes = (((widthBMP - 1) >> 5) + 1) << 2;    
-    if ((heightBMP & 1) == 0 || (widthBMP & 1) == 0 || !file.ignore(bmpWidthBytes)) {
-        return;
-    }
-    m_height = heightBMP >> 1;
-    m_width = widthBMP >> 1;
-    m_horizontalWalls.resize(m_height);
-    m_verticalWalls.resize(m_height);
-    for (std::uint32_t i = 0; i < m_height; i++) {
-        m_horizontalWalls[i] = std::vector<bool>(m_width, false);
-        m_verticalWalls[i] = std::vector<bool>(m_width, false);
-    }
-    char *row1 = new char[bmpWidthBytes];
-    char *row2 = new char[bmpWidthBytes];
-    for (std::uint32_t i = m_height; i > 0; i--) {
-        if (!file.read(row2, bmpWidthBytes) || !file.read(row1, bmpWidthBytes)) {
-            delete[] row1;
-            delete[] row2;
-            m_height = 1;
-            m_width = 1;
-            m_horizontalWalls = {{false}};
-            m_verticalWalls = {{false}};
-            return;
-        }
-        for (std::uint32_t j = 0; j < m_width; j++) {
-            m_horizontalWalls[i - 1][j] =
-                (row1[j >> 2] & (1 << (6 - ((j & 3) << 1)))) == 0 && i != 1;
-            m_verticalWalls[i - 1][j] =
-                (row2[j >> 2] & (1 << (7 - ((j & 3) << 1)))) == 0 && j != 0;
+    StripLabels strip;
+    std::uint32_t width = maze.getWidth();
+    std::uint32_t rowWords = (width + 63) >> 6;
+    std::uint64_t lastWordMask = (width & 63) == 0 ?
+        ~static_cast<std::uint64_t>(0) : (static_cast<std::uint64_t>(1) << (width & 63)) - 1;
+    for (std::uint32_t i = begin; i < end; i++) {
+        std::uint64_t const *verticalWalls = maze.verticalWalls(i);
+        std::uint64_t const *horizontalWalls = maze.horizontalWalls(i);
+        std::uint64_t const *aboveVerticalWalls = i == begin ? nullptr : maze.verticalWalls(i - 1);
+        std::uint32_t *row = labels + static_cast<std::uint64_t>(i) * width;
+        std::uint32_t const *aboveRow = row - width;
+        std::uint32_t runBegin = 0;
+        std::uint32_t label = 0;
+        bool labelled = false;
+        // Give the run [runBegin, runEnd) a new label if it has none yet, and store it.
+        auto finishRun = [&](std::uint32_t runEnd) {
+            if (!labelled) {
+                label = static_cast<std::uint32_t>(strip.parents.size());
+                strip.parents.push_back(label);
+                strip.cells.push_back({0, i, i, runBegin, runEnd - 1});
+            }
+            std::fill(row + runBegin, row + runEnd, label);
+            Maze::Components::Component &cells = strip.cells[label];
+            cells.size += runEnd - runBegin;
+            cells.maxRow = i;
+            cells.minColumn = std::min(cells.minColumn, runBegin);
+            cells.maxColumn = std::max(cells.maxColumn, runEnd - 1);
+        };
+        std::uint64_t previousOpen = 0;
+        for (std::uint32_t w = 0; w < rowWords; w++) {
+            std::uint64_t mask = w == rowWords - 1 ? lastWordMask : ~static_cast<std::uint64_t>(0);
+            // Cells starting runs, with the first run already started.
+            std::uint64_t runStarts = verticalWalls[w] & mask;
+            if (w == 0) {
+                runStarts &= ~static_cast<std::uint64_t>(1);
+            }
+            // Cells connected to the cell above, and those of them which need a join:
+            // the others are connected to it also through the cells left to them.
+            std::uint64_t open = i == begin ? 0 : ~horizontalWalls[w] & mask;
+            std::uint64_t joins = open;
+            if (i != begin) {
+                joins &= ~(((open << 1) | previousOpen) & ~aboveVerticalWalls[w] & ~runStarts);
+                previousOpen = open >> 63;
+            }
+            for (std::uint64_t events = runStarts | joins; events != 0; events &= events - 1) {
+                std::uint32_t bit = BitPlanes::trailingZeros(events);
+                std::uint32_t j = (w << 6) + bit;
+                if ((runStarts >> bit) & 1) {
+                    finishRun(j);
+                    runBegin = j;
+                    labelled = false;
+                }
+                if ((joins >> bit) & 1) {
+                    std::uint32_t aboveLabel = aboveRow[j];
+                    if (!labelled) {
+                        label = aboveLabel;
+                        labelled = true;
+                    }
+                    else if (aboveLabel != label) {
+                        std::uint32_t root = DisjointSetForest::find(strip.parents, label);
+                        std::uint32_t aboveRoot = DisjointSetForest::find(strip.parents, aboveLabel);
+                        if (root != aboveRoot) {
+                            DisjointSetForest::join(strip.parents, root, aboveRoot);
+                        }
+                    }
+                }
+            }
         }
+        finishRun(width);
     }
-    delete[] row1;
-    delete[] row2;
+    return strip;
 }
 
-Maze::Maze(Path const &path, std::int32_t seed, std::uint16_t density)
+// Set count bits of target starting at bit targetBit where bits of source
+// starting at bit sourceBit are set.
+void orBits(std::uint64_t const *source, std::uint64_t sourceBit,
+    std::uint64_t *target, std::uint64_t targetBit, std::uint64_t count)
 {
-    std::vector<std::vector<PathCell>> solutionCells = path.cells();
-    m_height = path.getHeight();
-    m_width = path.getWidth();
-    m_verticalWalls.resize(m_height);
-    m_horizontalWalls.resize(m_height);
-    for (std::uint32_t i = 0; i < m_height; i++) {
-        m_verticalWalls[i] = std::vector<bool>(m_width, false);
-        m_horizontalWalls[i] = std::vector<bool>(m_width, false);
-    }
-    for (std::uint32_t i = 0; i < m_height; i++) {
-        std::uint32_t nextSolutionCellIndex = 0;
-        std::uint32_t nextSolutionCellColumn = solutionCells[i].empty() ?
-            m_width : solutionCells[i][0].column;
-        for (std::uint32_t j = 0; j < m_width; j++) {
-            if (j == nextSolutionCellColumn) {
-                m_horizontalWalls[i][j] =
-                    i != 0 && !solutionCells[i][nextSolutionCellIndex].above &&
-                    Utilities::randUint8(seed) < density;
-                m_verticalWalls[i][j] =
-                    j != 0 && !solutionCells[i][nextSolutionCellIndex].left &&
-                    Utilities::randUint8(seed) < density;
-                nextSolutionCellIndex++;
-                nextSolutionCellColumn = nextSolutionCellIndex == solutionCells[i].size() ?
-                    m_width : solutionCells[i][nextSolutionCellIndex].column;
-            }
-            else {
-                m_horizontalWalls[i][j] = i != 0 && Utilities::randUint8(seed) < density;
-                m_verticalWalls[i][j] = j != 0 && Utilities::randUint8(seed) < density;
-            }
+    while (count != 0) {
+        std::uint32_t sourceShift = sourceBit & 63;
+        std::uint32_t targetShift = targetBit & 63;
+        std::uint32_t bitCount = static_cast<std::uint32_t>(std::min<std::uint64_t>(count,
+            64 - std::max(sourceShift, targetShift)));
+        std::uint64_t bits = source[sourceBit >> 6] >> sourceShift;
+        if (bitCount < 64) {
+            bits &= (static_cast<std::uint64_t>(1) << bitCount) - 1;
         }
+        target[targetBit >> 6] |= bits << targetShift;
+        sourceBit += bitCount;
+        targetBit += bitCount;
+        count -= bitCount;
     }
 }
 
-class Pool {
+// Return true if the region of given size with upper left cell (row, column)
+// is not empty and lies inside the maze of a tiled maze file.
+bool isInside(LMZFile const &file, std::uint32_t row, std::uint32_t column,
+    std::uint32_t height, std::uint32_t width)
+{
+    return file.isOpen() && height != 0 && width != 0 &&
+        static_cast<std::uint64_t>(row) + height <= file.getHeight() &&
+        static_cast<std::uint64_t>(column) + width <= file.getWidth();
+}
 
-    std::uint32_t m_size;
-    std::uint32_t m_popIndex;
-    std::uint32_t m_pushIndex;
-    std::vector<std::uint32_t> m_values;
-    std::vector<std::uint32_t> m_indices;
+// Return true if the region of given size with upper left cell (row, column)
+// is not empty and lies inside a procedural maze.
+bool isInside(ProceduralMaze const &maze, std::uint32_t row, std::uint32_t column,
+    std::uint32_t height, std::uint32_t width)
+{
+    return height != 0 && width != 0 &&
+        static_cast<std::uint64_t>(row) + height <= maze.getHeight() &&
+        static_cast<std::uint64_t>(column) + width <= maze.getWidth();
+}
 
-public:
+}
 
-    std::vector<std::uint32_t> degrees;
+std::uint32_t Maze::getHeight() const
+{
+    return m_height;
+}
 
-    Pool(std::uint32_t size) :
-        m_size{size},
-        m_popIndex{0},
-        m_pushIndex{0}
-    {
-        m_values.resize(size);
-        for (std::uint32_t i = 0; i < size; i++) {
-            m_values[i] = i;
-        }
-        m_indices.resize(size);
-        degrees.resize(size);
-    }
+std::uint32_t Maze::getWidth() const
+{
+    return m_width;
+}
 
-    std::uint32_t get(std::uint32_t value) const
-    {
-        while (value != m_indices[value]) {
-            value = m_indices[value];
-        }
-        return value;
-    }
+MazeParameters const &Maze::getParameters() const
+{
+    return m_parameters;
+}
 
-    void join(std::uint32_t &value1, std::uint32_t &value2)
-    {
-        if (degrees[value1] < degrees[value2]) {
-            std::swap(value1, value2);
-        }
-        m_values[m_pushIndex++] = value2;
-        if (m_pushIndex == m_size) {
-            m_pushIndex = 0;
-        }
-        m_indices[value2] = value1;
-        degrees[value1] += degrees[value2];
-    }
+Maze::Maze(std::string const &fileName) :
+    Maze(LMZFile::isLMZ(fileName) ? Maze(LMZFile(fileName)) : Maze(MappedMaze(fileName)))
+{}
 
-    std::uint32_t pop(std::uint32_t degree)
-    {
-        std::uint32_t value = m_values[m_popIndex++];
-        if (m_popIndex == m_size) {
-            m_popIndex = 0;
-        }
-        m_indices[value] = value;
-        degrees[value] = degree;
-        return value;
-    }
+Maze::Maze(MappedMaze const &mappedMaze, std::uint32_t threadCount) :
+    m_height{mappedMaze.getHeight()},
+    m_width{mappedMaze.getWidth()},
+    m_walls{m_height, m_width, 2}
+{
+    Metrics::PhaseTimer timer(Metrics::Load);
+    Utilities::parallelFor(m_height, 64, threadCount,
+        [&](std::uint64_t begin, std::uint64_t end) {
+            std::vector<std::uint64_t> scratch(MazeImage::scratchWords(m_width));
+            for (std::uint32_t i = static_cast<std::uint32_t>(begin); i < end; i++) {
+                mappedMaze.decodeRow(i, scratch.data(),
+                    m_walls.row(i, VerticalWalls), m_walls.row(i, HorizontalWalls));
+            }
+        });
+}
 
-};
+Maze::Maze(LMZFile const &file, std::uint32_t threadCount) :
+    Maze(file, 0, 0, file.getHeight(), file.getWidth(), threadCount)
+{
+    if (m_height == file.getHeight() && m_width == file.getWidth()) {
+        m_parameters = file.getParameters();
+    }
+}
 
-Maze::Maze(Path const &path, std::int32_t seed,
-    std::vector<std::uint8_t> const &probabilitySet)
+Maze::Maze(LMZFile const &file, std::uint32_t row, std::uint32_t column,
+    std::uint32_t height, std::uint32_t width, std::uint32_t threadCount) :
+    m_height{isInside(file, row, column, height, width) ? height : 1},
+    m_width{isInside(file, row, column, height, width) ? width : 1},
+    m_walls{m_height, m_width, 2}
 {
-    m_height = path.getHeight();
-    m_width = path.getWidth();
-    m_verticalWalls.resize(m_height);
-    m_horizontalWalls.resize(m_height);
+    if (!isInside(file, row, column, height, width)) {
+        return;
+    }
+    std::uint32_t tileHeight = file.getTileHeight();
+    std::uint32_t tileWidth = file.getTileWidth();
+    std::uint32_t tileRowWords = tileWidth >> 6;
+    std::uint32_t firstTileRow = row / tileHeight;
+    std::uint32_t firstTileColumn = column / tileWidth;
+    std::uint32_t lastTileColumn = (column + width - 1) / tileWidth;
+    std::atomic<bool> failed{false};
+    // Tile rows are split among threads, so that each row of the maze is written by one thread.
+    Utilities::parallelFor((row + height - 1) / tileHeight - firstTileRow + 1, 1, threadCount,
+        [&](std::uint64_t begin, std::uint64_t end) {
+            std::vector<std::uint64_t> tile(file.tileWords(0));
+            for (std::uint32_t tileRow = firstTileRow + begin; tileRow < firstTileRow + end; tileRow++) {
+                std::uint32_t tileTop = tileRow * tileHeight;
+                std::uint32_t rowBegin = std::max(row, tileTop);
+                std::uint32_t rowEnd = std::min(row + height, tileTop + file.tileRowHeight(tileRow));
+                for (std::uint32_t tileColumn = firstTileColumn; tileColumn <= lastTileColumn; tileColumn++) {
+                    if (!file.readTile(tileRow, tileColumn, tile.data())) {
+                        failed = true;
+                        return;
+                    }
+                    std::uint64_t tileLeft = static_cast<std::uint64_t>(tileColumn) * tileWidth;
+                    std::uint64_t columnBegin = std::max<std::uint64_t>(column, tileLeft);
+                    std::uint64_t columnEnd = std::min<std::uint64_t>(
+                        static_cast<std::uint64_t>(column) + width, tileLeft + tileWidth);
+                    for (std::uint32_t i = rowBegin; i < rowEnd; i++) {
+                        std::uint64_t const *tileVerticalWalls =
+                            tile.data() + (static_cast<std::uint64_t>(i - tileTop) * tileRowWords << 1);
+                        orBits(tileVerticalWalls, columnBegin - tileLeft,
+                            m_walls.row(i - row, VerticalWalls), columnBegin - column,
+                            columnEnd - columnBegin);
+                        orBits(tileVerticalWalls + tileRowWords, columnBegin - tileLeft,
+                            m_walls.row(i - row, HorizontalWalls), columnBegin - column,
+                            columnEnd - columnBegin);
+                    }
+                }
+            }
+        });
+    if (failed) {
+        m_height = 1;
+        m_width = 1;
+        m_walls = BitPlanes(1, 1, 2);
+        return;
+    }
+    // Walls of the region border.
+    std::fill_n(m_walls.row(0, HorizontalWalls), m_walls.getRowWords(), 0);
     for (std::uint32_t i = 0; i < m_height; i++) {
-        m_verticalWalls[i] = std::vector<bool>(m_width, false);
-        m_horizontalWalls[i] = std::vector<bool>(m_width, false);
+        m_walls.row(i, VerticalWalls)[0] &= ~static_cast<std::uint64_t>(1);
     }
-    std::vector<std::vector<PathCell>> solutionCells = path.cells();
-    std::uint32_t poolSize = m_width + 2;
-    Pool pool(poolSize);
-    std::vector<std::uint32_t> cellIndices;
-    cellIndices.resize(m_width);
-
-    std::uint8_t probability1 = probabilitySet[0];
-    std::uint8_t probability2 = probabilitySet[1];
-    std::uint8_t probability3 = probabilitySet[2];
-    std::uint8_t probability4 = probabilitySet[3];
-    std::uint8_t probability5 = probabilitySet[4];
-    std::uint8_t probability6 = probabilitySet[5];
-    std::uint8_t probability12 =
-        static_cast<std::uint16_t>(probability1) * static_cast<std::uint16_t>(probability2) / 256;
-    std::uint8_t probability34 = probability3 -
-        static_cast<std::uint16_t>(probability3) * static_cast<std::uint16_t>(probability4) / 256 +
-        probability4;
-    std::uint8_t probability35 =
-        static_cast<std::uint16_t>(probability3) * static_cast<std::uint16_t>(probability5) / 256;
+}
 
-    std::uint32_t solutionIndex = pool.pop(0);
-    std::uint32_t borderIndex = pool.pop(0);
-    for (std::uint32_t j = 0; j < m_width; j++) {
-        cellIndices[j] = pool.pop(1);
+Maze::Maze(ProceduralMaze const &maze, std::uint32_t row, std::uint32_t column,
+    std::uint32_t height, std::uint32_t width) :
+    m_height{isInside(maze, row, column, height, width) ? height : 1},
+    m_width{isInside(maze, row, column, height, width) ? width : 1},
+    m_walls{m_height, m_width, 2}
+{
+    if (!isInside(maze, row, column, height, width)) {
+        return;
+    }
+    std::vector<std::uint64_t> verticalWalls((maze.getWidth() + 63) >> 6);
+    std::vector<std::uint64_t> horizontalWalls((maze.getWidth() + 63) >> 6);
+    for (std::uint32_t i = 0; i < height; i++) {
+        maze.decodeRow(row + i, verticalWalls.data(), horizontalWalls.data());
+        orBits(verticalWalls.data(), column, m_walls.row(i, VerticalWalls), 0, width);
+        orBits(horizontalWalls.data(), column, m_walls.row(i, HorizontalWalls), 0, width);
     }
+    // Walls of the region border.
+    std::fill_n(m_walls.row(0, HorizontalWalls), m_walls.getRowWords(), 0);
+    for (std::uint32_t i = 0; i < m_height; i++) {
+        m_walls.row(i, VerticalWalls)[0] &= ~static_cast<std::uint64_t>(1);
+    }
+}
 
+Maze::Maze(Path const &path, std::int32_t seed, std::uint16_t density,
+    std::uint32_t threadCount) :
+    m_height{path.getHeight()},
+    m_width{path.getWidth()},
+    m_walls{m_height, m_width, 2},
+    m_parameters{MazeParameters::Density, seed, density, {}, 0}
+{
+    Metrics::PhaseTimer timer(Metrics::Generate);
+    // Random values are drawn in row-major order, one for each wall not excluded
+    // by the border or by the path, so the first draw of each row is known in advance
+    // and rows can be generated in parallel with identical result.
+    PathCells solutionCells = path.cells();
+    std::vector<std::uint64_t> rowDraws(m_height + 1);
     for (std::uint32_t i = 0; i < m_height; i++) {
-        std::uint32_t nextSolutionCellIndex = 0;
-        std::uint32_t nextSolutionCellColumn = solutionCells[i].empty() ?
-            m_width : solutionCells[i][0].column;
-        borderIndex = pool.get(borderIndex);
-        if (pool.degrees[borderIndex] != 0) {
-            borderIndex = pool.pop(0);
+        std::uint64_t draws = (i != 0 ? m_width : 0) + (m_width != 0 ? m_width - 1 : 0);
+        for (PathCell const &cell : solutionCells[i]) {
+            draws -= (i != 0 && cell.above) + (cell.column != 0 && cell.left);
         }
-        std::uint32_t index = borderIndex;
-        for (std::uint32_t j = 0; j < m_width; j++) {
-            std::uint32_t aboveIndex = pool.get(cellIndices[j]);
-            std::uint8_t randValue = Utilities::randUint8(seed);
-            if (j == nextSolutionCellColumn) {
-                solutionIndex = pool.get(solutionIndex);
-                if (index == solutionIndex) {
-                    if (!solutionCells[i][nextSolutionCellIndex].left) {
-                        m_verticalWalls[i][j] = true;
-                    }
-                    if (aboveIndex == solutionIndex) {
-                        if (!solutionCells[i][nextSolutionCellIndex].above) {
-                            m_horizontalWalls[i][j] = true;
-                        }
-                    }
-                    else if (pool.degrees[aboveIndex] == 1 ||
-                        randValue < probability35 || randValue >= probability34)
-                    {
-                        pool.join(index, aboveIndex);
-                    }
-                    else {
-                        m_horizontalWalls[i][j] = true;
-                        pool.degrees[aboveIndex]--;
-                        pool.degrees[index]++;
-                    }
-                }
-                else if (aboveIndex == solutionIndex) {
-                    if (!solutionCells[i][nextSolutionCellIndex].above) {
-                        m_horizontalWalls[i][j] = true;
-                    }
-                    if ((randValue >= probability35 && randValue < probability3) ||
-                        randValue >= probability34)
-                    {
-                        pool.join(index, solutionIndex);
-                    }
-                    else {
-                        m_verticalWalls[i][j] = true;
-                        index = solutionIndex;
-                    }
-                }
-                else if (aboveIndex == index) {
-                    if (randValue < probability12) {
-                        m_horizontalWalls[i][j] = true;
-                        m_verticalWalls[i][j] = true;
-                        pool.degrees[index]--;
-                        pool.degrees[solutionIndex]++;
-                        index = solutionIndex;
-                    }
-                    else {
-                        if (randValue < probability1) {
-                            m_horizontalWalls[i][j] = true;
-                        }
-                        else {
-                            m_verticalWalls[i][j] = true;
-                        }
-                        pool.join(index,solutionIndex);
+        rowDraws[i + 1] = rowDraws[i] + draws;
+    }
+    std::uint64_t blockSize = std::max<std::uint64_t>(1, (1 << 16) / (m_width + 1));
+    Utilities::parallelFor(m_height, blockSize, threadCount,
+        [&](std::uint64_t begin, std::uint64_t end) {
+            std::int32_t rowSeed = seed;
+            Utilities::skipRand(rowSeed, rowDraws[begin]);
+            for (std::uint32_t i = begin; i < end; i++) {
+                std::uint64_t *verticalWalls = m_walls.row(i, VerticalWalls);
+                std::uint64_t *horizontalWalls = m_walls.row(i, HorizontalWalls);
+                std::uint32_t nextSolutionCellIndex = 0;
+                std::uint32_t nextSolutionCellColumn = solutionCells[i].empty() ?
+                    m_width : solutionCells[i][0].column;
+                for (std::uint32_t j = 0; j < m_width; j++) {
+                    bool above = false;
+                    bool left = false;
+                    if (j == nextSolutionCellColumn) {
+                        above = solutionCells[i][nextSolutionCellIndex].above;
+                        left = solutionCells[i][nextSolutionCellIndex].left;
+                        nextSolutionCellIndex++;
+                        nextSolutionCellColumn = nextSolutionCellIndex == solutionCells[i].size() ?
+                            m_width : solutionCells[i][nextSolutionCellIndex].column;
                     }
-                }
-                else if (pool.degrees[aboveIndex] == 1) {
-                    pool.join(solutionIndex,aboveIndex);
-                    if (randValue < probability6) {
-                        m_verticalWalls[i][j] = true;
-                        index = solutionIndex;
+                    std::uint64_t cellBit = static_cast<std::uint64_t>(1) << (j & 63);
+                    if (i != 0 && !above && Utilities::randUint8(rowSeed) < density) {
+                        horizontalWalls[j >> 6] |= cellBit;
                     }
-                    else {
-                        pool.join(index, solutionIndex);
+                    if (j != 0 && !left && Utilities::randUint8(rowSeed) < density) {
+                        verticalWalls[j >> 6] |= cellBit;
                     }
                 }
-                else if (randValue < probability35) {
-                    m_verticalWalls[i][j] = true;
-                    pool.join(solutionIndex, aboveIndex);
-                    index = solutionIndex;
-                }
-                else if (randValue < probability3) {
-                    m_horizontalWalls[i][j] = true;
-                    pool.degrees[aboveIndex]--;
-                    pool.degrees[index]++;
-                    pool.join(index, solutionIndex);
-                }
-                else if (randValue < probability34) {
-                    m_verticalWalls[i][j] = true;
-                    m_horizontalWalls[i][j] = true;
-                    pool.degrees[aboveIndex]--;
-                    pool.degrees[solutionIndex]++;
-                    index = solutionIndex;
-                }
-                else {
-                    pool.join(index, solutionIndex);
-                    pool.join(index, aboveIndex);
-                }
-                nextSolutionCellIndex++;
-                nextSolutionCellColumn =
-                    nextSolutionCellIndex == solutionCells[i].size() ?
-                    m_width : solutionCells[i][nextSolutionCellIndex].column;
-            }
-            else if (index == aboveIndex) {
-                if (randValue < probability12) {
-                    m_horizontalWalls[i][j] = true;
-                    m_verticalWalls[i][j] = true;
-                    pool.degrees[aboveIndex]--;
-                    index = pool.pop(1);
-                }
-                else if (randValue < probability1) {
-                    m_horizontalWalls[i][j] = true;
-                }
-                else {
-                    m_verticalWalls[i][j] = true;
-                }
-            }
-            else if (pool.degrees[aboveIndex] == 1) {
-                if (randValue < probability6) {
-                    m_verticalWalls[i][j] = true;
-                    index = aboveIndex;
-                }
-                else {
-                    pool.join(index, aboveIndex);
-                }
-            }
-            else if (randValue < probability35) {
-                m_verticalWalls[i][j] = true;
-                index = aboveIndex;
-            }
-            else if (randValue < probability3) {
-                m_horizontalWalls[i][j] = true;
-                pool.degrees[aboveIndex]--;
-                pool.degrees[index]++;
-            }
-            else if (randValue < probability34) {
-                m_verticalWalls[i][j] = true;
-                m_horizontalWalls[i][j] = true;
-                pool.degrees[aboveIndex]--;
-                index = pool.pop(1);
-            }
-            else {
-                pool.join(index, aboveIndex);
             }
-            cellIndices[j] = index;
-        }
-    }
-    std::uint32_t index = pool.get(borderIndex);
-    for (std::uint32_t j = 0; j < m_width; j++) {
-        std::uint32_t aboveIndex = pool.get(cellIndices[j]);
-        if (index != aboveIndex) {
-            std::uint8_t randValue = Utilities::randUint8(seed);
-            if ((pool.degrees[index] + 1) * randValue < 256) {
-                m_verticalWalls[m_height - 1][j] = false;
-                pool.join(index, aboveIndex);
-            }
-            else {
-                index = aboveIndex;
-            }
-        }
-        pool.degrees[index]--;
-    }
+        });
+}
+
+Maze::Maze(Path const &path, std::int32_t seed,
+    std::vector<std::uint8_t> const &probabilitySet) :
+    m_height{path.getHeight()},
+    m_width{path.getWidth()},
+    m_walls{m_height, m_width, 2},
+    m_parameters{MazeParameters::Tree, seed, 0, probabilitySet, 1}
+{
+    Metrics::PhaseTimer timer(Metrics::Generate);
+    PathRowCursor solutionCells(path);
+    TreeMazeGenerator generator(m_width, seed, probabilitySet);
     for (std::uint32_t i = 0; i < m_height; i++) {
-        m_verticalWalls[i][0] = false;
+        PathCellRow rowCells = solutionCells.next();
+        generator.generateRow(rowCells.data(), rowCells.size(),
+            m_walls.row(i, VerticalWalls), m_walls.row(i, HorizontalWalls));
+    }
+    if (m_height != 0) {
+        generator.finish(m_walls.row(m_height - 1, VerticalWalls));
+        std::fill_n(m_walls.row(0, HorizontalWalls), m_walls.getRowWords(), 0);
     }
 }
 
+Maze::Maze(Path const &path, std::int32_t seed, std::vector<std::uint8_t> const &probabilitySet,
+    std::uint32_t stripCount, std::uint32_t threadCount) :
+    m_height{path.getHeight()},
+    m_width{path.getWidth()},
+    m_walls{m_height, m_width, 2},
+    m_parameters{MazeParameters::Tree, seed, 0, probabilitySet,
+        std::min(Utilities::threadCount(stripCount), m_height)}
+{
+    Metrics::PhaseTimer timer(Metrics::Generate);
+    TreeMazeGenerator::generateStrips(path, seed, probabilitySet, stripCount, threadCount,
+        m_walls, VerticalWalls, HorizontalWalls);
+}
+
 std::string Maze::toString() const
 {
     std::string mazeString;
@@ -374,7 +379,7 @@ std::string Maze::toString() const
         else {
             for (std::uint32_t j = 0; j < m_width; j++) {
                 mazeString += char(219);
-                mazeString += m_horizontalWalls[i][j] ? char(219) : ' ';
+                mazeString += m_walls.get(i, j, HorizontalWalls) ? char(219) : ' ';
             }
             mazeString += char(219);
         }
@@ -384,7 +389,7 @@ std::string Maze::toString() const
                 mazeString += char(219);
             }
             else {
-                mazeString += m_verticalWalls[i][j] ? char(219) : ' ';
+                mazeString += m_walls.get(i, j, VerticalWalls) ? char(219) : ' ';
             }
             mazeString += ' ';
         }
@@ -397,172 +402,167 @@ std::string Maze::toString() const
     return mazeString;
 }
 
-bool Maze::toBMP(std::string const &fileName) const
+bool Maze::toBMP(std::string const &fileName, std::uint32_t threadCount) const
 {
-    std::int32_t bmpHeight = (m_height << 1) + 1;
-    std::int32_t bmpWidth = (m_width << 1) + 1;
-    std::ofstream file;
-    if (!Utilities::writeBMP(fileName, bmpWidth, bmpHeight, file)) {
+    BMPBandWriter writer(fileName, m_height, m_width);
+    if (!writer.isOpen()) {
         return false;
     }
-    std::uint32_t bmpWidthBytes = (((bmpWidth - 1) >> 5) + 1) << 2;
-    char *row1 = new char[bmpWidthBytes];
-    char *row2 = new char[bmpWidthBytes];
-    for (std::uint32_t j = 0; j < bmpWidthBytes; j++) {
-        row1[j] = 0;
+    std::uint32_t rowBytes = writer.getRowBytes();
+    std::vector<char> border(rowBytes, 0);
+    {
+        Metrics::PhaseTimer timer(Metrics::Encode);
+        MazeImage::encodeBottomBorder(m_width, border.data());
     }
-    row1[(bmpWidth - 2) >> 3] |= 1 << (7 - ((bmpWidth - 2) & 7));
-    if (!file.write(row1, bmpWidthBytes)) {
-        delete[] row1;
-        delete[] row2;
+    if (!writer.writeBottomBorder(border.data())) {
         return false;
     }
-    for (std::uint32_t i = m_height - 1; i > 0; i--) {
-        for (std::uint32_t j = 0; j < bmpWidthBytes; j++) {
-            row1[j] = 0;
-            row2[j] = 0;
-        }
-        for (std::uint32_t j = 0; j < m_width; j++) {
-            if (!m_horizontalWalls[i][j]) {
-                row1[j >> 2] |= 1 << (6 - ((j & 3) << 1));
+    std::vector<std::vector<std::uint64_t>> scratch(Utilities::threadCount(threadCount));
+    return writer.write(threadCount,
+        [&](std::uint32_t thread, std::uint32_t firstRow, std::uint32_t rowEnd, char *rows) {
+            Metrics::PhaseTimer timer(Metrics::Encode);
+            scratch[thread].resize(MazeImage::scratchWords(m_width));
+            for (std::uint32_t i = rowEnd; i-- > firstRow;) {
+                char *row2 = rows + (static_cast<std::uint64_t>(rowEnd - 1 - i) * rowBytes << 1);
+                MazeImage::encodeRows(m_width, i == 0,
+                    m_walls.row(i, VerticalWalls), m_walls.row(i, HorizontalWalls),
+                    scratch[thread].data(), row2 + rowBytes, row2);
             }
-            if (j != 0 && !m_verticalWalls[i][j]) {
-                row2[j >> 2] |= 1 << (7 - ((j & 3) << 1));
-            }
-            row2[j >> 2] |= 1 << (6 - ((j & 3) << 1));
-        }
-        if (!file.write(row2, bmpWidthBytes) || !file.write(row1, bmpWidthBytes)) {
-            delete[] row1;
-            delete[] row2;
-            return false;
-        }
-    }
-    for (std::uint32_t j = 0; j < bmpWidthBytes; j++) {
-        row1[j] = 0;
-        row2[j] = 0;
-    }
-    row1[0] = 64;
-    for (std::uint32_t j = 0; j < m_width; j++) {
-        if (j != 0 && !m_verticalWalls[0][j]) {
-            row2[j >> 2] |= 1 << (7 - ((j & 3) << 1));
-        }
-        row2[j >> 2] |= 1 << (6 - ((j & 3) << 1));
-    }
-    if (!file.write(row2, bmpWidthBytes) || !file.write(row1, bmpWidthBytes)) {
-        delete[] row1;
-        delete[] row2;
-        return false;
-    }
-    delete[] row1;
-    delete[] row2;
-    return true;
+        });
 }
 
-Path Maze::solve(std::uint32_t i1, std::uint32_t j1, std::uint32_t i2, std::uint32_t j2) const
+bool Maze::toLMZ(std::string const &fileName, std::uint32_t tileSize, std::uint32_t threadCount) const
 {
-    if (i1 == i2 && j1 == j2) {
-        return {m_height, m_width, i1, j1, std::vector<Path::Direction>{}};
-    }
-    std::vector<Path::Direction> initialDirections;
-    if (i1 != 0 && !m_horizontalWalls[i1][j1]) {
-        initialDirections.push_back(Path::Up);
-    }
-    if (i1 != m_height - 1 && !m_horizontalWalls[i1 + 1][j1]) {
-        initialDirections.push_back(Path::Down);
+    return LMZFile::write(fileName, m_walls, VerticalWalls, HorizontalWalls, m_parameters,
+        tileSize, threadCount);
+}
+
+Path Maze::solve(std::uint32_t i1, std::uint32_t j1, std::uint32_t i2, std::uint32_t j2,
+    MazeSolver::Statistics *statistics) const
+{
+    Metrics::PhaseTimer timer(Metrics::Solve);
+    return MazeSolver::wallFollower(*this, i1, j1, i2, j2, statistics);
+}
+
+Path Maze::solveShortest(std::uint32_t i1, std::uint32_t j1,
+    std::uint32_t i2, std::uint32_t j2, std::uint32_t threadCount,
+    MazeSolver::Statistics *statistics) const
+{
+    Metrics::PhaseTimer timer(Metrics::Solve);
+    return MazeSolver::breadthFirst(*this, i1, j1, i2, j2, threadCount, statistics);
+}
+
+Path Maze::solveAStar(std::uint32_t i1, std::uint32_t j1, std::uint32_t i2, std::uint32_t j2,
+    MazeSolver::Statistics *statistics) const
+{
+    Metrics::PhaseTimer timer(Metrics::Solve);
+    return MazeSolver::bidirectionalAStar(*this, i1, j1, i2, j2, statistics);
+}
+
+std::vector<Path> Maze::solveBatch(std::vector<MazeSolver::Query> const &queries,
+    MazeSolver::Algorithm algorithm, std::uint32_t threadCount) const
+{
+    Metrics::PhaseTimer timer(Metrics::Solve);
+    std::vector<Path> paths(queries.size());
+    MazeSolver::solveBatch(*this, queries, algorithm, threadCount,
+        [&](std::uint64_t k, bool, MazeSolver::Workspace const &workspace) {
+            paths[k] = Path(m_height, m_width, queries[k].i1, queries[k].j1,
+                workspace.directions);
+        });
+    return paths;
+}
+
+std::vector<MazeSolver::Summary> Maze::solveBatchSummaries(
+    std::vector<MazeSolver::Query> const &queries,
+    MazeSolver::Algorithm algorithm, std::uint32_t threadCount) const
+{
+    Metrics::PhaseTimer timer(Metrics::Solve);
+    std::vector<MazeSolver::Summary> summaries(queries.size());
+    MazeSolver::solveBatch(*this, queries, algorithm, threadCount,
+        [&](std::uint64_t k, bool solved, MazeSolver::Workspace const &workspace) {
+            summaries[k] = {solved, workspace.directions.size(),
+                Path::integral(queries[k].i1, workspace.directions)};
+        });
+    return summaries;
+}
+
+Maze::Components Maze::components(std::uint32_t threadCount) const
+{
+    Components result;
+    if (static_cast<std::uint64_t>(m_height) * m_width > UINT32_MAX) {
+        return result;
     }
-    if (j1 != 0 && !m_verticalWalls[i1][j1]) {
-        initialDirections.push_back(Path::Left);
+    result.labels.resize(static_cast<std::uint64_t>(m_height) * m_width);
+    // Several strips per thread, so that threads finishing early take more.
+    std::uint32_t stripCount = static_cast<std::uint32_t>(std::min<std::uint64_t>(
+        m_height, 4 * static_cast<std::uint64_t>(Utilities::threadCount(threadCount))));
+    std::vector<std::uint32_t> stripRows(stripCount + 1);
+    for (std::uint32_t s = 0; s <= stripCount; s++) {
+        stripRows[s] = static_cast<std::uint32_t>(static_cast<std::uint64_t>(m_height) * s / stripCount);
     }
-    if (j1 != m_width - 1 && !m_verticalWalls[i1][j1 + 1]) {
-        initialDirections.push_back(Path::Right);
+    std::vector<StripLabels> strips(stripCount);
+    Utilities::parallelFor(stripCount, 1, threadCount,
+        [&](std::uint64_t begin, std::uint64_t end) {
+            for (std::uint64_t s = begin; s < end; s++) {
+                strips[s] = labelStrip(*this, stripRows[s], stripRows[s + 1], result.labels.data());
+            }
+        });
+    // Labels of all strips, numbered strip by strip, are joined within strips and along
+    // strip borders. As the representative of a set is its smallest label, the sets are
+    // numbered in the order of their first cells.
+    std::vector<std::uint32_t> offsets(stripCount + 1, 0);
+    for (std::uint32_t s = 0; s < stripCount; s++) {
+        offsets[s + 1] = offsets[s] + static_cast<std::uint32_t>(strips[s].parents.size());
     }
-    for (Path::Direction initialDirection : initialDirections) {
-        std::uint32_t i = i1;
-        std::uint32_t j = j1;
-        std::vector<Path::Direction> directions{initialDirection};
-        Path::Direction direction;
-        switch (initialDirection) {
-            case Path::Up:
-                i--;
-                direction = Path::Left;
-                break;
-            case Path::Down:
-                i++;
-                direction = Path::Right;
-                break;
-            case Path::Left:
-                j--;
-                direction = Path::Down;
-                break;
-            case Path::Right:
-                j++;
-                direction = Path::Up;
+    std::vector<std::uint32_t> parents(offsets[stripCount]);
+    for (std::uint32_t s = 0; s < stripCount; s++) {
+        for (std::uint32_t k = 0; k < strips[s].parents.size(); k++) {
+            parents[offsets[s] + k] = offsets[s] + strips[s].parents[k];
         }
-        while ((i != i1 || j != j1) && (i != i2 || j != j2)) {
-            if (direction == Path::Up) {
-                if (i != 0 && !m_horizontalWalls[i][j]) {
-                    if (directions.back() == Path::Down) {
-                        directions.pop_back();
-                    }
-                    else {
-                        directions.push_back(Path::Up);
-                    }
-                    i--;
-                    direction = Path::Left;
-                }
-                else {
-                    direction = Path::Right;
-                }
-            }
-            else if (direction == Path::Down) {
-                if (i != m_height - 1 && !m_horizontalWalls[i + 1][j]) {
-                    if (directions.back() == Path::Up) {
-                        directions.pop_back();
-                    }
-                    else {
-                        directions.push_back(Path::Down);
-                    }
-                    i++;
-                    direction = Path::Right;
-                }
-                else {
-                    direction = Path::Left;
-                }
-            }
-            else if (direction == Path::Left) {
-                if (j != 0 && !m_verticalWalls[i][j]) {
-                    if (directions.back() == Path::Right) {
-                        directions.pop_back();
-                    }
-                    else {
-                        directions.push_back(Path::Left);
-                    }
-                    j--;
-                    direction = Path::Down;
-                }
-                else {
-                    direction = Path::Up;
-                }
-            }
-            else {
-                if (j != m_width - 1 && !m_verticalWalls[i][j + 1]) {
-                    if (directions.back() == Path::Left) {
-                        directions.pop_back();
-                    }
-                    else {
-                        directions.push_back(Path::Right);
-                    }
-                    j++;
-                    direction = Path::Up;
-                }
-                else {
-                    direction = Path::Down;
+        std::vector<std::uint32_t>().swap(strips[s].parents);
+    }
+    for (std::uint32_t s = 1; s < stripCount; s++) {
+        std::uint32_t i = stripRows[s];
+        std::uint64_t const *horizontalWalls = m_walls.row(i, HorizontalWalls);
+        std::uint32_t const *row = result.labels.data() + static_cast<std::uint64_t>(i) * m_width;
+        std::uint32_t const *aboveRow = row - m_width;
+        for (std::uint32_t j = 0; j < m_width; j++) {
+            if (!((horizontalWalls[j >> 6] >> (j & 63)) & 1)) {
+                std::uint32_t root = DisjointSetForest::find(parents, offsets[s] + row[j]);
+                std::uint32_t aboveRoot =
+                    DisjointSetForest::find(parents, offsets[s - 1] + aboveRow[j]);
+                if (root != aboveRoot) {
+                    DisjointSetForest::join(parents, root, aboveRoot);
                 }
             }
         }
-        if (i == i2 && j == j2) {
-            return {m_height, m_width, i1, j1, directions};
+    }
+    std::uint32_t count = DisjointSetForest::number(parents);
+    result.components.assign(count, {0, m_height, 0, m_width, 0});
+    for (std::uint32_t s = 0; s < stripCount; s++) {
+        for (std::uint32_t k = 0; k < strips[s].cells.size(); k++) {
+            Components::Component const &cells = strips[s].cells[k];
+            Components::Component &component = result.components[parents[offsets[s] + k]];
+            component.size += cells.size;
+            component.minRow = std::min(component.minRow, cells.minRow);
+            component.maxRow = std::max(component.maxRow, cells.maxRow);
+            component.minColumn = std::min(component.minColumn, cells.minColumn);
+            component.maxColumn = std::max(component.maxColumn, cells.maxColumn);
         }
+        std::vector<Components::Component>().swap(strips[s].cells);
     }
-    return {m_height, m_width, i1, j1, std::vector<Path::Direction>{}};
+    Utilities::parallelFor(stripCount, 1, threadCount,
+        [&](std::uint64_t begin, std::uint64_t end) {
+            for (std::uint64_t s = begin; s < end; s++) {
+                std::uint32_t *labels = result.labels.data() +
+                    static_cast<std::uint64_t>(stripRows[s]) * m_width;
+                std::uint64_t cellCount =
+                    static_cast<std::uint64_t>(stripRows[s + 1] - stripRows[s]) * m_width;
+                std::uint32_t const *numbers = parents.data() + offsets[s];
+                for (std::uint64_t k = 0; k < cellCount; k++) {
+                    labels[k] = numbers[labels[k]];
+                }
+            }
+        });
+    return result;
 }
\ No newline at end of file
@@ -5,6 +5,12 @@
 #include <vector>
 #include <string>
 #include <Path.h>
+#include <BitPlanes.h>
+#include <MappedMaze.h>
+#include <LMZFile.h>
+#include <ProceduralMaze.h>
+#include <MazeParameters.h>
+#include <MazeSolver.h>
 
 // 2D maze of size m x n.
 class Maze {
@@ -15,26 +21,94 @@ class Maze {
     // Width.
     std::uint32_t m_width;
 
-    // m_verticalWalls[i][j] = true if the (i, j)-th cell has wall left to it.
-    // Cells in column j = 0 have no walls on the left.
-    std::vector<std::vector<bool>> m_verticalWalls;
+    // Indices of wall planes in m_walls.
+    enum WallPlane {VerticalWalls, HorizontalWalls};
 
-    // m_horizontalWalls[i][j] = true if the (i, j)-th cell has wall above it.
+    // Bit (i, j) of plane VerticalWalls is set if the (i, j)-th cell has wall left to it.
+    // Cells in column j = 0 have no walls on the left.
+    // Bit (i, j) of plane HorizontalWalls is set if the (i, j)-th cell has wall above it.
     // Cells in row i = 0 have no walls above it.
-    std::vector<std::vector<bool>> m_horizontalWalls;
+    BitPlanes m_walls;
+
+    // Parameters of the generator which created the maze.
+    MazeParameters m_parameters;
 
 public:
 
+    // Connected components of a maze: sets of cells connected by paths inside the maze.
+    struct Components {
+
+        // Number of cells and bounding box of a component.
+        struct Component {
+            std::uint64_t size;
+            std::uint32_t minRow;
+            std::uint32_t maxRow;
+            std::uint32_t minColumn;
+            std::uint32_t maxColumn;
+        };
+
+        // Component of each cell, with labels[i * width + j] for the (i, j)-th cell.
+        std::vector<std::uint32_t> labels;
+
+        // Components, numbered in the order of their first cells row by row.
+        std::vector<Component> components;
+
+    };
+
     std::uint32_t getHeight() const;
 
     std::uint32_t getWidth() const;
 
-    // Create maze from a BMP file. Return 1 x 1 maze if could not read file.
+    MazeParameters const &getParameters() const;
+
+    // Number of 64-bit words per row of a wall plane.
+    std::uint32_t getRowWords() const;
+
+    // Vertical walls in the i-th row, where bit (j & 63) of the (j >> 6)-th word
+    // is set if the (i, j)-th cell has wall left to it.
+    std::uint64_t const *verticalWalls(std::uint32_t i) const;
+
+    // Horizontal walls in the i-th row, where bit (j & 63) of the (j >> 6)-th word
+    // is set if the (i, j)-th cell has wall above it.
+    std::uint64_t const *horizontalWalls(std::uint32_t i) const;
+
+    // Return true if the (i, j)-th cell cannot be left toward given direction,
+    // either because of a wall or because of the maze border.
+    bool hasWall(std::uint32_t i, std::uint32_t j, Path::Direction direction) const;
+
+    // Create maze from a BMP file or a tiled maze file (see LMZFile).
+    // Return 1 x 1 maze if could not read file.
     Maze(std::string const &fileName);
 
+    // Decode a memory-mapped maze, splitting rows among threadCount threads
+    // (all hardware threads if threadCount = 0).
+    explicit Maze(MappedMaze const &mappedMaze, std::uint32_t threadCount = 0);
+
+    // Decode all tiles of a tiled maze file, splitting tile rows among threadCount threads
+    // (all hardware threads if threadCount = 0). Return 1 x 1 maze if a tile is corrupt.
+    Maze(LMZFile const &file, std::uint32_t threadCount = 0);
+
+    // Cut the region of given size with upper left cell (row, column) from a tiled maze
+    // file, decoding only the tiles covering it, by up to threadCount threads (all hardware
+    // threads if threadCount = 0). The region must lie inside the maze. Walls on the region
+    // border are dropped, and the generator parameters are unknown.
+    // Return 1 x 1 maze if the region is invalid or a tile is corrupt.
+    Maze(LMZFile const &file, std::uint32_t row, std::uint32_t column,
+        std::uint32_t height, std::uint32_t width, std::uint32_t threadCount = 0);
+
+    // Cut the region of given size with upper left cell (row, column) from a procedural
+    // maze, generating only the rows covering it. The region must lie inside the maze.
+    // Walls on the region border are dropped, and the generator parameters are unknown.
+    // Return 1 x 1 maze if the region is invalid.
+    Maze(ProceduralMaze const &maze, std::uint32_t row, std::uint32_t column,
+        std::uint32_t height, std::uint32_t width);
+
     // Create a random maze with given predefined path inside, random seed number
     // and wall density (density = 0 is no walls, and density > 255 is all walls).
-    Maze(Path const &path, std::int32_t seed, std::uint16_t density);
+    // Rows are generated by up to threadCount threads (all hardware threads
+    // if threadCount = 0), and the maze does not depend on threadCount.
+    Maze(Path const &path, std::int32_t seed, std::uint16_t density,
+        std::uint32_t threadCount = 0);
 
     // Create a random maze such that each two cells are connected by exactly one path,
     // with given random seed number, predefined path inside the maze,
@@ -44,17 +118,99 @@ public:
     Maze(Path const &path, std::int32_t seed,
         std::vector<std::uint8_t> const &probabilitySet = {163, 118, 123, 123, 94, 103});
 
+    // As Maze(path, seed, probabilitySet), but generate stripCount horizontal strips
+    // of the maze in parallel, using up to threadCount threads (all hardware threads
+    // if threadCount = 0), and stitch them together (see TreeMazeGenerator::generateStrips).
+    // The maze depends on stripCount (one strip per hardware thread if stripCount = 0),
+    // and stripCount = 1 gives the same maze as Maze(path, seed, probabilitySet).
+    Maze(Path const &path, std::int32_t seed, std::vector<std::uint8_t> const &probabilitySet,
+        std::uint32_t stripCount, std::uint32_t threadCount = 0);
+
+    // Find connected components. Horizontal strips of rows are labelled by up to
+    // threadCount threads (all hardware threads if threadCount = 0) and merged along
+    // strip borders with disjoint sets of strip components; the result does not depend
+    // on threadCount. Labels are 32-bit, so mazes of 2^32 cells or more are rejected
+    // with empty labels and components.
+    Components components(std::uint32_t threadCount = 0) const;
+
     // View maze as a multi-line string.
     std::string toString() const;
 
-    // Save as BMP file. Return false if failed.
-    bool toBMP(std::string const &fileName) const;
+    // Save as BMP file, encoding bands of rows by up to threadCount threads (all hardware
+    // threads if threadCount = 0), each band written at its place in the file as soon as
+    // it is encoded (see BMPBandWriter). Return false if failed.
+    bool toBMP(std::string const &fileName, std::uint32_t threadCount = 0) const;
+
+    // Save as tiled maze file with tiles of tileSize x tileSize cells (rounded up
+    // to a multiple of 64), coded by up to threadCount threads (all hardware threads
+    // if threadCount = 0). Return false if failed.
+    bool toLMZ(std::string const &fileName, std::uint32_t tileSize = LMZFile::defaultTileSize,
+        std::uint32_t threadCount = 0) const;
 
     // Find path between given cells using "always turn left" algoritm.
     // Return empty path with initial point (i1, j1)
     // if the algorithm finds a loop before finding a solution.
-    Path solve(std::uint32_t i1, std::uint32_t j1, std::uint32_t i2, std::uint32_t j2) const;
+    Path solve(std::uint32_t i1, std::uint32_t j1, std::uint32_t i2, std::uint32_t j2,
+        MazeSolver::Statistics *statistics = nullptr) const;
+
+    // Find a shortest path between given cells using breadth-first search over
+    // bit-parallel frontiers, also in mazes with loops. Large levels are expanded by up to
+    // threadCount threads (all hardware threads if threadCount = 0).
+    // Return empty path with initial point (i1, j1) if there is no solution.
+    Path solveShortest(std::uint32_t i1, std::uint32_t j1, std::uint32_t i2, std::uint32_t j2,
+        std::uint32_t threadCount = 1, MazeSolver::Statistics *statistics = nullptr) const;
+
+    // Find a shortest path between given cells using bidirectional A* search,
+    // which expands fewer cells than solveShortest when the cells are far apart.
+    // Return empty path with initial point (i1, j1) if there is no solution.
+    Path solveAStar(std::uint32_t i1, std::uint32_t j1, std::uint32_t i2, std::uint32_t j2,
+        MazeSolver::Statistics *statistics = nullptr) const;
+
+    // Solve queries using given algorithm, spread among up to threadCount threads
+    // (all hardware threads if threadCount = 0) sharing this maze, each with its own
+    // scratch memory, which for BidirectionalAStar follows the cells expanded by its queries
+    // (see MazeSolver::solveBatch). Unsolved queries give empty paths with the initial
+    // point (i1, j1).
+    std::vector<Path> solveBatch(std::vector<MazeSolver::Query> const &queries,
+        MazeSolver::Algorithm algorithm = MazeSolver::BidirectionalAStar,
+        std::uint32_t threadCount = 0) const;
+
+    // As solveBatch, but return only lengths and integrals of the paths,
+    // so that no memory is allocated per query.
+    std::vector<MazeSolver::Summary> solveBatchSummaries(
+        std::vector<MazeSolver::Query> const &queries,
+        MazeSolver::Algorithm algorithm = MazeSolver::BidirectionalAStar,
+        std::uint32_t threadCount = 0) const;
 
 };
 
+inline std::uint32_t Maze::getRowWords() const
+{
+    return m_walls.getRowWords();
+}
+
+inline std::uint64_t const *Maze::verticalWalls(std::uint32_t i) const
+{
+    return m_walls.row(i, VerticalWalls);
+}
+
+inline std::uint64_t const *Maze::horizontalWalls(std::uint32_t i) const
+{
+    return m_walls.row(i, HorizontalWalls);
+}
+
+inline bool Maze::hasWall(std::uint32_t i, std::uint32_t j, Path::Direction direction) const
+{
+    switch (direction) {
+        case Path::Up:
+            return i == 0 || m_walls.get(i, j, HorizontalWalls);
+        case Path::Down:
+            return i == m_height - 1 || m_walls.get(i + 1, j, HorizontalWalls);
+        case Path::Left:
+            return j == 0 || m_walls.get(i, j, VerticalWalls);
+        default:
+            return j == m_width - 1 || m_walls.get(i, j + 1, VerticalWalls);
+    }
+}
+
 #endif
\ No newline at end of file
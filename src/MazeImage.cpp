@@ -0,0 +1,71 @@
+#include <cstdint>
+#include <algorithm>
+#include <BitInterleave.h>
+#include <MazeImage.h>
+
+std::uint32_t MazeImage::scratchWords(std::uint32_t width)
+{
+    return ((width + 63) >> 6) << 1;
+}
+
+void MazeImage::encodeRows(std::uint32_t width, bool firstRow,
+    std::uint64_t const *verticalWalls, std::uint64_t const *horizontalWalls,
+    std::uint64_t *scratch, char *row1, char *row2)
+{
+    std::uint32_t words = (width + 63) >> 6;
+    if (words == 0) {
+        return;
+    }
+    std::uint64_t *openings = scratch;
+    std::uint64_t *constant = scratch + words;
+    for (std::uint32_t w = 0; w < words; w++) {
+        openings[w] = ~verticalWalls[w];
+        constant[w] = ~static_cast<std::uint64_t>(0);
+    }
+    openings[0] &= ~static_cast<std::uint64_t>(1);
+    BitInterleave::interleave(openings, constant, width, row2);
+    if (firstRow) {
+        std::fill_n(row1, (width + 3) >> 2, 0);
+        row1[0] = 64;
+        return;
+    }
+    for (std::uint32_t w = 0; w < words; w++) {
+        openings[w] = ~horizontalWalls[w];
+        constant[w] = 0;
+    }
+    BitInterleave::interleave(constant, openings, width, row1);
+}
+
+void MazeImage::decodeRows(std::uint32_t width, bool firstRow,
+    char const *row1, char const *row2,
+    std::uint64_t *scratch, std::uint64_t *verticalWalls, std::uint64_t *horizontalWalls)
+{
+    std::uint32_t words = (width + 63) >> 6;
+    if (words == 0) {
+        return;
+    }
+    std::uint64_t lastMask = (width & 63) == 0 ? ~static_cast<std::uint64_t>(0) :
+        (static_cast<std::uint64_t>(1) << (width & 63)) - 1;
+    BitInterleave::deinterleave(row2, width, verticalWalls, scratch);
+    for (std::uint32_t w = 0; w < words; w++) {
+        verticalWalls[w] = ~verticalWalls[w];
+    }
+    verticalWalls[0] &= ~static_cast<std::uint64_t>(1);
+    verticalWalls[words - 1] &= lastMask;
+    if (firstRow) {
+        std::fill_n(horizontalWalls, words, 0);
+        return;
+    }
+    BitInterleave::deinterleave(row1, width, scratch, horizontalWalls);
+    for (std::uint32_t w = 0; w < words; w++) {
+        horizontalWalls[w] = ~horizontalWalls[w];
+    }
+    horizontalWalls[words - 1] &= lastMask;
+}
+
+void MazeImage::encodeBottomBorder(std::uint32_t width, char *row)
+{
+    std::uint64_t x = static_cast<std::uint64_t>(width) << 1;
+    std::fill_n(row, (width + 3) >> 2, 0);
+    row[(x - 1) >> 3] |= 1 << (7 - ((x - 1) & 7));
+}
\ No newline at end of file
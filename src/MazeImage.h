@@ -0,0 +1,33 @@
+#ifndef MAZEIMAGE_H
+#define MAZEIMAGE_H
+
+#include <cstdint>
+
+// Conversion between maze rows and rows of maze BMP images (see Maze::toBMP).
+// Each maze row corresponds to two BMP rows: row1 with horizontal walls above the cells
+// (the top border for the first maze row) and row2 with the cells and vertical walls.
+// Walls are stored as in Maze::verticalWalls and Maze::horizontalWalls.
+// BMP rows are written only up to pixel 2 * width, so that trailing bytes
+// of a zero-initialized row buffer stay cleared.
+namespace MazeImage {
+
+    // Number of 64-bit words of scratch memory needed by encodeRows and decodeRows.
+    std::uint32_t scratchWords(std::uint32_t width);
+
+    // Encode walls of a maze row into BMP rows row1 and row2.
+    void encodeRows(std::uint32_t width, bool firstRow,
+        std::uint64_t const *verticalWalls, std::uint64_t const *horizontalWalls,
+        std::uint64_t *scratch, char *row1, char *row2);
+
+    // Decode walls of a maze row from BMP rows row1 and row2, overwriting
+    // the first (width + 63) / 64 words of verticalWalls and horizontalWalls.
+    void decodeRows(std::uint32_t width, bool firstRow,
+        char const *row1, char const *row2,
+        std::uint64_t *scratch, std::uint64_t *verticalWalls, std::uint64_t *horizontalWalls);
+
+    // Encode the bottom border row, containing the exit below the last cell.
+    void encodeBottomBorder(std::uint32_t width, char *row);
+
+}
+
+#endif
\ No newline at end of file
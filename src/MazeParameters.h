@@ -0,0 +1,33 @@
+#ifndef MAZEPARAMETERS_H
+#define MAZEPARAMETERS_H
+
+#include <cstdint>
+#include <vector>
+
+// Parameters of the generator which created a maze (see the Maze constructors),
+// from which the maze can be created again given its path.
+struct MazeParameters {
+
+    enum Generator : std::uint8_t {
+        // Loaded from a file without parameters, or cut from a larger maze.
+        Unknown,
+        // Maze(path, seed, density).
+        Density,
+        // Maze(path, seed, probabilitySet, stripCount).
+        Tree
+    };
+
+    Generator generator = Unknown;
+
+    std::int32_t seed = 0;
+
+    // Wall density of density mazes.
+    std::uint16_t density = 0;
+
+    // Probability set (6 values) and number of strips of tree mazes.
+    std::vector<std::uint8_t> probabilitySet;
+    std::uint32_t stripCount = 0;
+
+};
+
+#endif
\ No newline at end of file
@@ -0,0 +1,824 @@
+#ifndef MAZESOLVER_H
+#define MAZESOLVER_H
+
+#include <cstdint>
+#include <vector>
+#include <algorithm>
+#include <Path.h>
+#include <BitPlanes.h>
+#include <PagedBitPlanes.h>
+#include <Utilities.h>
+#include <Metrics.h>
+
+// Maze solving algorithms, applicable to any maze representation Walls providing
+// getHeight(), getWidth() and hasWall(i, j, direction) as in Maze.
+// Each algorithm reports its work in statistics, unless it is null.
+namespace MazeSolver {
+
+    // Work done by a solver.
+    struct Statistics {
+
+        // Number of cells expanded (moved to in the wall follower).
+        std::uint64_t expandedCells = 0;
+
+    };
+
+    // Memory reused by consecutive queries of a single thread, so that
+    // solving into a workspace does not allocate once it has grown large enough.
+    struct Workspace {
+
+        // Directions of the last path found.
+        Path::Directions directions;
+
+        // Bit-planes of bidirectionalAStar, cleared after each query.
+        BitPlanes cells;
+
+        // Bit-planes of pagedBidirectionalAStar, cleared after each query.
+        PagedBitPlanes pagedCells;
+
+        // Cells with bits set in cells.
+        std::vector<std::uint64_t> touchedCells;
+
+        // Open lists of bidirectionalAStar.
+        std::vector<std::uint64_t> buckets[4];
+
+    };
+
+    // Algorithms solving into a workspace.
+    enum Algorithm {WallFollower, BidirectionalAStar};
+
+    // Endpoints of a path query.
+    struct Query {
+        std::uint32_t i1;
+        std::uint32_t j1;
+        std::uint32_t i2;
+        std::uint32_t j2;
+    };
+
+    // Length and integral (see Path::integral) of a path found for a query.
+    struct Summary {
+        bool solved;
+        std::uint64_t length;
+        std::int64_t integral;
+    };
+
+    // Find path between given cells using "always turn left" algoritm.
+    // Return empty path with initial point (i1, j1)
+    // if the algorithm finds a loop before finding a solution.
+    template <typename Walls>
+    Path wallFollower(Walls const &walls,
+        std::uint32_t i1, std::uint32_t j1, std::uint32_t i2, std::uint32_t j2,
+        Statistics *statistics = nullptr);
+
+    // As wallFollower above, storing directions of the path in workspace.directions.
+    // Return false if there is no solution.
+    template <typename Walls>
+    bool wallFollower(Walls const &walls,
+        std::uint32_t i1, std::uint32_t j1, std::uint32_t i2, std::uint32_t j2,
+        Workspace &workspace, Statistics *statistics = nullptr);
+
+    // Find a shortest path between given cells using breadth-first search, in which
+    // the frontier and the visited cells are kept as row bitsets and expanded one
+    // 64-bit word at a time. Walls must also provide getRowWords(), verticalWalls(i)
+    // and horizontalWalls(i) as in Maze. Levels with many active words are expanded
+    // by up to threadCount threads (all hardware threads if threadCount = 0).
+    // Return empty path with initial point (i1, j1) if there is no solution.
+    template <typename Walls>
+    Path breadthFirst(Walls const &walls,
+        std::uint32_t i1, std::uint32_t j1, std::uint32_t i2, std::uint32_t j2,
+        std::uint32_t threadCount = 1, Statistics *statistics = nullptr);
+
+    // Find a shortest path between given cells using bidirectional A* search with
+    // the Manhattan distance heuristic. Open lists are bucketed by f-cost, and each
+    // cell keeps only a closed bit and a 2-bit parent direction per search direction.
+    // Return empty path with initial point (i1, j1) if there is no solution.
+    template <typename Walls>
+    Path bidirectionalAStar(Walls const &walls,
+        std::uint32_t i1, std::uint32_t j1, std::uint32_t i2, std::uint32_t j2,
+        Statistics *statistics = nullptr);
+
+    // As bidirectionalAStar above, storing directions of the path in workspace.directions.
+    // Return false if there is no solution.
+    template <typename Walls>
+    bool bidirectionalAStar(Walls const &walls,
+        std::uint32_t i1, std::uint32_t j1, std::uint32_t i2, std::uint32_t j2,
+        Workspace &workspace, Statistics *statistics = nullptr);
+
+    // As bidirectionalAStar, but keep the closed bits and parent directions in pages
+    // of 64 x 64 cells allocated when the search reaches them (see PagedBitPlanes),
+    // so that memory follows the number of expanded cells instead of the maze size.
+    // Slower than bidirectionalAStar; meant for mazes which are not held in memory.
+    template <typename Walls>
+    Path pagedBidirectionalAStar(Walls const &walls,
+        std::uint32_t i1, std::uint32_t j1, std::uint32_t i2, std::uint32_t j2,
+        Statistics *statistics = nullptr);
+
+    // As pagedBidirectionalAStar above, storing directions of the path in workspace.directions.
+    // Return false if there is no solution.
+    template <typename Walls>
+    bool pagedBidirectionalAStar(Walls const &walls,
+        std::uint32_t i1, std::uint32_t j1, std::uint32_t i2, std::uint32_t j2,
+        Workspace &workspace, Statistics *statistics = nullptr);
+
+    // Search of bidirectionalAStar and pagedBidirectionalAStar, with closed bits and parent
+    // directions in 6 planes of cells (BitPlanes or PagedBitPlanes of the maze size,
+    // all bits cleared), which are cleared again before returning.
+    template <typename Walls, typename Cells>
+    bool bidirectionalSearch(Walls const &walls,
+        std::uint32_t i1, std::uint32_t j1, std::uint32_t i2, std::uint32_t j2,
+        Cells &cells, Workspace &workspace, Statistics *statistics);
+
+    // Clear the words of cells containing given cells (indices i * width + j).
+    void clearSearchCells(BitPlanes &cells, std::vector<std::uint64_t> const &touchedCells);
+
+    void clearSearchCells(PagedBitPlanes &cells, std::vector<std::uint64_t> const &touchedCells);
+
+    // Solve queries using given algorithm, spread among up to threadCount threads
+    // (all hardware threads if threadCount = 0), each with its own workspace.
+    // BidirectionalAStar runs pagedBidirectionalAStar, so that the memory of each
+    // thread follows the cells its queries expand rather than the maze size.
+    // After solving the k-th query, call function(k, solved, workspace)
+    // from the solving thread.
+    template <typename Walls, typename Function>
+    void solveBatch(Walls const &walls, std::vector<Query> const &queries,
+        Algorithm algorithm, std::uint32_t threadCount, Function const &function);
+
+}
+
+template <typename Walls>
+Path MazeSolver::wallFollower(Walls const &walls,
+    std::uint32_t i1, std::uint32_t j1, std::uint32_t i2, std::uint32_t j2,
+    Statistics *statistics)
+{
+    Workspace workspace;
+    wallFollower(walls, i1, j1, i2, j2, workspace, statistics);
+    return {walls.getHeight(), walls.getWidth(), i1, j1, workspace.directions};
+}
+
+template <typename Walls>
+bool MazeSolver::wallFollower(Walls const &walls,
+    std::uint32_t i1, std::uint32_t j1, std::uint32_t i2, std::uint32_t j2,
+    Workspace &workspace, Statistics *statistics)
+{
+    Path::Directions &directions = workspace.directions;
+    directions.clear();
+    std::uint64_t expandedCells = 1;
+    if (i1 == i2 && j1 == j2) {
+        if (statistics != nullptr) {
+            statistics->expandedCells = expandedCells;
+        }
+        return true;
+    }
+    Path::Direction initialDirections[4];
+    std::uint32_t initialDirectionCount = 0;
+    for (Path::Direction direction : {Path::Up, Path::Down, Path::Left, Path::Right}) {
+        if (!walls.hasWall(i1, j1, direction)) {
+            initialDirections[initialDirectionCount++] = direction;
+        }
+    }
+    for (std::uint32_t k = 0; k < initialDirectionCount; k++) {
+        Path::Direction initialDirection = initialDirections[k];
+        std::uint32_t i = i1;
+        std::uint32_t j = j1;
+        directions.clear();
+        directions.push(initialDirection);
+        Path::Direction direction;
+        switch (initialDirection) {
+            case Path::Up:
+                i--;
+                expandedCells++;
+                direction = Path::Left;
+                break;
+            case Path::Down:
+                i++;
+                expandedCells++;
+                direction = Path::Right;
+                break;
+            case Path::Left:
+                j--;
+                expandedCells++;
+                direction = Path::Down;
+                break;
+            case Path::Right:
+                j++;
+                expandedCells++;
+                direction = Path::Up;
+        }
+        while ((i != i1 || j != j1) && (i != i2 || j != j2)) {
+            if (direction == Path::Up) {
+                if (!walls.hasWall(i, j, Path::Up)) {
+                    if (directions.back() == Path::Down) {
+                        directions.pop();
+                        Metrics::add(Metrics::SolveBacktracks);
+                    }
+                    else {
+                        directions.push(Path::Up);
+                    }
+                    i--;
+                    expandedCells++;
+                    direction = Path::Left;
+                }
+                else {
+                    direction = Path::Right;
+                }
+            }
+            else if (direction == Path::Down) {
+                if (!walls.hasWall(i, j, Path::Down)) {
+                    if (directions.back() == Path::Up) {
+                        directions.pop();
+                        Metrics::add(Metrics::SolveBacktracks);
+                    }
+                    else {
+                        directions.push(Path::Down);
+                    }
+                    i++;
+                    expandedCells++;
+                    direction = Path::Right;
+                }
+                else {
+                    direction = Path::Left;
+                }
+            }
+            else if (direction == Path::Left) {
+                if (!walls.hasWall(i, j, Path::Left)) {
+                    if (directions.back() == Path::Right) {
+                        directions.pop();
+                        Metrics::add(Metrics::SolveBacktracks);
+                    }
+                    else {
+                        directions.push(Path::Left);
+                    }
+                    j--;
+                    expandedCells++;
+                    direction = Path::Down;
+                }
+                else {
+                    direction = Path::Up;
+                }
+            }
+            else {
+                if (!walls.hasWall(i, j, Path::Right)) {
+                    if (directions.back() == Path::Left) {
+                        directions.pop();
+                        Metrics::add(Metrics::SolveBacktracks);
+                    }
+                    else {
+                        directions.push(Path::Right);
+                    }
+                    j++;
+                    expandedCells++;
+                    direction = Path::Up;
+                }
+                else {
+                    direction = Path::Down;
+                }
+            }
+        }
+        if (i == i2 && j == j2) {
+            Metrics::add(Metrics::SolveVisitedCells, expandedCells);
+            if (statistics != nullptr) {
+                statistics->expandedCells = expandedCells;
+            }
+            return true;
+        }
+    }
+    directions.clear();
+    Metrics::add(Metrics::SolveVisitedCells, expandedCells);
+    if (statistics != nullptr) {
+        statistics->expandedCells = expandedCells;
+    }
+    return false;
+}
+
+template <typename Walls>
+Path MazeSolver::breadthFirst(Walls const &walls,
+    std::uint32_t i1, std::uint32_t j1, std::uint32_t i2, std::uint32_t j2,
+    std::uint32_t threadCount, Statistics *statistics)
+{
+    std::uint32_t height = walls.getHeight();
+    std::uint32_t width = walls.getWidth();
+    if (statistics != nullptr) {
+        statistics->expandedCells = 0;
+    }
+    if (i1 >= height || j1 >= width || i2 >= height || j2 >= width) {
+        return {height, width, i1, j1, Path::Directions{}};
+    }
+    // Planes of the search. Bits of planes Parent0 and Parent1 of a visited cell
+    // hold the direction of the step into the cell. Frontier planes alternate between levels.
+    enum SearchPlane {Visited, Parent0, Parent1, Frontier0, Frontier1};
+    BitPlanes search(height, width, 5);
+    std::uint32_t words = search.getUsedRowWords();
+    std::uint64_t lastMask = (width & 63) == 0 ? ~static_cast<std::uint64_t>(0) :
+        (static_cast<std::uint64_t>(1) << (width & 63)) - 1;
+    struct Word {
+        std::uint32_t row;
+        std::uint32_t word;
+    };
+    std::vector<Word> frontier{{i1, j1 >> 6}};
+    std::vector<Word> candidates;
+    std::vector<std::uint8_t> isCandidate;
+    search.set(i1, j1, Visited, true);
+    search.set(i1, j1, Frontier0, true);
+    std::uint32_t current = Frontier0;
+    // Compute words [begin, end) of candidates in the next frontier from their
+    // neighbourhood in the current frontier, appending nonempty words to reached.
+    auto pull = [&](std::uint64_t begin, std::uint64_t end, std::vector<Word> &reached) {
+        std::uint32_t next = current ^ Frontier0 ^ Frontier1;
+        for (std::uint64_t k = begin; k < end; k++) {
+            std::uint32_t i = candidates[k].row;
+            std::uint32_t w = candidates[k].word;
+            std::uint64_t const *frontierRow = search.row(i, current);
+            std::uint64_t const *verticalRow = walls.verticalWalls(i);
+            std::uint64_t rightNeighbours = frontierRow[w] >> 1;
+            std::uint64_t rightWalls = verticalRow[w] >> 1;
+            if (w + 1 < words) {
+                rightNeighbours |= frontierRow[w + 1] << 63;
+                rightWalls |= verticalRow[w + 1] << 63;
+            }
+            std::uint64_t leftNeighbours = frontierRow[w] << 1;
+            if (w != 0) {
+                leftNeighbours |= frontierRow[w - 1] >> 63;
+            }
+            std::uint64_t mask = ~search.row(i, Visited)[w];
+            if (w == words - 1) {
+                mask &= lastMask;
+            }
+            std::uint64_t down = i == 0 ? 0 :
+                search.row(i - 1, current)[w] & ~walls.horizontalWalls(i)[w] & mask;
+            mask &= ~down;
+            std::uint64_t up = i == height - 1 ? 0 :
+                search.row(i + 1, current)[w] & ~walls.horizontalWalls(i + 1)[w] & mask;
+            mask &= ~up;
+            std::uint64_t right = leftNeighbours & ~verticalRow[w] & mask;
+            mask &= ~right;
+            std::uint64_t left = rightNeighbours & ~rightWalls & mask;
+            std::uint64_t reachedBits = down | up | right | left;
+            if (reachedBits == 0) {
+                continue;
+            }
+            // Directions Up, Down, Left, Right are 0, 1, 2, 3.
+            search.row(i, Parent0)[w] |= down | right;
+            search.row(i, Parent1)[w] |= left | right;
+            search.row(i, Visited)[w] |= reachedBits;
+            search.row(i, next)[w] = reachedBits;
+            reached.push_back({i, w});
+        }
+    };
+    // Add reachedBits of the word w in the i-th row to the next frontier,
+    // reached by steps in given direction.
+    auto reach = [&](std::uint32_t i, std::uint32_t w, std::uint64_t reachedBits,
+        Path::Direction direction, std::vector<Word> &reached)
+    {
+        std::uint64_t &visited = search.row(i, Visited)[w];
+        reachedBits &= ~visited;
+        if (reachedBits == 0) {
+            return;
+        }
+        visited |= reachedBits;
+        if (direction & 1) {
+            search.row(i, Parent0)[w] |= reachedBits;
+        }
+        if (direction & 2) {
+            search.row(i, Parent1)[w] |= reachedBits;
+        }
+        std::uint64_t &next = search.row(i, current ^ Frontier0 ^ Frontier1)[w];
+        if (next == 0) {
+            reached.push_back({i, w});
+        }
+        next |= reachedBits;
+    };
+    // Expand a word of the frontier into its own and neighbouring words.
+    auto push = [&](Word const &word, std::vector<Word> &reached) {
+        std::uint32_t i = word.row;
+        std::uint32_t w = word.word;
+        std::uint64_t bits = search.row(i, current)[w];
+        std::uint64_t const *verticalRow = walls.verticalWalls(i);
+        if (i != 0) {
+            reach(i - 1, w, bits & ~walls.horizontalWalls(i)[w], Path::Up, reached);
+        }
+        if (i != height - 1) {
+            reach(i + 1, w, bits & ~walls.horizontalWalls(i + 1)[w], Path::Down, reached);
+        }
+        std::uint64_t rightWalls = verticalRow[w] >> 1;
+        if (w + 1 < words) {
+            rightWalls |= verticalRow[w + 1] << 63;
+        }
+        std::uint64_t right = (bits << 1) & ~verticalRow[w];
+        if (w == words - 1) {
+            right &= lastMask;
+        }
+        reach(i, w, right, Path::Right, reached);
+        reach(i, w, (bits >> 1) & ~rightWalls, Path::Left, reached);
+        if (w + 1 < words && (bits >> 63) != 0 && (verticalRow[w + 1] & 1) == 0) {
+            reach(i, w + 1, 1, Path::Right, reached);
+        }
+        if (w != 0 && (bits & 1) != 0 && (verticalRow[w] & 1) == 0) {
+            reach(i, w - 1, static_cast<std::uint64_t>(1) << 63, Path::Left, reached);
+        }
+    };
+    // Levels with fewer frontier words are expanded by a single thread.
+    std::uint32_t parallelThreshold = 1 << 12;
+    std::uint32_t blockSize = 1 << 12;
+    threadCount = Utilities::threadCount(threadCount);
+    while (!search.get(i2, j2, Visited)) {
+        if (frontier.empty()) {
+            return {height, width, i1, j1, Path::Directions{}};
+        }
+        std::vector<Word> nextFrontier;
+        if (frontier.size() < parallelThreshold || threadCount == 1) {
+            for (Word const &word : frontier) {
+                push(word, nextFrontier);
+            }
+        }
+        else {
+            // Expanding into distinct destination words makes the threads independent.
+            candidates.clear();
+            isCandidate.resize(static_cast<std::uint64_t>(height) * words, 0);
+            auto addCandidate = [&](std::uint32_t i, std::uint32_t w) {
+                std::uint8_t &flag = isCandidate[static_cast<std::uint64_t>(i) * words + w];
+                if (flag == 0) {
+                    flag = 1;
+                    candidates.push_back({i, w});
+                }
+            };
+            for (Word const &word : frontier) {
+                addCandidate(word.row, word.word);
+                if (word.row != 0) {
+                    addCandidate(word.row - 1, word.word);
+                }
+                if (word.row != height - 1) {
+                    addCandidate(word.row + 1, word.word);
+                }
+                if (word.word != 0) {
+                    addCandidate(word.row, word.word - 1);
+                }
+                if (word.word != words - 1) {
+                    addCandidate(word.row, word.word + 1);
+                }
+            }
+            std::uint64_t blockCount = (candidates.size() + blockSize - 1) / blockSize;
+            std::vector<std::vector<Word>> reached(blockCount);
+            Utilities::parallelFor(candidates.size(), blockSize, threadCount,
+                [&](std::uint64_t begin, std::uint64_t end) {
+                    pull(begin, end, reached[begin / blockSize]);
+                });
+            for (std::vector<Word> const &block : reached) {
+                nextFrontier.insert(nextFrontier.end(), block.begin(), block.end());
+            }
+            for (Word const &word : candidates) {
+                isCandidate[static_cast<std::uint64_t>(word.row) * words + word.word] = 0;
+            }
+        }
+        for (Word const &word : frontier) {
+            std::uint64_t &bits = search.row(word.row, current)[word.word];
+            if (statistics != nullptr) {
+                statistics->expandedCells += BitPlanes::bitCount(bits);
+            }
+            bits = 0;
+        }
+        frontier.swap(nextFrontier);
+        current ^= Frontier0 ^ Frontier1;
+    }
+    Path::Directions directions;
+    std::uint32_t i = i2;
+    std::uint32_t j = j2;
+    while (i != i1 || j != j1) {
+        Path::Direction direction = static_cast<Path::Direction>(
+            search.get(i, j, Parent0) | (search.get(i, j, Parent1) << 1));
+        directions.push(direction);
+        switch (direction) {
+            case Path::Up:
+                i++;
+                break;
+            case Path::Down:
+                i--;
+                break;
+            case Path::Left:
+                j++;
+                break;
+            default:
+                j--;
+        }
+    }
+    directions.reverse();
+    return {height, width, i1, j1, directions};
+}
+
+
+template <typename Walls>
+Path MazeSolver::bidirectionalAStar(Walls const &walls,
+    std::uint32_t i1, std::uint32_t j1, std::uint32_t i2, std::uint32_t j2,
+    Statistics *statistics)
+{
+    Workspace workspace;
+    bidirectionalAStar(walls, i1, j1, i2, j2, workspace, statistics);
+    return {walls.getHeight(), walls.getWidth(), i1, j1, workspace.directions};
+}
+
+template <typename Walls>
+bool MazeSolver::bidirectionalAStar(Walls const &walls,
+    std::uint32_t i1, std::uint32_t j1, std::uint32_t i2, std::uint32_t j2,
+    Workspace &workspace, Statistics *statistics)
+{
+    std::uint32_t height = walls.getHeight();
+    std::uint32_t width = walls.getWidth();
+    BitPlanes &cells = workspace.cells;
+    if (cells.getHeight() != height || cells.getWidth() != width || cells.getPlaneCount() != 6) {
+        cells = BitPlanes(height, width, 6);
+    }
+    return bidirectionalSearch(walls, i1, j1, i2, j2, cells, workspace, statistics);
+}
+
+template <typename Walls>
+Path MazeSolver::pagedBidirectionalAStar(Walls const &walls,
+    std::uint32_t i1, std::uint32_t j1, std::uint32_t i2, std::uint32_t j2,
+    Statistics *statistics)
+{
+    Workspace workspace;
+    pagedBidirectionalAStar(walls, i1, j1, i2, j2, workspace, statistics);
+    return {walls.getHeight(), walls.getWidth(), i1, j1, workspace.directions};
+}
+
+template <typename Walls>
+bool MazeSolver::pagedBidirectionalAStar(Walls const &walls,
+    std::uint32_t i1, std::uint32_t j1, std::uint32_t i2, std::uint32_t j2,
+    Workspace &workspace, Statistics *statistics)
+{
+    std::uint32_t height = walls.getHeight();
+    std::uint32_t width = walls.getWidth();
+    PagedBitPlanes &cells = workspace.pagedCells;
+    if (cells.getHeight() != height || cells.getWidth() != width || cells.getPlaneCount() != 6) {
+        cells = PagedBitPlanes(height, width, 6);
+    }
+    return bidirectionalSearch(walls, i1, j1, i2, j2, cells, workspace, statistics);
+}
+
+template <typename Walls, typename Cells>
+bool MazeSolver::bidirectionalSearch(Walls const &walls,
+    std::uint32_t i1, std::uint32_t j1, std::uint32_t i2, std::uint32_t j2,
+    Cells &cells, Workspace &workspace, Statistics *statistics)
+{
+    std::uint32_t height = walls.getHeight();
+    std::uint32_t width = walls.getWidth();
+    Path::Directions &directions = workspace.directions;
+    directions.clear();
+    if (statistics != nullptr) {
+        statistics->expandedCells = 0;
+    }
+    if (i1 >= height || j1 >= width || i2 >= height || j2 >= width) {
+        return false;
+    }
+    if (i1 == i2 && j1 == j2) {
+        return true;
+    }
+    // Search from (i1, j1) towards (i2, j2) or vice versa. The parent planes
+    // of a closed cell hold the direction of the step into the cell.
+    // Since the heuristic is consistent and steps have unit cost, a step changes f
+    // by 0 or 2, so only the buckets with f and f + 2 are ever nonempty.
+    // Entries of the buckets are cell indices shifted by 2, with the step direction.
+    struct Search {
+        std::uint32_t closed;
+        std::uint32_t parent0;
+        std::uint32_t parent1;
+        std::uint32_t targetRow;
+        std::uint32_t targetColumn;
+        std::uint64_t f;
+        std::vector<std::uint64_t> &bucket;
+        std::vector<std::uint64_t> &nextBucket;
+    };
+    std::vector<std::uint64_t> &touchedCells = workspace.touchedCells;
+    touchedCells.clear();
+    for (std::vector<std::uint64_t> &bucket : workspace.buckets) {
+        bucket.clear();
+    }
+    auto distance = [](std::uint32_t i, std::uint32_t j, std::uint32_t k, std::uint32_t l) {
+        return static_cast<std::uint64_t>(i > k ? i - k : k - i) + (j > l ? j - l : l - j);
+    };
+    Search searches[2] = {
+        {0, 1, 2, i2, j2, distance(i1, j1, i2, j2), workspace.buckets[0], workspace.buckets[1]},
+        {3, 4, 5, i1, j1, distance(i1, j1, i2, j2), workspace.buckets[2], workspace.buckets[3]}
+    };
+    // Starting entries have direction Up, which is never followed back.
+    searches[0].bucket.push_back((static_cast<std::uint64_t>(i1) * width + j1) << 2);
+    searches[1].bucket.push_back((static_cast<std::uint64_t>(i2) * width + j2) << 2);
+    // Number of steps from a closed cell to the start of a search,
+    // or limit if it is at least limit.
+    auto closedDistance = [&](Search const &search, std::uint32_t i, std::uint32_t j,
+        std::uint64_t limit)
+    {
+        std::uint32_t startRow = &search == searches ? i1 : i2;
+        std::uint32_t startColumn = &search == searches ? j1 : j2;
+        std::uint64_t steps = 0;
+        while (i != startRow || j != startColumn) {
+            if (steps + distance(i, j, startRow, startColumn) >= limit) {
+                return limit;
+            }
+            switch (cells.get(i, j, search.parent0) | (cells.get(i, j, search.parent1) << 1)) {
+                case Path::Up:
+                    i++;
+                    break;
+                case Path::Down:
+                    i--;
+                    break;
+                case Path::Left:
+                    j++;
+                    break;
+                default:
+                    j--;
+            }
+            steps++;
+        }
+        return steps;
+    };
+    // Length of the shortest path found so far, and its step between
+    // a cell closed by the forward search and a cell closed by the backward search.
+    std::uint64_t best = UINT64_MAX;
+    std::uint32_t meetRow = 0;
+    std::uint32_t meetColumn = 0;
+    Path::Direction meetDirection = Path::Up;
+    while (true) {
+        for (Search &search : searches) {
+            if (search.bucket.empty() && !search.nextBucket.empty()) {
+                search.bucket.swap(search.nextBucket);
+                search.f += 2;
+            }
+        }
+        if (searches[0].bucket.empty() || searches[1].bucket.empty() ||
+            best <= std::max(searches[0].f, searches[1].f))
+        {
+            break;
+        }
+        // Expand the search with fewer open entries, but close both starts first,
+        // so that a search exploring its whole component meets the other one.
+        std::uint32_t side = searches[0].bucket.size() + searches[0].nextBucket.size() <=
+            searches[1].bucket.size() + searches[1].nextBucket.size() ? 0 : 1;
+        if (!cells.get(i2, j2, searches[1].closed)) {
+            side = cells.get(i1, j1, searches[0].closed) ? 1 : 0;
+        }
+        Search &search = searches[side];
+        Search &other = searches[side ^ 1];
+        std::uint64_t entry = search.bucket.back();
+        search.bucket.pop_back();
+        std::uint32_t i = static_cast<std::uint32_t>((entry >> 2) / width);
+        std::uint32_t j = static_cast<std::uint32_t>((entry >> 2) % width);
+        if (cells.get(i, j, search.closed)) {
+            continue;
+        }
+        cells.set(i, j, search.closed, true);
+        touchedCells.push_back(entry >> 2);
+        cells.set(i, j, search.parent0, entry & 1);
+        cells.set(i, j, search.parent1, (entry >> 1) & 1);
+        // Paths through a cell closed by the other search are already accounted for.
+        if (cells.get(i, j, other.closed)) {
+            continue;
+        }
+        if (statistics != nullptr) {
+            statistics->expandedCells++;
+        }
+        std::uint64_t g = search.f - distance(i, j, search.targetRow, search.targetColumn);
+        for (std::uint32_t d = 0; d < 4; d++) {
+            Path::Direction direction = static_cast<Path::Direction>(d);
+            if (walls.hasWall(i, j, direction)) {
+                continue;
+            }
+            std::uint32_t k = direction == Path::Up ? i - 1 : direction == Path::Down ? i + 1 : i;
+            std::uint32_t l = direction == Path::Left ? j - 1 : direction == Path::Right ? j + 1 : j;
+            if (cells.get(k, l, search.closed)) {
+                continue;
+            }
+            if (cells.get(k, l, other.closed)) {
+                std::uint64_t length = g + 1 + closedDistance(other, k, l,
+                    best == UINT64_MAX ? UINT64_MAX : best - g - 1);
+                if (length < best) {
+                    best = length;
+                    // Store the step in the forward direction.
+                    if (side == 0) {
+                        meetRow = i;
+                        meetColumn = j;
+                        meetDirection = direction;
+                    }
+                    else {
+                        meetRow = k;
+                        meetColumn = l;
+                        meetDirection = static_cast<Path::Direction>(d ^ 1);
+                    }
+                }
+            }
+            std::uint64_t next = ((static_cast<std::uint64_t>(k) * width + l) << 2) | d;
+            if (distance(k, l, search.targetRow, search.targetColumn) <
+                distance(i, j, search.targetRow, search.targetColumn))
+            {
+                search.bucket.push_back(next);
+            }
+            else {
+                search.nextBucket.push_back(next);
+            }
+        }
+    }
+    if (best == UINT64_MAX) {
+        clearSearchCells(cells, touchedCells);
+        return false;
+    }
+    // Follow forward parents back to (i1, j1), then backward parents on to (i2, j2).
+    std::uint32_t i = meetRow;
+    std::uint32_t j = meetColumn;
+    while (i != i1 || j != j1) {
+        Path::Direction direction = static_cast<Path::Direction>(
+            cells.get(i, j, searches[0].parent0) | (cells.get(i, j, searches[0].parent1) << 1));
+        directions.push(direction);
+        switch (direction) {
+            case Path::Up:
+                i++;
+                break;
+            case Path::Down:
+                i--;
+                break;
+            case Path::Left:
+                j++;
+                break;
+            default:
+                j--;
+        }
+    }
+    directions.reverse();
+    directions.push(meetDirection);
+    i = meetRow;
+    j = meetColumn;
+    switch (meetDirection) {
+        case Path::Up:
+            i--;
+            break;
+        case Path::Down:
+            i++;
+            break;
+        case Path::Left:
+            j--;
+            break;
+        default:
+            j++;
+    }
+    while (i != i2 || j != j2) {
+        // Directions Up, Down (Left, Right) are opposite when they differ in the lowest bit.
+        Path::Direction direction = static_cast<Path::Direction>(1 ^
+            (cells.get(i, j, searches[1].parent0) | (cells.get(i, j, searches[1].parent1) << 1)));
+        directions.push(direction);
+        switch (direction) {
+            case Path::Up:
+                i--;
+                break;
+            case Path::Down:
+                i++;
+                break;
+            case Path::Left:
+                j--;
+                break;
+            default:
+                j++;
+        }
+    }
+    clearSearchCells(cells, touchedCells);
+    return true;
+}
+
+inline void MazeSolver::clearSearchCells(BitPlanes &cells,
+    std::vector<std::uint64_t> const &touchedCells)
+{
+    // Clear words of the planes containing closed cells, for the next query.
+    std::uint32_t width = cells.getWidth();
+    for (std::uint64_t cell : touchedCells) {
+        std::uint32_t i = static_cast<std::uint32_t>(cell / width);
+        std::uint32_t j = static_cast<std::uint32_t>(cell % width);
+        for (std::uint32_t plane = 0; plane < cells.getPlaneCount(); plane++) {
+            cells.row(i, plane)[j >> 6] = 0;
+        }
+    }
+}
+
+inline void MazeSolver::clearSearchCells(PagedBitPlanes &cells, std::vector<std::uint64_t> const &)
+{
+    cells.clear();
+}
+
+template <typename Walls, typename Function>
+void MazeSolver::solveBatch(Walls const &walls, std::vector<Query> const &queries,
+    Algorithm algorithm, std::uint32_t threadCount, Function const &function)
+{
+    threadCount = static_cast<std::uint32_t>(std::max<std::uint64_t>(
+        std::min<std::uint64_t>(Utilities::threadCount(threadCount), queries.size()), 1));
+    std::vector<Workspace> workspaces(threadCount);
+    // Small blocks balance queries of very different lengths.
+    Utilities::indexedParallelFor(queries.size(), 16, threadCount,
+        [&](std::uint32_t thread, std::uint64_t begin, std::uint64_t end) {
+            Workspace &workspace = workspaces[thread];
+            for (std::uint64_t k = begin; k < end; k++) {
+                Query const &query = queries[k];
+                bool solved = algorithm == WallFollower ?
+                    wallFollower(walls, query.i1, query.j1, query.i2, query.j2, workspace) :
+                    pagedBidirectionalAStar(walls,
+                        query.i1, query.j1, query.i2, query.j2, workspace);
+                function(k, solved, workspace);
+            }
+        });
+}
+
+#endif
\ No newline at end of file
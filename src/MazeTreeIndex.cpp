@@ -0,0 +1,184 @@
+#include <cstdint>
+#include <vector>
+#include <utility>
+#include <algorithm>
+#include <Path.h>
+#include <Maze.h>
+#include <MazeTreeIndex.h>
+
+MazeTreeIndex::MazeTreeIndex(Maze const &maze) :
+    m_height{maze.getHeight()},
+    m_width{maze.getWidth()}
+{
+    std::uint64_t cellCount = static_cast<std::uint64_t>(m_height) * m_width;
+    if (cellCount > UINT32_MAX) {
+        return;
+    }
+    m_parents.assign(cellCount, NoParent);
+    m_depths.assign(cellCount, 0);
+    // Subtree sizes are accumulated in m_heads, which are filled in afterwards.
+    m_heads.assign(cellCount, 1);
+    // Breadth-first search from every cell not reached yet, with the queue
+    // kept as the visiting order of all cells.
+    std::vector<std::uint32_t> order;
+    order.reserve(cellCount);
+    std::vector<bool> visited(cellCount, false);
+    for (std::uint32_t root = 0; root < cellCount; root++) {
+        if (visited[root]) {
+            continue;
+        }
+        visited[root] = true;
+        order.push_back(root);
+        for (std::uint64_t k = order.size() - 1; k < order.size(); k++) {
+            std::uint32_t cell = order[k];
+            std::uint32_t i = cell / m_width;
+            std::uint32_t j = cell % m_width;
+            for (std::uint8_t d = 0; d < 4; d++) {
+                Path::Direction direction = static_cast<Path::Direction>(d);
+                if (maze.hasWall(i, j, direction)) {
+                    continue;
+                }
+                std::uint32_t neighbour =
+                    direction == Path::Up ? cell - m_width :
+                    direction == Path::Down ? cell + m_width :
+                    direction == Path::Left ? cell - 1 : cell + 1;
+                if (visited[neighbour]) {
+                    continue;
+                }
+                visited[neighbour] = true;
+                // Directions Up, Down (Left, Right) are opposite when they differ in the lowest bit.
+                m_parents[neighbour] = d ^ 1;
+                m_depths[neighbour] = m_depths[cell] + 1;
+                order.push_back(neighbour);
+            }
+        }
+    }
+    // Children follow their parents in the order, so subtree sizes are final
+    // when visited backwards. The heavy child of a cell is its child with the largest subtree.
+    std::vector<std::uint8_t> heavyChildren(cellCount, NoParent);
+    for (std::uint64_t k = cellCount; k-- > 0;) {
+        std::uint32_t cell = order[k];
+        if (m_parents[cell] == NoParent) {
+            continue;
+        }
+        std::uint32_t parentCell = parent(cell);
+        m_heads[parentCell] += m_heads[cell];
+        std::uint8_t &heavyChild = heavyChildren[parentCell];
+        if (heavyChild == NoParent) {
+            heavyChild = m_parents[cell] ^ 1;
+            continue;
+        }
+        std::uint32_t heavyCell =
+            heavyChild == Path::Up ? parentCell - m_width :
+            heavyChild == Path::Down ? parentCell + m_width :
+            heavyChild == Path::Left ? parentCell - 1 : parentCell + 1;
+        if (m_heads[cell] > m_heads[heavyCell]) {
+            heavyChild = m_parents[cell] ^ 1;
+        }
+    }
+    // Parents precede their children, so their heads are known.
+    for (std::uint32_t cell : order) {
+        if (m_parents[cell] == NoParent) {
+            m_heads[cell] = cell;
+            continue;
+        }
+        std::uint32_t parentCell = parent(cell);
+        m_heads[cell] = heavyChildren[parentCell] == (m_parents[cell] ^ 1) ?
+            m_heads[parentCell] : cell;
+    }
+}
+
+std::uint32_t MazeTreeIndex::getHeight() const
+{
+    return m_height;
+}
+
+std::uint32_t MazeTreeIndex::getWidth() const
+{
+    return m_width;
+}
+
+std::uint32_t MazeTreeIndex::parent(std::uint32_t cell) const
+{
+    switch (m_parents[cell]) {
+        case Path::Up:
+            return cell - m_width;
+        case Path::Down:
+            return cell + m_width;
+        case Path::Left:
+            return cell - 1;
+        default:
+            return cell + 1;
+    }
+}
+
+bool MazeTreeIndex::lowestCommonAncestor(std::uint32_t cell1, std::uint32_t cell2,
+    std::uint32_t &ancestor) const
+{
+    while (m_heads[cell1] != m_heads[cell2]) {
+        if (m_depths[m_heads[cell1]] < m_depths[m_heads[cell2]]) {
+            std::swap(cell1, cell2);
+        }
+        // Both heads are roots of different trees.
+        if (m_parents[m_heads[cell1]] == NoParent) {
+            return false;
+        }
+        cell1 = parent(m_heads[cell1]);
+    }
+    ancestor = m_depths[cell1] < m_depths[cell2] ? cell1 : cell2;
+    return true;
+}
+
+bool MazeTreeIndex::connected(std::uint32_t i1, std::uint32_t j1,
+    std::uint32_t i2, std::uint32_t j2) const
+{
+    return distance(i1, j1, i2, j2) != UINT64_MAX;
+}
+
+std::uint64_t MazeTreeIndex::distance(std::uint32_t i1, std::uint32_t j1,
+    std::uint32_t i2, std::uint32_t j2) const
+{
+    if (m_parents.empty() || i1 >= m_height || j1 >= m_width || i2 >= m_height || j2 >= m_width) {
+        return UINT64_MAX;
+    }
+    std::uint32_t cell1 = i1 * m_width + j1;
+    std::uint32_t cell2 = i2 * m_width + j2;
+    std::uint32_t ancestor;
+    if (!lowestCommonAncestor(cell1, cell2, ancestor)) {
+        return UINT64_MAX;
+    }
+    return static_cast<std::uint64_t>(m_depths[cell1]) + m_depths[cell2] -
+        (static_cast<std::uint64_t>(m_depths[ancestor]) << 1);
+}
+
+Path MazeTreeIndex::path(std::uint32_t i1, std::uint32_t j1,
+    std::uint32_t i2, std::uint32_t j2) const
+{
+    std::uint64_t length = distance(i1, j1, i2, j2);
+    if (length == UINT64_MAX) {
+        return {m_height, m_width, i1, j1, Path::Directions{}};
+    }
+    // Walk from both cells up to their common ancestor, which is reached
+    // after the difference of depths plus the same number of steps from each side.
+    std::uint32_t cell1 = i1 * m_width + j1;
+    std::uint32_t cell2 = i2 * m_width + j2;
+    Path::Directions directions;
+    directions.resize(length);
+    std::uint64_t begin = 0;
+    std::uint64_t end = length;
+    while (m_depths[cell1] > m_depths[cell2]) {
+        directions.set(begin++, static_cast<Path::Direction>(m_parents[cell1]));
+        cell1 = parent(cell1);
+    }
+    while (m_depths[cell2] > m_depths[cell1]) {
+        directions.set(--end, static_cast<Path::Direction>(m_parents[cell2] ^ 1));
+        cell2 = parent(cell2);
+    }
+    while (cell1 != cell2) {
+        directions.set(begin++, static_cast<Path::Direction>(m_parents[cell1]));
+        cell1 = parent(cell1);
+        directions.set(--end, static_cast<Path::Direction>(m_parents[cell2] ^ 1));
+        cell2 = parent(cell2);
+    }
+    return {m_height, m_width, i1, j1, directions};
+}
\ No newline at end of file
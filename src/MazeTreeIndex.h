@@ -0,0 +1,66 @@
+#ifndef MAZETREEINDEX_H
+#define MAZETREEINDEX_H
+
+#include <cstdint>
+#include <vector>
+#include <Path.h>
+#include <Maze.h>
+
+// Index answering path queries between cells of a maze in O(log(m n)) time
+// after a single O(m n) build. The index stores a breadth-first spanning forest
+// of the maze, decomposed into heavy paths for lowest common ancestor queries.
+// For tree mazes, where each two cells are connected by exactly one path,
+// the returned paths are the solutions. For mazes with loops, they are valid
+// paths within the spanning forest, but not necessarily the shortest ones.
+// The maze must have fewer than 2^32 cells, otherwise the index is empty.
+class MazeTreeIndex {
+
+    // Height.
+    std::uint32_t m_height;
+
+    // Width.
+    std::uint32_t m_width;
+
+    // Marker of roots in m_parents.
+    static constexpr std::uint8_t NoParent = 4;
+
+    // Direction from each cell (with index i * width + j) to its parent, or NoParent.
+    std::vector<std::uint8_t> m_parents;
+
+    // Distance of each cell from the root of its tree.
+    std::vector<std::uint32_t> m_depths;
+
+    // Index of the topmost cell of the heavy path containing each cell.
+    std::vector<std::uint32_t> m_heads;
+
+    // Index of the parent of a cell, which is not a root.
+    std::uint32_t parent(std::uint32_t cell) const;
+
+    // Compute the lowest common ancestor of two cells.
+    // Return false if the cells are in different trees.
+    bool lowestCommonAncestor(std::uint32_t cell1, std::uint32_t cell2,
+        std::uint32_t &ancestor) const;
+
+public:
+
+    // Build the index of a maze.
+    MazeTreeIndex(Maze const &maze);
+
+    std::uint32_t getHeight() const;
+
+    std::uint32_t getWidth() const;
+
+    // Return true if given cells are connected.
+    bool connected(std::uint32_t i1, std::uint32_t j1, std::uint32_t i2, std::uint32_t j2) const;
+
+    // Length of the path between given cells, or UINT64_MAX if they are not connected.
+    std::uint64_t distance(std::uint32_t i1, std::uint32_t j1,
+        std::uint32_t i2, std::uint32_t j2) const;
+
+    // Path between given cells, built in time proportional to its length.
+    // Return empty path with initial point (i1, j1) if the cells are not connected.
+    Path path(std::uint32_t i1, std::uint32_t j1, std::uint32_t i2, std::uint32_t j2) const;
+
+};
+
+#endif
\ No newline at end of file
@@ -0,0 +1,108 @@
+#include <cstdint>
+#include <string>
+#include <sstream>
+#include <atomic>
+#include <chrono>
+#include <Metrics.h>
+
+namespace {
+
+    std::atomic<std::uint64_t> counterTotals[Metrics::CounterCount];
+
+    // Phase durations in nanoseconds.
+    std::atomic<std::int64_t> phaseTotals[Metrics::PhaseCount];
+
+    char const *const counterNames[Metrics::CounterCount] = {
+        "poolGets",
+        "poolGetHops",
+        "poolJoins",
+        "poolPops",
+        "pathSteps",
+        "pathExtensionCalls",
+        "pathExtensionRejections",
+        "pathExtensionBorderCases",
+        "pathExtensionTableAccepts",
+        "loopParameterCalls",
+        "loopParameterPositive",
+        "solveVisitedCells",
+        "solveBacktracks"
+    };
+
+    char const *const phaseNames[Metrics::PhaseCount] = {
+        "load",
+        "generate",
+        "solve",
+        "encode",
+        "write"
+    };
+
+}
+
+Metrics::ThreadCounters::~ThreadCounters()
+{
+    for (std::uint32_t k = 0; k < CounterCount; k++) {
+        counterTotals[k].fetch_add(values[k], std::memory_order_relaxed);
+    }
+}
+
+void Metrics::addDuration(Phase phase, std::chrono::steady_clock::duration duration)
+{
+    phaseTotals[phase].fetch_add(
+        std::chrono::duration_cast<std::chrono::nanoseconds>(duration).count(),
+        std::memory_order_relaxed);
+}
+
+std::uint64_t Metrics::count(Counter counter)
+{
+#ifdef LAMASO_METRICS
+    return counterTotals[counter].load(std::memory_order_relaxed) +
+        threadCounters.values[counter];
+#else
+    return counterTotals[counter].load(std::memory_order_relaxed);
+#endif
+}
+
+double Metrics::milliseconds(Phase phase)
+{
+    return phaseTotals[phase].load(std::memory_order_relaxed) / 1e6;
+}
+
+void Metrics::reset()
+{
+    for (std::uint32_t k = 0; k < CounterCount; k++) {
+        counterTotals[k].store(0, std::memory_order_relaxed);
+#ifdef LAMASO_METRICS
+        threadCounters.values[k] = 0;
+#endif
+    }
+    for (std::uint32_t k = 0; k < PhaseCount; k++) {
+        phaseTotals[k].store(0, std::memory_order_relaxed);
+    }
+}
+
+char const *Metrics::counterName(Counter counter)
+{
+    return counterNames[counter];
+}
+
+char const *Metrics::phaseName(Phase phase)
+{
+    return phaseNames[phase];
+}
+
+std::string Metrics::toJSON()
+{
+    std::ostringstream stream;
+    stream << "{\"enabled\": " << (enabled ? "true" : "false") << ", \"counters\": {";
+    for (std::uint32_t k = 0; k < CounterCount; k++) {
+        stream << (k == 0 ? "" : ", ") << '"' << counterNames[k] << "\": " <<
+            count(static_cast<Counter>(k));
+    }
+    stream << "}, \"phasesMs\": {";
+    for (std::uint32_t k = 0; k < PhaseCount; k++) {
+        stream << (k == 0 ? "" : ", ") << '"' << phaseNames[k] << "\": " <<
+            milliseconds(static_cast<Phase>(k));
+    }
+    stream << "}}";
+    return stream.str();
+}
\ No newline at end of file
@@ -0,0 +1,125 @@
+#ifndef METRICS_H
+#define METRICS_H
+
+#include <cstdint>
+#include <string>
+#include <chrono>
+
+// Counters of hot-path events and accumulated durations of processing phases.
+// They are compiled in only if LAMASO_METRICS is defined (CMake option LAMASO_METRICS);
+// otherwise add and PhaseTimer are empty inline code, and all counters and durations are 0.
+// Counters are collected per thread and added to the totals when a thread exits,
+// so counts of parallel work are complete once its threads have been joined.
+namespace Metrics {
+
+    enum Counter {
+        // Pool::get calls and parent links followed by them.
+        PoolGets,
+        PoolGetHops,
+        // Pool::join and Pool::pop calls.
+        PoolJoins,
+        PoolPops,
+        // Random path steps, pathExtension calls and calls returning false.
+        PathSteps,
+        PathExtensionCalls,
+        PathExtensionRejections,
+        // pathExtension calls settled by the border cases, and by the extension rule
+        // table without loop parameters.
+        PathExtensionBorderCases,
+        PathExtensionTableAccepts,
+        // loopParameter calls and calls returning true.
+        LoopParameterCalls,
+        LoopParameterPositive,
+        // Cells moved to by the wall follower, and moves back to the previous cell.
+        SolveVisitedCells,
+        SolveBacktracks,
+        CounterCount
+    };
+
+    enum Phase {Load, Generate, Solve, Encode, Write, PhaseCount};
+
+#ifdef LAMASO_METRICS
+    constexpr bool enabled = true;
+#else
+    constexpr bool enabled = false;
+#endif
+
+    // Counter values of one thread, added to the totals on thread exit.
+    struct ThreadCounters {
+        std::uint64_t values[CounterCount] = {};
+        ~ThreadCounters();
+    };
+
+#ifdef LAMASO_METRICS
+    inline thread_local ThreadCounters threadCounters;
+#endif
+
+    void add(Counter counter, std::uint64_t value = 1);
+
+    void addDuration(Phase phase, std::chrono::steady_clock::duration duration);
+
+    // Total of a counter, including the calling thread and exited threads.
+    std::uint64_t count(Counter counter);
+
+    // Accumulated duration of a phase in milliseconds.
+    double milliseconds(Phase phase);
+
+    // Set all counters of the calling thread and all totals to 0.
+    void reset();
+
+    char const *counterName(Counter counter);
+
+    char const *phaseName(Phase phase);
+
+    // Counters and phase durations as a JSON object.
+    std::string toJSON();
+
+    // Adds the time from construction to destruction to a phase.
+    class PhaseTimer {
+
+#ifdef LAMASO_METRICS
+        Phase m_phase;
+
+        std::chrono::steady_clock::time_point m_start;
+#endif
+
+    public:
+
+        PhaseTimer(Phase phase);
+
+        ~PhaseTimer();
+
+    };
+
+}
+
+inline void Metrics::add(Counter counter, std::uint64_t value)
+{
+#ifdef LAMASO_METRICS
+    threadCounters.values[counter] += value;
+#else
+    static_cast<void>(counter);
+    static_cast<void>(value);
+#endif
+}
+
+inline Metrics::PhaseTimer::PhaseTimer(Phase phase)
+#ifdef LAMASO_METRICS
+    :
+    m_phase{phase},
+    m_start{std::chrono::steady_clock::now()}
+{}
+#else
+{
+    static_cast<void>(phase);
+}
+#endif
+
+inline Metrics::PhaseTimer::~PhaseTimer()
+{
+#ifdef LAMASO_METRICS
+    addDuration(m_phase, std::chrono::steady_clock::now() - m_start);
+#endif
+}
+
+#endif
\ No newline at end of file
@@ -0,0 +1,231 @@
+#ifndef PACKEDDIRECTIONS_H
+#define PACKEDDIRECTIONS_H
+
+#include <cstdint>
+#include <vector>
+#include <utility>
+
+// Sequence of directions with values 0 to 3 (such as Path::Direction), stored with
+// 2 bits per direction. The k-th direction is held by bits 2 * (k & 31) and
+// 2 * (k & 31) + 1 of the (k >> 5)-th 64-bit word. Bits past the last direction are zero.
+template <typename Direction>
+class PackedDirections {
+
+    // Number of directions.
+    std::uint64_t m_size;
+
+    // Packed directions.
+    std::vector<std::uint64_t> m_words;
+
+public:
+
+    // Number of directions in one word.
+    static constexpr std::uint32_t wordDirections = 32;
+
+    // Empty sequence.
+    PackedDirections();
+
+    // Sequence of given directions.
+    PackedDirections(std::vector<Direction> const &directions);
+
+    std::uint64_t size() const;
+
+    bool empty() const;
+
+    Direction get(std::uint64_t k) const;
+
+    void set(std::uint64_t k, Direction direction);
+
+    // Last direction. The sequence must not be empty.
+    Direction back() const;
+
+    void push(Direction direction);
+
+    // Remove the last direction. The sequence must not be empty.
+    void pop();
+
+    void clear();
+
+    // Change the number of directions, appending directions with value 0.
+    void resize(std::uint64_t size);
+
+    void reserve(std::uint64_t size);
+
+    // Reverse the order of directions, one word at a time.
+    void reverse();
+
+    // Number of words holding the directions.
+    std::uint64_t wordCount() const;
+
+    // The k-th word, holding directions 32 * k to 32 * k + 31.
+    std::uint64_t word(std::uint64_t k) const;
+
+    // Call function(direction) for each direction in order, reading one word at a time.
+    template <typename Function>
+    void forEach(Function const &function) const;
+
+    // Unpacked directions.
+    std::vector<Direction> toVector() const;
+
+};
+
+template <typename Direction>
+PackedDirections<Direction>::PackedDirections() :
+    m_size{0}
+{}
+
+template <typename Direction>
+PackedDirections<Direction>::PackedDirections(std::vector<Direction> const &directions) :
+    m_size{0}
+{
+    reserve(directions.size());
+    for (Direction direction : directions) {
+        push(direction);
+    }
+}
+
+template <typename Direction>
+inline std::uint64_t PackedDirections<Direction>::size() const
+{
+    return m_size;
+}
+
+template <typename Direction>
+inline bool PackedDirections<Direction>::empty() const
+{
+    return m_size == 0;
+}
+
+template <typename Direction>
+inline Direction PackedDirections<Direction>::get(std::uint64_t k) const
+{
+    return static_cast<Direction>((m_words[k >> 5] >> ((k & 31) << 1)) & 3);
+}
+
+template <typename Direction>
+inline void PackedDirections<Direction>::set(std::uint64_t k, Direction direction)
+{
+    std::uint32_t shift = (k & 31) << 1;
+    std::uint64_t &word = m_words[k >> 5];
+    word = (word & ~(static_cast<std::uint64_t>(3) << shift)) |
+        (static_cast<std::uint64_t>(direction) << shift);
+}
+
+template <typename Direction>
+inline Direction PackedDirections<Direction>::back() const
+{
+    return get(m_size - 1);
+}
+
+template <typename Direction>
+inline void PackedDirections<Direction>::push(Direction direction)
+{
+    if ((m_size & 31) == 0) {
+        m_words.push_back(static_cast<std::uint64_t>(direction));
+    }
+    else {
+        m_words.back() |= static_cast<std::uint64_t>(direction) << ((m_size & 31) << 1);
+    }
+    m_size++;
+}
+
+template <typename Direction>
+inline void PackedDirections<Direction>::pop()
+{
+    m_size--;
+    if ((m_size & 31) == 0) {
+        m_words.pop_back();
+    }
+    else {
+        m_words.back() &= ~(static_cast<std::uint64_t>(3) << ((m_size & 31) << 1));
+    }
+}
+
+template <typename Direction>
+inline void PackedDirections<Direction>::clear()
+{
+    m_size = 0;
+    m_words.clear();
+}
+
+template <typename Direction>
+void PackedDirections<Direction>::resize(std::uint64_t size)
+{
+    m_words.resize((size + 31) >> 5);
+    if (size < m_size && (size & 31) != 0) {
+        m_words.back() &= ~static_cast<std::uint64_t>(0) >> ((32 - (size & 31)) << 1);
+    }
+    m_size = size;
+}
+
+template <typename Direction>
+void PackedDirections<Direction>::reserve(std::uint64_t size)
+{
+    m_words.reserve((size + 31) >> 5);
+}
+
+template <typename Direction>
+void PackedDirections<Direction>::reverse()
+{
+    // Reverse 2-bit fields within each word and the order of words,
+    // then shift the unused fields of the last word out to the end.
+    for (std::uint64_t &word : m_words) {
+        word = ((word >> 2) & 0x3333333333333333) | ((word & 0x3333333333333333) << 2);
+        word = ((word >> 4) & 0x0f0f0f0f0f0f0f0f) | ((word & 0x0f0f0f0f0f0f0f0f) << 4);
+        word = ((word >> 8) & 0x00ff00ff00ff00ff) | ((word & 0x00ff00ff00ff00ff) << 8);
+        word = ((word >> 16) & 0x0000ffff0000ffff) | ((word & 0x0000ffff0000ffff) << 16);
+        word = (word >> 32) | (word << 32);
+    }
+    for (std::uint64_t k = 0; k < m_words.size() >> 1; k++) {
+        std::swap(m_words[k], m_words[m_words.size() - 1 - k]);
+    }
+    std::uint32_t shift = ((32 - (m_size & 31)) & 31) << 1;
+    if (shift != 0) {
+        for (std::uint64_t k = 0; k < m_words.size(); k++) {
+            m_words[k] >>= shift;
+            if (k + 1 < m_words.size()) {
+                m_words[k] |= m_words[k + 1] << (64 - shift);
+            }
+        }
+    }
+}
+
+template <typename Direction>
+inline std::uint64_t PackedDirections<Direction>::wordCount() const
+{
+    return m_words.size();
+}
+
+template <typename Direction>
+inline std::uint64_t PackedDirections<Direction>::word(std::uint64_t k) const
+{
+    return m_words[k];
+}
+
+template <typename Direction>
+template <typename Function>
+void PackedDirections<Direction>::forEach(Function const &function) const
+{
+    for (std::uint64_t k = 0; k < m_words.size(); k++) {
+        std::uint64_t word = m_words[k];
+        std::uint32_t count = k + 1 < m_words.size() || (m_size & 31) == 0 ?
+            wordDirections : m_size & 31;
+        for (std::uint32_t t = 0; t < count; t++) {
+            function(static_cast<Direction>(word & 3));
+            word >>= 2;
+        }
+    }
+}
+
+template <typename Direction>
+std::vector<Direction> PackedDirections<Direction>::toVector() const
+{
+    std::vector<Direction> directions;
+    directions.reserve(m_size);
+    forEach([&](Direction direction) {
+        directions.push_back(direction);
+    });
+    return directions;
+}
+
+#endif
\ No newline at end of file
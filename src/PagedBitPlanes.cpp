@@ -0,0 +1,67 @@
+#include <cstdint>
+#include <vector>
+#include <unordered_map>
+#include <PagedBitPlanes.h>
+
+PagedBitPlanes::PagedBitPlanes() :
+    PagedBitPlanes(0, 0, 0)
+{}
+
+PagedBitPlanes::PagedBitPlanes(std::uint32_t height, std::uint32_t width, std::uint32_t planeCount) :
+    m_height{height},
+    m_width{width},
+    m_planeCount{planeCount},
+    m_pageColumns{(width >> 6) + ((width & 63) != 0)},
+    m_lastPage{UINT64_MAX},
+    m_lastOffset{UINT64_MAX}
+{}
+
+std::uint32_t PagedBitPlanes::getHeight() const
+{
+    return m_height;
+}
+
+std::uint32_t PagedBitPlanes::getWidth() const
+{
+    return m_width;
+}
+
+std::uint32_t PagedBitPlanes::getPlaneCount() const
+{
+    return m_planeCount;
+}
+
+std::uint64_t PagedBitPlanes::pageCount() const
+{
+    return m_pages.size();
+}
+
+std::uint64_t PagedBitPlanes::byteSize() const
+{
+    return m_words.size() * sizeof(std::uint64_t);
+}
+
+void PagedBitPlanes::set(std::uint32_t i, std::uint32_t j, std::uint32_t plane, bool value)
+{
+    std::uint64_t offset = pageOffset(i, j);
+    if (offset == UINT64_MAX) {
+        if (!value) {
+            return;
+        }
+        offset = m_words.size();
+        m_words.resize(offset + (static_cast<std::uint64_t>(m_planeCount) << 6), 0);
+        m_pages.emplace(m_lastPage, offset);
+        m_lastOffset = offset;
+    }
+    std::uint64_t &word = m_words[offset + (plane << 6) + (i & 63)];
+    std::uint64_t bit = static_cast<std::uint64_t>(1) << (j & 63);
+    word = value ? word | bit : word & ~bit;
+}
+
+void PagedBitPlanes::clear()
+{
+    m_pages.clear();
+    m_words.clear();
+    m_lastPage = UINT64_MAX;
+    m_lastOffset = UINT64_MAX;
+}
\ No newline at end of file
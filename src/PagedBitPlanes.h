@@ -0,0 +1,88 @@
+#ifndef PAGEDBITPLANES_H
+#define PAGEDBITPLANES_H
+
+#include <cstdint>
+#include <vector>
+#include <unordered_map>
+
+// A set of bit-planes of size m x n of which only pages of 64 x 64 bits containing
+// set bits are stored, so that memory follows the number of pages touched instead of
+// the size of the planes. Pages are allocated when a bit in them is first set.
+// Each page holds 64 words per plane, with bit (i, j) in bit (j & 63) of word i & 63.
+class PagedBitPlanes {
+
+    // Height.
+    std::uint32_t m_height;
+
+    // Width.
+    std::uint32_t m_width;
+
+    // Number of planes.
+    std::uint32_t m_planeCount;
+
+    // Number of page columns, (width + 63) / 64.
+    std::uint32_t m_pageColumns;
+
+    // First word of each allocated page in m_words, by page number
+    // (page row * page columns + page column).
+    std::unordered_map<std::uint64_t, std::uint64_t> m_pages;
+
+    std::vector<std::uint64_t> m_words;
+
+    // Page number and first word of the last page looked up, UINT64_MAX if none.
+    mutable std::uint64_t m_lastPage;
+    mutable std::uint64_t m_lastOffset;
+
+    // First word of the page containing bit (i, j), or UINT64_MAX if it is not allocated.
+    std::uint64_t pageOffset(std::uint32_t i, std::uint32_t j) const;
+
+public:
+
+    // Empty set of planes.
+    PagedBitPlanes();
+
+    // Planes of size height x width with all bits cleared and no pages allocated.
+    PagedBitPlanes(std::uint32_t height, std::uint32_t width, std::uint32_t planeCount);
+
+    std::uint32_t getHeight() const;
+
+    std::uint32_t getWidth() const;
+
+    std::uint32_t getPlaneCount() const;
+
+    // Number of allocated pages.
+    std::uint64_t pageCount() const;
+
+    // Memory used by the pages in bytes.
+    std::uint64_t byteSize() const;
+
+    bool get(std::uint32_t i, std::uint32_t j, std::uint32_t plane) const;
+
+    void set(std::uint32_t i, std::uint32_t j, std::uint32_t plane, bool value);
+
+    // Clear all bits, releasing the pages.
+    void clear();
+
+};
+
+inline std::uint64_t PagedBitPlanes::pageOffset(std::uint32_t i, std::uint32_t j) const
+{
+    std::uint64_t page = static_cast<std::uint64_t>(i >> 6) * m_pageColumns + (j >> 6);
+    if (page != m_lastPage) {
+        auto it = m_pages.find(page);
+        m_lastPage = page;
+        m_lastOffset = it != m_pages.end() ? it->second : UINT64_MAX;
+    }
+    return m_lastOffset;
+}
+
+inline bool PagedBitPlanes::get(std::uint32_t i, std::uint32_t j, std::uint32_t plane) const
+{
+    std::uint64_t offset = pageOffset(i, j);
+    if (offset == UINT64_MAX) {
+        return false;
+    }
+    return (m_words[offset + (plane << 6) + (i & 63)] >> (j & 63)) & 1;
+}
+
+#endif
\ No newline at end of file
@@ -1,16 +1,37 @@
 #include <cstdint>
 #include <vector>
-#include <unordered_map>
 #include <fstream>
 #include <algorithm>
+#include <utility>
+#include <memory>
 #include <Path.h>
 #include <Utilities.h>
+#include <BitPlanes.h>
+#include <BitInterleave.h>
+#include <MazeImage.h>
+#include <Metrics.h>
+#include <BMPBandWriter.h>
 
 std::uint64_t Path::length() const
 {
     return m_directions.size();
 }
 
+std::uint32_t Path::getStartRow() const
+{
+    return m_startRow;
+}
+
+std::uint32_t Path::getStartColumn() const
+{
+    return m_startColumn;
+}
+
+Path::Directions const &Path::directions() const
+{
+    return m_directions;
+}
+
 std::uint32_t Path::getHeight() const
 {
     return m_height;
@@ -30,112 +51,197 @@ Path::Path() :
 
 Path::Path(std::uint32_t height, std::uint32_t width,
     std::uint32_t startRow, std::uint32_t startColumn,
-    std::vector<Direction> const &directions) :
+    Directions directions) :
     m_height{height},
     m_width{width},
     m_startRow{startRow},
     m_startColumn{startColumn},
-    m_directions{directions}
+    m_directions{std::move(directions)}
 {}
 
+// Connections of cells of a path image to the cells above them and left to them, recorded
+// only for cells with at least one of them, so that memory follows the path length.
+// Cells of row i are entries [rowOffsets[i], rowOffsets[i + 1]), sorted by columns,
+// each entry being (j << 2) | (connected up ? UpConnection : 0) | (connected left ? LeftConnection : 0).
+struct SparseConnections {
+
+    enum Connection {UpConnection = 1, LeftConnection = 2};
+
+    std::vector<std::uint64_t> rowOffsets;
+    std::vector<std::uint32_t> entries;
+
+    // Index of the first entry of row i with column at least j.
+    std::uint64_t position(std::uint32_t i, std::uint32_t j) const
+    {
+        return std::lower_bound(entries.begin() + rowOffsets[i], entries.begin() + rowOffsets[i + 1],
+            j << 2) - entries.begin();
+    }
+
+    // Return true if entry e is of the (i, j)-th cell and it has given connection.
+    bool has(std::uint64_t e, std::uint32_t i, std::uint32_t j, Connection connection) const
+    {
+        return e < rowOffsets[i + 1] && entries[e] >> 2 == j && (entries[e] & connection) != 0;
+    }
+
+};
+
 Path::Path(std::string const &fileName) :
     m_height{1},
     m_width{1},
     m_startRow{0},
     m_startColumn{0}
 {
+    Metrics::PhaseTimer timer(Metrics::Load);
     std::int32_t heightBMP;
     std::int32_t widthBMP;
     std::ifstream file;
-    if (!Utilities::readBMP(fileName, widthBMP, heightBMP, file) ||
-        (heightBMP & 1) == 0 || (widthBMP & 1) == 0)
-    {
+    if (!Utilities::readBMP(fileName, widthBMP, heightBMP, file)) {
+        return;
+    }
+    bool topDown = heightBMP < 0;
+    if (topDown) {
+        heightBMP = -heightBMP;
+    }
+    if ((heightBMP & 1) == 0 || (widthBMP & 1) == 0) {
         return;
     }
     std::uint32_t bmpWidthBytes = (((widthBMP - 1) >> 5) + 1) << 2;
-    if (!file.ignore(bmpWidthBytes)) {
+    if (!topDown && !file.ignore(bmpWidthBytes)) {
         return;
     }
-    m_height = heightBMP >> 1;
-    m_width = widthBMP >> 1;
-    std::vector<std::vector<bool>> horizontalConnections;
-    std::vector<std::vector<bool>> verticalConnections;
-    horizontalConnections.resize(m_height);
-    verticalConnections.resize(m_height);
-    for (std::uint32_t i = 0; i < m_height; i++) {
-        horizontalConnections[i] = std::vector<bool>(m_width, false);
-        verticalConnections[i] = std::vector<bool>(m_width, false);
-    }
-    char *row1 = new char[bmpWidthBytes];
-    char *row2 = new char[bmpWidthBytes];
-    for (std::uint32_t i = m_height; i > 0; i--) {
-        if (!file.read(row2, bmpWidthBytes) || !file.read(row1, bmpWidthBytes)) {
-            delete[] row1;
-            delete[] row2;
-            m_height = 1;
-            m_width = 1;
+    std::uint32_t height = heightBMP >> 1;
+    std::uint32_t width = widthBMP >> 1;
+    // Black pixels between cells of a path image are laid out as walls
+    // of a maze image, so rows are decoded the same way, one at a time.
+    SparseConnections connections;
+    connections.rowOffsets.resize(static_cast<std::uint64_t>(height) + 1);
+    std::vector<char> row1(bmpWidthBytes);
+    std::vector<char> row2(bmpWidthBytes);
+    std::vector<std::uint64_t> scratch(MazeImage::scratchWords(width));
+    std::uint32_t rowWords = (width + 63) >> 6;
+    std::vector<std::uint64_t> upConnections(rowWords);
+    std::vector<std::uint64_t> leftConnections(rowWords);
+    for (std::uint32_t k = 0; k < height; k++) {
+        std::uint32_t i = topDown ? k : height - 1 - k;
+        if (topDown ?
+            !file.read(row1.data(), bmpWidthBytes) || !file.read(row2.data(), bmpWidthBytes) :
+            !file.read(row2.data(), bmpWidthBytes) || !file.read(row1.data(), bmpWidthBytes))
+        {
             return;
         }
-        for (std::uint32_t j = 0; j < m_width; j++) {
-            horizontalConnections[i - 1][j] =
-                i != 1 && (row1[j >> 2] & (1 << (6 - ((j & 3) << 1)))) == 0;
-            verticalConnections[i - 1][j] =
-                j != 0 && (row2[j >> 2] & (1 << (7 - ((j & 3) << 1)))) == 0;
+        MazeImage::decodeRows(width, i == 0, row1.data(), row2.data(), scratch.data(),
+            leftConnections.data(), upConnections.data());
+        std::uint64_t rowBegin = connections.entries.size();
+        for (std::uint32_t w = 0; w < rowWords; w++) {
+            std::uint64_t cells = upConnections[w] | leftConnections[w];
+            if ((w << 6) + 64 > width) {
+                cells &= (static_cast<std::uint64_t>(1) << (width & 63)) - 1;
+            }
+            while (cells != 0) {
+                std::uint32_t bit = BitPlanes::trailingZeros(cells);
+                connections.entries.push_back(((w << 6) + bit) << 2 |
+                    ((upConnections[w] >> bit) & 1) * SparseConnections::UpConnection |
+                    ((leftConnections[w] >> bit) & 1) * SparseConnections::LeftConnection);
+                cells &= cells - 1;
+            }
+        }
+        connections.rowOffsets[i + 1] = connections.entries.size() - rowBegin;
+    }
+    if (!topDown) {
+        // Rows were read from the bottom up: reverse the order of rows, keeping
+        // the order of cells in each row.
+        std::reverse(connections.entries.begin(), connections.entries.end());
+    }
+    for (std::uint32_t i = 0; i < height; i++) {
+        connections.rowOffsets[i + 1] += connections.rowOffsets[i];
+        if (!topDown) {
+            std::reverse(connections.entries.begin() + connections.rowOffsets[i],
+                connections.entries.begin() + connections.rowOffsets[i + 1]);
         }
     }
-    delete[] row1;
-    delete[] row2;
+    // Degrees of cells of each row, from connections up and left of its cells and
+    // connections up of the cells below; the start is the first cell of degree 1.
+    std::vector<std::uint8_t> degrees(width);
+    std::vector<std::uint32_t> rowCells;
     bool foundStartCell = false;
-    for (std::uint32_t i = 0; i < m_height; i++) {
-        for (std::uint32_t j = 0; j < m_width; j++) {
-            std::uint8_t degree = 0;
-            if (horizontalConnections[i][j]) {
-                degree++;
+    for (std::uint32_t i = 0; i < height; i++) {
+        auto connect = [&](std::uint32_t j) {
+            if (degrees[j]++ == 0) {
+                rowCells.push_back(j);
             }
-            if (verticalConnections[i][j]) {
-                degree++;
+        };
+        for (std::uint64_t e = connections.rowOffsets[i]; e < connections.rowOffsets[i + 1]; e++) {
+            std::uint32_t j = connections.entries[e] >> 2;
+            if (connections.entries[e] & SparseConnections::UpConnection) {
+                connect(j);
             }
-            if (i != m_height - 1 && horizontalConnections[i + 1][j]) {
-                degree++;
+            if (connections.entries[e] & SparseConnections::LeftConnection) {
+                connect(j);
+                if (j != 0) {
+                    connect(j - 1);
+                }
             }
-            if (j != m_width - 1 && verticalConnections[i][j + 1]) {
-                degree++;
+        }
+        if (i != height - 1) {
+            for (std::uint64_t e = connections.rowOffsets[i + 1]; e < connections.rowOffsets[i + 2]; e++) {
+                if (connections.entries[e] & SparseConnections::UpConnection) {
+                    connect(connections.entries[e] >> 2);
+                }
             }
-            if (degree >= 3) {
-                m_height = 1;
-                m_width = 1;
+        }
+        for (std::uint32_t j : rowCells) {
+            if (degrees[j] >= 3) {
                 return;
             }
-            if (degree == 1 && !foundStartCell) {
+            if (degrees[j] == 1 && (!foundStartCell || (m_startRow == i && j < m_startColumn))) {
                 m_startRow = i;
                 m_startColumn = j;
                 foundStartCell = true;
             }
+            degrees[j] = 0;
         }
+        rowCells.clear();
     }
     if (!foundStartCell) {
-        m_height = 1;
-        m_width = 1;
         return;
     }
+    m_height = height;
+    m_width = width;
+    // Connections are removed as they are followed. Entry e is the position
+    // of the current cell in its row, and below the position in the next row.
     std::uint32_t i = m_startRow;
     std::uint32_t j = m_startColumn;
+    std::uint64_t e = connections.position(i, j);
     while (true) {
-        if (i != 0 && horizontalConnections[i][j]) {
-            m_directions.push_back(Up);
-            horizontalConnections[i--][j] = false;
+        std::uint64_t below = i != m_height - 1 ? connections.position(i + 1, j) : 0;
+        if (i != 0 && connections.has(e, i, j, SparseConnections::UpConnection)) {
+            connections.entries[e] &= ~static_cast<std::uint32_t>(SparseConnections::UpConnection);
+            m_directions.push(Up);
+            e = connections.position(--i, j);
         }
-        else if (i != m_height - 1 && horizontalConnections[i + 1][j]) {
-            m_directions.push_back(Down);
-            horizontalConnections[++i][j] = false;
+        else if (i != m_height - 1 &&
+            connections.has(below, i + 1, j, SparseConnections::UpConnection))
+        {
+            connections.entries[below] &= ~static_cast<std::uint32_t>(SparseConnections::UpConnection);
+            m_directions.push(Down);
+            e = below;
+            i++;
         }
-        else if (j != 0 && verticalConnections[i][j]) {
-            m_directions.push_back(Left);
-            verticalConnections[i][j--] = false;
+        else if (j != 0 && connections.has(e, i, j, SparseConnections::LeftConnection)) {
+            connections.entries[e] &= ~static_cast<std::uint32_t>(SparseConnections::LeftConnection);
+            m_directions.push(Left);
+            j--;
+            if (e != connections.rowOffsets[i] && connections.entries[e - 1] >> 2 == j) {
+                e--;
+            }
         }
-        else if (j != m_width - 1 && verticalConnections[i][j + 1]) {
-            m_directions.push_back(Right);
-            verticalConnections[i][++j] = false;
+        else if (j != m_width - 1 &&
+            (connections.has(e, i, j + 1, SparseConnections::LeftConnection) ||
+            connections.has(++e, i, j + 1, SparseConnections::LeftConnection)))
+        {
+            connections.entries[e] &= ~static_cast<std::uint32_t>(SparseConnections::LeftConnection);
+            m_directions.push(Right);
+            j++;
         }
         else {
             return;
@@ -158,6 +264,126 @@ struct PathCellParameters {
     std::int64_t winding;
 };
 
+// Path cell parameters of the cells of a path, in a flat open-addressing hash
+// keyed by (i, j) with linear probing. Rotations and windings are stored as
+// 32-bit values, which holds for paths shorter than 2^31 steps. Occupancy of
+// tables with at most 2^28 cells is also kept in a bitmap; for larger tables it
+// is answered by the hash, so memory follows the path length instead of the table.
+class PathCellStore {
+
+    struct Slot {
+        std::uint32_t row;
+        std::uint32_t column;
+        std::int32_t rotation;
+        std::int32_t winding;
+        std::uint8_t direction;
+    };
+
+    // Row of empty slots. Rows of table cells are smaller.
+    static constexpr std::uint32_t emptyRow = UINT32_MAX;
+
+    static constexpr std::uint64_t maxBitmapCells = static_cast<std::uint64_t>(1) << 28;
+
+    std::uint32_t m_width;
+
+    // Bit i * width + j is set if the cell (i, j) is stored, or empty for large tables.
+    std::vector<std::uint64_t> m_occupancy;
+
+    std::vector<Slot> m_slots;
+
+    // log2 of the number of slots.
+    std::uint32_t m_slotBits;
+
+    std::uint64_t m_size;
+
+    std::uint64_t slotIndex(std::uint32_t i, std::uint32_t j) const
+    {
+        std::uint64_t key = (static_cast<std::uint64_t>(i) << 32) | j;
+        return (key * 0x9e3779b97f4a7c15) >> (64 - m_slotBits);
+    }
+
+    Slot const &find(std::uint32_t i, std::uint32_t j) const
+    {
+        std::uint64_t mask = m_slots.size() - 1;
+        std::uint64_t k = slotIndex(i, j);
+        while (m_slots[k].row != emptyRow &&
+            (m_slots[k].row != i || m_slots[k].column != j))
+        {
+            k = (k + 1) & mask;
+        }
+        return m_slots[k];
+    }
+
+    void grow()
+    {
+        std::vector<Slot> slots(m_slots.size() << 1, Slot{emptyRow, 0, 0, 0, 0});
+        std::swap(slots, m_slots);
+        m_slotBits++;
+        std::uint64_t mask = m_slots.size() - 1;
+        for (Slot const &slot : slots) {
+            if (slot.row != emptyRow) {
+                std::uint64_t k = slotIndex(slot.row, slot.column);
+                while (m_slots[k].row != emptyRow) {
+                    k = (k + 1) & mask;
+                }
+                m_slots[k] = slot;
+            }
+        }
+    }
+
+public:
+
+    PathCellStore(std::uint32_t height, std::uint32_t width) :
+        m_width{width},
+        m_slots(1 << 10, Slot{emptyRow, 0, 0, 0, 0}),
+        m_slotBits{10},
+        m_size{0}
+    {
+        std::uint64_t cellCount = static_cast<std::uint64_t>(height) * width;
+        if (cellCount <= maxBitmapCells) {
+            m_occupancy.resize((cellCount + 63) >> 6);
+        }
+    }
+
+    bool exists(std::uint32_t i, std::uint32_t j) const
+    {
+        if (!m_occupancy.empty()) {
+            std::uint64_t cell = static_cast<std::uint64_t>(i) * m_width + j;
+            return (m_occupancy[cell >> 6] >> (cell & 63)) & 1;
+        }
+        return find(i, j).row != emptyRow;
+    }
+
+    // Parameters of a stored cell.
+    PathCellParameters at(std::uint32_t i, std::uint32_t j) const
+    {
+        Slot const &slot = find(i, j);
+        return {static_cast<Path::Direction>(slot.direction), slot.rotation, slot.winding};
+    }
+
+    // Store a cell not stored yet.
+    void insert(std::uint32_t i, std::uint32_t j, PathCellParameters const &parameters)
+    {
+        if ((m_size + 1) << 1 > m_slots.size()) {
+            grow();
+        }
+        std::uint64_t mask = m_slots.size() - 1;
+        std::uint64_t k = slotIndex(i, j);
+        while (m_slots[k].row != emptyRow) {
+            k = (k + 1) & mask;
+        }
+        m_slots[k] = {i, j, static_cast<std::int32_t>(parameters.rotation),
+            static_cast<std::int32_t>(parameters.winding),
+            static_cast<std::uint8_t>(parameters.direction)};
+        m_size++;
+        if (!m_occupancy.empty()) {
+            std::uint64_t cell = static_cast<std::uint64_t>(i) * m_width + j;
+            m_occupancy[cell >> 6] |= static_cast<std::uint64_t>(1) << (cell & 63);
+        }
+    }
+
+};
+
 // Path cell parameters for each cell in a path, with windings
 // relative to a point S(iS, jS) not contained in a path.
 struct PathParameters {
@@ -165,10 +391,10 @@ struct PathParameters {
     std::uint32_t width;
     std::uint32_t iS;
     std::uint32_t jS;
-    std::vector<std::unordered_map<std::uint32_t, PathCellParameters>> cellParameters;
+    PathCellStore cells;
     bool exists(std::uint32_t i, std::uint32_t j) const
     {
-        return cellParameters[i].find(j) != cellParameters[i].end();
+        return cells.exists(i, j);
     }
 };
 
@@ -182,14 +408,14 @@ bool loopParameter(PathParameters const &path,
     std::uint32_t iA = up ? iB - 1 : iB + 1;
     std::uint32_t jA = left ? jB - 1 : jB + 1;
     std::int64_t windingInt =
-        path.cellParameters[iB].at(jB).winding -
-        path.cellParameters[iA].at(jA).winding;
+        path.cells.at(iB, jB).winding -
+        path.cells.at(iA, jA).winding;
     if (path.iS == (up ? iB : iA) && path.jS < (left ? jB : jA)) {
         windingInt += up ? 1 : -1;
     }
     std::int64_t rotationInt =
-        path.cellParameters[iB].at(jB).rotation -
-        path.cellParameters[iA].at(jA).rotation;
+        path.cells.at(iB, jB).rotation -
+        path.cells.at(iA, jA).rotation;
     if (rotationInt == 0) {
         Path::Direction positiveDirectionB;
         if (left && up) {
@@ -204,11 +430,167 @@ bool loopParameter(PathParameters const &path,
         else {
             positiveDirectionB = Path::Down;
         }
-        rotationInt = path.cellParameters[iB].at(jB).direction == positiveDirectionB ? 1 : -1;
+        rotationInt = path.cells.at(iB, jB).direction == positiveDirectionB ? 1 : -1;
     }
     return (rotationInt > 0) == (windingInt != 0);
 }
 
+// Bits of the neighbourhood mask of a cell (i, j): bit 3 * (di + 1) + dj + 1 is set
+// if the cell (i + di, j + dj) is a member of the table and of the path.
+enum NeighbourhoodBit : std::uint16_t {
+    UpperLeftBit = 1 << 0,
+    UpperBit = 1 << 1,
+    UpperRightBit = 1 << 2,
+    LeftBit = 1 << 3,
+    CentreBit = 1 << 4,
+    RightBit = 1 << 5,
+    LowerLeftBit = 1 << 6,
+    LowerBit = 1 << 7,
+    LowerRightBit = 1 << 8
+};
+
+// Bits 0, 1, 2 of the neighbourhood mask for the cells (i, j - 1), (i, j), (i, j + 1).
+std::uint16_t neighbourhoodRow(PathParameters const &path, std::uint32_t i, std::uint32_t j)
+{
+    std::uint16_t bits = path.exists(i, j) ? 2 : 0;
+    if (j != 0 && path.exists(i, j - 1)) {
+        bits |= 1;
+    }
+    if (j != path.width - 1 && path.exists(i, j + 1)) {
+        bits |= 4;
+    }
+    return bits;
+}
+
+// Bits 0, 3, 6 of the neighbourhood mask for the cells (i - 1, j), (i, j), (i + 1, j).
+std::uint16_t neighbourhoodColumn(PathParameters const &path, std::uint32_t i, std::uint32_t j)
+{
+    std::uint16_t bits = path.exists(i, j) ? 8 : 0;
+    if (i != 0 && path.exists(i - 1, j)) {
+        bits |= 1;
+    }
+    if (i != path.height - 1 && path.exists(i + 1, j)) {
+        bits |= 64;
+    }
+    return bits;
+}
+
+std::uint16_t neighbourhood(PathParameters const &path, std::uint32_t i, std::uint32_t j)
+{
+    std::uint16_t mask = neighbourhoodRow(path, i, j) << 3;
+    if (i != 0) {
+        mask |= neighbourhoodRow(path, i - 1, j);
+    }
+    if (i != path.height - 1) {
+        mask |= neighbourhoodRow(path, i + 1, j) << 6;
+    }
+    return mask;
+}
+
+// Neighbourhood mask of the cell (i, j) entered by moving toward direction from
+// a cell with the given mask. Only the three cells ahead are looked up.
+std::uint16_t moveNeighbourhood(PathParameters const &path, std::uint16_t mask,
+    std::uint32_t i, std::uint32_t j, Path::Direction direction)
+{
+    switch (direction) {
+        case Path::Up:
+            mask = (mask << 3) & 0x1ff;
+            if (i != 0) {
+                mask |= neighbourhoodRow(path, i - 1, j);
+            }
+            break;
+        case Path::Down:
+            mask >>= 3;
+            if (i != path.height - 1) {
+                mask |= neighbourhoodRow(path, i + 1, j) << 6;
+            }
+            break;
+        case Path::Left:
+            mask = (mask << 1) & 0x1b6;
+            if (j != 0) {
+                mask |= neighbourhoodColumn(path, i, j - 1);
+            }
+            break;
+        default:
+            mask = (mask >> 1) & 0xdb;
+            if (j != path.width - 1) {
+                mask |= neighbourhoodColumn(path, i, j + 1) << 2;
+            }
+    }
+    return mask;
+}
+
+// Loop parameters of the diagonal neighbours (iT - 1, jT - 1), (iT - 1, jT + 1),
+// (iT + 1, jT - 1), (iT + 1, jT + 1) of the last cell T of a path, held by
+// bits 0 to 3 and computed on first use.
+struct DiagonalLoops {
+    std::uint8_t known;
+    std::uint8_t values;
+    bool get(PathParameters const &path, std::uint32_t iT, std::uint32_t jT, bool up, bool left)
+    {
+        std::uint8_t bit = 1 << ((up ? 0 : 2) + (left ? 0 : 1));
+        if (!(known & bit)) {
+            known |= bit;
+            Metrics::add(Metrics::LoopParameterCalls);
+            if (loopParameter(path, iT, jT, up, left)) {
+                Metrics::add(Metrics::LoopParameterPositive);
+                values |= bit;
+            }
+        }
+        return values & bit;
+    }
+};
+
+// Directions forbidden by a diagonal neighbour of a cell T away from the table border:
+// direction, and turnDirection if T was entered moving toward direction. Indexed by the
+// diagonal neighbour, numbered as in DiagonalLoops, and its loop parameter.
+struct DiagonalConstraint {
+    Path::Direction direction;
+    Path::Direction turnDirection;
+};
+
+DiagonalConstraint const diagonalConstraints[4][2] = {
+    {{Path::Left, Path::Down}, {Path::Up, Path::Right}},
+    {{Path::Up, Path::Left}, {Path::Right, Path::Down}},
+    {{Path::Down, Path::Right}, {Path::Left, Path::Up}},
+    {{Path::Right, Path::Up}, {Path::Down, Path::Left}}
+};
+
+// Extension rules for a cell T away from the table border, indexed by
+// 16 * diagonals + 4 * directionT + direction, where bit k of diagonals is set if the
+// k-th diagonal neighbour of T is in the path. Bit k of a rule is set if direction
+// is forbidden when the loop parameter of the k-th diagonal neighbour is false,
+// and bit k + 4 if it is forbidden when that parameter is true.
+std::vector<std::uint8_t> extensionRules()
+{
+    std::vector<std::uint8_t> rules(256, 0);
+    for (std::uint32_t diagonals = 0; diagonals < 16; diagonals++) {
+        for (std::uint32_t directionT = 0; directionT < 4; directionT++) {
+            for (std::uint32_t direction = 0; direction < 4; direction++) {
+                std::uint8_t rule = 0;
+                for (std::uint32_t k = 0; k < 4; k++) {
+                    if (!((diagonals >> k) & 1)) {
+                        continue;
+                    }
+                    for (std::uint32_t loop = 0; loop < 2; loop++) {
+                        DiagonalConstraint const &constraint = diagonalConstraints[k][loop];
+                        if (direction == constraint.direction ||
+                            (direction == constraint.turnDirection &&
+                            directionT == constraint.direction))
+                        {
+                            rule |= 1 << (4 * loop + k);
+                        }
+                    }
+                }
+                rules[(diagonals << 4) | (directionT << 2) | direction] = rule;
+            }
+        }
+    }
+    return rules;
+}
+
+std::vector<std::uint8_t> const extensionRuleTable = extensionRules();
+
 // Let P be a nontrivial path, with S any point not contained in P.
 // Let B be the last point of P touching the table border, if
 // such a point exists. Let T be the last point of P.
@@ -218,31 +600,25 @@ bool loopParameter(PathParameters const &path,
 // T' is a member of the table and not an element of P.
 // Return true if there exists a path from T' to S having
 // no common points with P, and false otherwise.
+// directionT is the direction in which T was entered, neighbourhood the
+// neighbourhood mask of T, and loops caches loop parameters of T.
 bool pathExtension(
     PathParameters const &path,
     bool touchesBorder, std::uint32_t iB, std::uint32_t jB,
-    std::uint32_t iT, std::uint32_t jT, Path::Direction direction)
+    std::uint32_t iT, std::uint32_t jT, Path::Direction directionT,
+    std::uint16_t neighbourhood, DiagonalLoops &loops, Path::Direction direction)
 {
     if (path.height == 1 || path.width == 1) {
         return true;
     }
-    bool upper =
-        iT != 0 && path.exists(iT - 1, jT);
-    bool lower =
-        iT != path.height - 1 && path.exists(iT + 1, jT);
-    bool left =
-        jT != 0 && path.exists(iT, jT - 1);
-    bool right =
-        jT != path.width - 1 && path.exists(iT, jT + 1);
-    bool upperLeft =
-        iT != 0 && jT != 0 && path.exists(iT - 1, jT - 1);
-    bool upperRight =
-        iT != 0 && jT != path.width - 1 && path.exists(iT - 1, jT + 1);
-    bool lowerLeft =
-        iT != path.height - 1 && jT != 0 && path.exists(iT + 1, jT - 1);
-    bool lowerRight =
-        iT != path.height - 1 && jT != path.width - 1 && path.exists(iT + 1, jT + 1);
-    Path::Direction directionT = path.cellParameters[iT].at(jT).direction;
+    bool upper = neighbourhood & UpperBit;
+    bool lower = neighbourhood & LowerBit;
+    bool left = neighbourhood & LeftBit;
+    bool right = neighbourhood & RightBit;
+    bool upperLeft = neighbourhood & UpperLeftBit;
+    bool upperRight = neighbourhood & UpperRightBit;
+    bool lowerLeft = neighbourhood & LowerLeftBit;
+    bool lowerRight = neighbourhood & LowerRightBit;
     if (iT == 0) {
         if (jT == 0 || jT == path.width - 1) {
             return true;
@@ -252,14 +628,14 @@ bool pathExtension(
                 if (left || lower || !lowerLeft) {
                     return true;
                 }
-                bool winding = loopParameter(path, iT, jT, false, true);
+                bool winding = loops.get(path, iT, jT, false, true);
                 return direction == (winding ? Path::Down : Path::Left);
             }
             case Path::Right: {
                 if (right || lower || !lowerRight) {
                     return true;
                 }
-                bool winding = loopParameter(path, iT, jT, false, false);
+                bool winding = loops.get(path, iT, jT, false, false);
                 return direction == (winding ? Path::Right : Path::Down);
             }
             default:
@@ -267,8 +643,8 @@ bool pathExtension(
                     return true;
                 }
                 std::int64_t windingInt =
-                    path.cellParameters[iT].at(jT).winding -
-                    path.cellParameters[iB].at(jB).winding;
+                    path.cells.at(iT, jT).winding -
+                    path.cells.at(iB, jB).winding;
                 if (iB < path.iS && jB > jT) {
                     windingInt++;
                 }
@@ -284,14 +660,14 @@ bool pathExtension(
                 if (left || upper || !upperLeft) {
                     return true;
                 }
-                bool winding = loopParameter(path, iT, jT, true, true);
+                bool winding = loops.get(path, iT, jT, true, true);
                 return direction == (winding ? Path::Left : Path::Up);
             }
             case Path::Right: {
                 if (right || upper || !upperRight) {
                     return true;
                 }
-                bool winding = loopParameter(path, iT, jT, true, false);
+                bool winding = loops.get(path, iT, jT, true, false);
                 return direction == (winding ? Path::Up : Path::Right);
             }
             default:
@@ -299,8 +675,8 @@ bool pathExtension(
                     return true;
                 }
                 std::int64_t windingInt =
-                    path.cellParameters[iT].at(jT).winding -
-                    path.cellParameters[iB].at(jB).winding;
+                    path.cells.at(iT, jT).winding -
+                    path.cells.at(iB, jB).winding;
                 if (iB >= path.iS && jB > jT) {
                     windingInt--;
                 }
@@ -313,14 +689,14 @@ bool pathExtension(
                 if (right || upper || !upperRight) {
                     return true;
                 }
-                bool winding = loopParameter(path, iT, jT, true, false);
+                bool winding = loops.get(path, iT, jT, true, false);
                 return direction == (winding ? Path::Up : Path::Right);
             }
             case Path::Down: {
                 if (right || lower || !lowerRight) {
                     return true;
                 }
-                bool winding = loopParameter(path, iT, jT, false, false);
+                bool winding = loops.get(path, iT, jT, false, false);
                 return direction == (winding ? Path::Right : Path::Down);
             }
             default:
@@ -328,8 +704,8 @@ bool pathExtension(
                     return true;
                 }
                 std::int64_t windingInt =
-                    path.cellParameters[iT].at(jT).winding -
-                    path.cellParameters[iB].at(jB).winding;
+                    path.cells.at(iT, jT).winding -
+                    path.cells.at(iB, jB).winding;
                 if (iB == 0 || (iB < iT && jB == 0) ||
                     (iB < path.iS && jB == path.width - 1))
                 {
@@ -344,14 +720,14 @@ bool pathExtension(
                 if (left || upper || !upperLeft) {
                     return true;
                 }
-                bool winding = loopParameter(path, iT, jT, true, true);
+                bool winding = loops.get(path, iT, jT, true, true);
                 return direction == (winding ? Path::Left : Path::Up);
             }
             case Path::Down: {
                 if (left || lower || !lowerLeft) {
                     return true;
                 }
-                bool winding = loopParameter(path, iT, jT, false, true);
+                bool winding = loops.get(path, iT, jT, false, true);
                 return direction == (winding ? Path::Down : Path::Left);
             }
             default:
@@ -359,8 +735,8 @@ bool pathExtension(
                     return true;
                 }
                 std::int64_t windingInt =
-                    path.cellParameters[iT].at(jT).winding -
-                    path.cellParameters[iB].at(jB).winding;
+                    path.cells.at(iT, jT).winding -
+                    path.cells.at(iB, jB).winding;
                 if (iT >= path.iS) {
                     if (iB >= path.iS && iB < iT && jB == jT) {
                         windingInt--;
@@ -373,63 +749,44 @@ bool pathExtension(
                 return direction == (windingInt == 0 ? Path::Down : Path::Up);
         }
     }
-    if (upperLeft) {
-        if (loopParameter(path, iT, jT, true, true)) {
-            if (direction == Path::Up ||
-                (direction == Path::Right && directionT == Path::Up))
-            {
-                return false;
-            }
-        }
-        else if (direction == Path::Left ||
-            (direction == Path::Down && directionT == Path::Left))
-        {
-            return false;
-        }
+    std::uint32_t diagonals =
+        (upperLeft ? 1 : 0) | (upperRight ? 2 : 0) | (lowerLeft ? 4 : 0) | (lowerRight ? 8 : 0);
+    std::uint8_t rule = extensionRuleTable[(diagonals << 4) | (directionT << 2) | direction];
+    if (rule == 0) {
+        Metrics::add(Metrics::PathExtensionTableAccepts);
     }
-    if (lowerLeft) {
-        if (loopParameter(path, iT, jT, false, true)) {
-            if (direction == Path::Left ||
-                (direction == Path::Up && directionT == Path::Left))
-            {
+    for (std::uint32_t k = 0; rule != 0 && k < 4; k++) {
+        if ((rule >> k) & 0x11) {
+            bool loop = loops.get(path, iT, jT, k < 2, (k & 1) == 0);
+            if ((rule >> (loop ? k + 4 : k)) & 1) {
                 return false;
             }
         }
-        else if (direction == Path::Down ||
-            (direction == Path::Right && directionT == Path::Down))
-        {
-            return false;
-        }
-    }
-    if (lowerRight) {
-        if (loopParameter(path, iT, jT, false, false)) {
-            if (direction == Path::Down ||
-                (direction == Path::Left && directionT == Path::Down))
-            {
-                return false;
-            }
-        }
-        else if (direction == Path::Right ||
-            (direction == Path::Up && directionT == Path::Right))
-        {
-            return false;
-        }
     }
-    if (upperRight) {
-        if (loopParameter(path, iT, jT, true, false)) {
-            if (direction == Path::Right ||
-                (direction == Path::Down && directionT == Path::Right))
-            {
-                return false;
-            }
+    return true;
+}
+
+// pathExtension, counting calls, rejections and calls settled by the border cases.
+inline bool countedPathExtension(
+    PathParameters const &path,
+    bool touchesBorder, std::uint32_t iB, std::uint32_t jB,
+    std::uint32_t iT, std::uint32_t jT, Path::Direction directionT,
+    std::uint16_t neighbourhood, DiagonalLoops &loops, Path::Direction direction)
+{
+    bool result = pathExtension(path, touchesBorder, iB, jB, iT, jT, directionT,
+        neighbourhood, loops, direction);
+    if (Metrics::enabled) {
+        Metrics::add(Metrics::PathExtensionCalls);
+        if (!result) {
+            Metrics::add(Metrics::PathExtensionRejections);
         }
-        else if (direction == Path::Up ||
-            (direction == Path::Left && directionT == Path::Up))
+        if (path.height == 1 || path.width == 1 || iT == 0 || iT == path.height - 1 ||
+            jT == 0 || jT == path.width - 1)
         {
-            return false;
+            Metrics::add(Metrics::PathExtensionBorderCases);
         }
     }
-    return true;
+    return result;
 }
 
 Path::Path(std::uint32_t height, std::uint32_t width, std::int32_t seed,
@@ -445,12 +802,12 @@ Path::Path(std::uint32_t height, std::uint32_t width, std::int32_t seed,
     if (i == i2 && j == j2) {
         return;
     }
+    Metrics::PhaseTimer timer(Metrics::Generate);
     std::int64_t rotation = 0;
     std::int64_t winding = 0;
     Direction direction = Up;
-    PathParameters pathParameters{height, width, i2, j2, {}};
-    pathParameters.cellParameters.resize(height);
-    pathParameters.cellParameters[i][j] = {direction, rotation, winding};
+    PathParameters pathParameters{height, width, i2, j2, PathCellStore(height, width)};
+    pathParameters.cells.insert(i, j, {direction, rotation, winding});
     bool touchesBorders = i == 0 || i == height - 1 || j == 0 || j == width - 1;
     std::uint32_t iB = i;
     std::uint32_t jB = j;
@@ -469,7 +826,8 @@ Path::Path(std::uint32_t height, std::uint32_t width, std::int32_t seed,
     }
     std::uint8_t randNumber = Utilities::randUint8(seed);
     direction = initialDirections[randNumber % initialDirections.size()];
-    m_directions = {direction};
+    m_directions.clear();
+    m_directions.push(direction);
     if (direction == Up) {
         i--;
     }
@@ -488,9 +846,9 @@ Path::Path(std::uint32_t height, std::uint32_t width, std::int32_t seed,
     else if (direction == Down && i == i2 && j > j2) {
         winding--;
     }
-    pathParameters.cellParameters[i][j] = {direction, rotation, winding};
-    std::unordered_map<Direction, std::uint32_t>
-        directionCount{{Up, 0}, {Down, 0}, {Left, 0}, {Right, 0}};
+    pathParameters.cells.insert(i, j, {direction, rotation, winding});
+    std::uint16_t neighbourhoodMask = neighbourhood(pathParameters, i, j);
+    std::uint32_t directionCount[4] = {0, 0, 0, 0};
     directionCount[direction]++;
     std::uint8_t legalDirectionsCount;
     std::vector<Direction> legalDirections;
@@ -501,29 +859,34 @@ Path::Path(std::uint32_t height, std::uint32_t width, std::int32_t seed,
     while (i != i2 || j != j2) {
         legalDirectionsCount = 0;
         legalCountTotal = 0;
-        if (direction != Down && i != 0 && !pathParameters.exists(i - 1, j) &&
-            pathExtension(pathParameters, touchesBorders, iB, jB, i, j, Up))
+        DiagonalLoops loops{0, 0};
+        if (direction != Down && i != 0 && !(neighbourhoodMask & UpperBit) &&
+            countedPathExtension(pathParameters, touchesBorders, iB, jB, i, j, direction,
+                neighbourhoodMask, loops, Up))
         {
             legalDirections[legalDirectionsCount] = Up;
             legalCountTotal += directionCount[Up];
             legalCount[legalDirectionsCount++] = legalCountTotal;
         }
-        if (direction != Up && i != height - 1 && !pathParameters.exists(i + 1, j) &&
-            pathExtension(pathParameters, touchesBorders, iB, jB, i, j, Down))
+        if (direction != Up && i != height - 1 && !(neighbourhoodMask & LowerBit) &&
+            countedPathExtension(pathParameters, touchesBorders, iB, jB, i, j, direction,
+                neighbourhoodMask, loops, Down))
         {
             legalDirections[legalDirectionsCount] = Down;
             legalCountTotal += directionCount[Down];
             legalCount[legalDirectionsCount++] = legalCountTotal;
         }
-        if (direction != Right && j != 0 && !pathParameters.exists(i, j - 1) &&
-            pathExtension(pathParameters, touchesBorders, iB, jB, i, j, Left))
+        if (direction != Right && j != 0 && !(neighbourhoodMask & LeftBit) &&
+            countedPathExtension(pathParameters, touchesBorders, iB, jB, i, j, direction,
+                neighbourhoodMask, loops, Left))
         {
             legalDirections[legalDirectionsCount] = Left;
             legalCountTotal += directionCount[Left];
             legalCount[legalDirectionsCount++] = legalCountTotal;
         }
-        if (direction != Left && j != width - 1 && !pathParameters.exists(i, j + 1) &&
-            pathExtension(pathParameters, touchesBorders, iB, jB, i, j, Right))
+        if (direction != Left && j != width - 1 && !(neighbourhoodMask & RightBit) &&
+            countedPathExtension(pathParameters, touchesBorders, iB, jB, i, j, direction,
+                neighbourhoodMask, loops, Right))
         {
             legalDirections[legalDirectionsCount] = Right;
             legalCountTotal += directionCount[Right];
@@ -591,55 +954,31 @@ Path::Path(std::uint32_t height, std::uint32_t width, std::int32_t seed,
             }
         }
         direction = newDirection;
-        m_directions.push_back(direction);
-        pathParameters.cellParameters[i][j] = {direction, rotation, winding};
+        m_directions.push(direction);
+        pathParameters.cells.insert(i, j, {direction, rotation, winding});
+        neighbourhoodMask =
+            moveNeighbourhood(pathParameters, neighbourhoodMask, i, j, direction) | CentreBit;
         directionCount[direction]++;
+        Metrics::add(Metrics::PathSteps);
         if (m_directions.size() > pastDecisionCount) {
-            directionCount[m_directions[m_directions.size() - 1 - pastDecisionCount]]--;
+            directionCount[m_directions.get(m_directions.size() - 1 - pastDecisionCount)]--;
         }
     }
 }
 
-std::vector<std::vector<PathCell>> Path::cells() const
+PathCells Path::cells() const
 {
-    std::vector<std::vector<PathCell>> result;
-    result.resize(m_height);
-    std::uint32_t i = m_startRow;
-    std::uint32_t j = m_startColumn;
-    result[i].push_back({j, false, false});
-    for (Direction direction : m_directions) {
-        switch(direction) {
-            case Up:
-                result[i--].back().above = true;
-                result[i].push_back({j, false, false});
-                break;
-            case Down:
-                result[++i].push_back({j, true, false});
-                break;
-            case Left:
-                result[i].back().left = true;
-                result[i].push_back({--j, false, false});
-                break;
-            case Right:
-                result[i].push_back({++j, false, true});
-        }
-    }
-    for (auto &rowCells : result) {
-        std::sort(rowCells.begin(), rowCells.end(),
-            [](PathCell const &cell1, PathCell const &cell2)
-            { return cell1.column < cell2.column; });
-    }
-    return result;
+    return PathCells(*this);
 }
 
 std::string Path::toString() const
 {
-    std::vector<std::vector<PathCell>> pathCells = cells();
+    PathCells pathCells = cells();
     std::string result;
-    for (std::vector<PathCell> &rowCells : pathCells) {
+    for (std::uint32_t i = 0; i < m_height; i++) {
         std::string rowString1((m_width << 1) + 1, ' ');
         std::string rowString2 = rowString1;
-        for (PathCell &cell : rowCells) {
+        for (PathCell const &cell : pathCells[i]) {
             if (cell.above) {
                 rowString1[(cell.column << 1) + 1] = char(219);
             }
@@ -656,68 +995,145 @@ std::string Path::toString() const
     return result;
 }
 
-bool Path::toBMP(std::string const &fileName) const
+bool Path::toBMP(std::string const &fileName, std::uint32_t threadCount) const
 {
-    std::int32_t bmpHeight = (m_height << 1) + 1;
-    std::int32_t bmpWidth = (m_width << 1) + 1;
-    std::uint32_t bmpWidthBytes = (((bmpWidth - 1) >> 5) + 1) << 2;
-    std::ofstream file;
-    if (!Utilities::writeBMP(fileName, bmpWidth, bmpHeight, file)) {
+    BMPBandWriter writer(fileName, m_height, m_width);
+    if (!writer.isOpen()) {
         return false;
     }
-    char *row1 = new char[bmpWidthBytes];
-    char *row2 = new char[bmpWidthBytes];
-    std::vector<std::vector<PathCell>> pathCells = cells();
-    std::vector<char> whiteLine;
-    whiteLine.resize(bmpWidthBytes);
-    for (char &ch : whiteLine) {
-        ch = 0;
-    }
-    for (std::uint32_t j = 0; j < bmpWidth; j++) {
-        whiteLine[j >> 3] |= 1 << (7 - (j & 7));
-    }
-    for (std::uint32_t j = 0; j < bmpWidthBytes; j++) {
-        row1[j] = whiteLine[j];
-    }
-    if (!file.write(row1, bmpWidthBytes)) {
-        file.close();
-        delete[] row1;
-        delete[] row2;
+    std::uint32_t rowBytes = writer.getRowBytes();
+    std::uint32_t words = (m_width + 63) >> 6;
+    std::vector<std::uint64_t> white(words, ~static_cast<std::uint64_t>(0));
+    std::uint32_t lastPixel = m_width << 1;
+    std::vector<char> border(rowBytes, 0);
+    BitInterleave::interleave(white.data(), white.data(), m_width, border.data());
+    border[lastPixel >> 3] |= 1 << (7 - (lastPixel & 7));
+    if (!writer.writeBottomBorder(border.data())) {
         return false;
     }
-    for (std::uint32_t i = m_height; i > 0; i--) {
-        for (std::uint32_t j = 0; j < bmpWidthBytes; j++) {
-            row1[j] = whiteLine[j];
-            row2[j] = whiteLine[j];
-        }
-        for (PathCell &cell : pathCells[i - 1]) {
-            if (cell.above) {
-                row1[cell.column >> 2] ^= 1 << (6 - ((cell.column & 3) << 1));
+    // Cursor of each thread, going up from the last row of each of its bands, and inverted
+    // bits of path cells and their connections in its current row (a cleared bit is a black pixel).
+    struct ThreadRows {
+        std::unique_ptr<PathRowCursor> pathCells;
+        std::vector<std::uint64_t> cellsWhite;
+        std::vector<std::uint64_t> leftWhite;
+        std::vector<std::uint64_t> aboveWhite;
+    };
+    std::vector<ThreadRows> threadRows(Utilities::threadCount(threadCount));
+    return writer.write(threadCount,
+        [&](std::uint32_t thread, std::uint32_t firstRow, std::uint32_t rowEnd, char *rows) {
+            Metrics::PhaseTimer timer(Metrics::Encode);
+            ThreadRows &state = threadRows[thread];
+            if (state.pathCells == nullptr) {
+                state.pathCells = std::make_unique<PathRowCursor>(*this, true);
+                state.cellsWhite = white;
+                state.leftWhite = white;
+                state.aboveWhite = white;
             }
-            if (cell.left) {
-                row2[cell.column >> 2] ^= 1 << (7 - ((cell.column & 3) << 1));
+            state.pathCells->seek(rowEnd - 1);
+            for (std::uint32_t i = rowEnd; i-- > firstRow;) {
+                char *row2 = rows + (static_cast<std::uint64_t>(rowEnd - 1 - i) * rowBytes << 1);
+                char *row1 = row2 + rowBytes;
+                PathCellRow rowCells = state.pathCells->next();
+                for (PathCell const &cell : rowCells) {
+                    std::uint64_t mask = static_cast<std::uint64_t>(1) << (cell.column & 63);
+                    state.cellsWhite[cell.column >> 6] &= ~mask;
+                    if (cell.left) {
+                        state.leftWhite[cell.column >> 6] &= ~mask;
+                    }
+                    if (cell.above) {
+                        state.aboveWhite[cell.column >> 6] &= ~mask;
+                    }
+                }
+                BitInterleave::interleave(white.data(), state.aboveWhite.data(), m_width, row1);
+                BitInterleave::interleave(state.leftWhite.data(), state.cellsWhite.data(), m_width, row2);
+                row1[lastPixel >> 3] |= 1 << (7 - (lastPixel & 7));
+                row2[lastPixel >> 3] |= 1 << (7 - (lastPixel & 7));
+                for (PathCell const &cell : rowCells) {
+                    state.cellsWhite[cell.column >> 6] = ~static_cast<std::uint64_t>(0);
+                    state.leftWhite[cell.column >> 6] = ~static_cast<std::uint64_t>(0);
+                    state.aboveWhite[cell.column >> 6] = ~static_cast<std::uint64_t>(0);
+                }
             }
-            row2[cell.column >> 2] ^= 1 << (6 - ((cell.column & 3) << 1));
-        }
-        if (!file.write(row2, bmpWidthBytes) || !file.write(row1, bmpWidthBytes)) {
-            file.close();
-            delete[] row1;
-            delete[] row2;
-            return false;
+        });
+}
+
+// Summary of the four directions packed in a byte, relative to the cell before
+// the first of them: row and column change, integral contribution
+// (added to the starting row times columnChange) and bounding box offsets.
+struct DirectionByteSummary {
+    std::int8_t rowChange;
+    std::int8_t columnChange;
+    std::int8_t integralOffset;
+    std::int8_t minRow;
+    std::int8_t maxRow;
+    std::int8_t minColumn;
+    std::int8_t maxColumn;
+};
+
+// 1 if moving toward to after moving toward from is a left turn, -1 if it is a
+// right turn and 0 otherwise, indexed by 4 * from + to.
+std::int8_t const directionTurns[16] = {
+    0, 0, 1, -1,
+    0, 0, -1, 1,
+    -1, 1, 0, 0,
+    1, -1, 0, 0
+};
+
+std::vector<DirectionByteSummary> directionByteSummaries()
+{
+    std::vector<DirectionByteSummary> summaries(256);
+    for (std::uint32_t byte = 0; byte < 256; byte++) {
+        DirectionByteSummary summary{0, 0, 0, 0, 0, 0, 0};
+        for (std::uint32_t k = 0; k < 4; k++) {
+            std::uint32_t direction = (byte >> (k << 1)) & 3;
+            if (direction == Path::Up) {
+                summary.rowChange--;
+            }
+            else if (direction == Path::Down) {
+                summary.rowChange++;
+            }
+            else if (direction == Path::Left) {
+                summary.columnChange--;
+                summary.integralOffset -= summary.rowChange;
+            }
+            else {
+                summary.columnChange++;
+                summary.integralOffset += summary.rowChange;
+            }
+            summary.minRow = std::min(summary.minRow, summary.rowChange);
+            summary.maxRow = std::max(summary.maxRow, summary.rowChange);
+            summary.minColumn = std::min(summary.minColumn, summary.columnChange);
+            summary.maxColumn = std::max(summary.maxColumn, summary.columnChange);
         }
+        summaries[byte] = summary;
     }
-    file.close();
-    delete[] row1;
-    delete[] row2;
-    return true;
+    return summaries;
 }
 
+std::vector<DirectionByteSummary> const directionByteTable = directionByteSummaries();
+
 std::int64_t Path::integral() const
+{
+    return integral(m_startRow, m_directions);
+}
+
+std::int64_t Path::integral(std::uint32_t startRow, Directions const &directions)
 {
     std::int64_t result = 0;
-    std::uint32_t i = m_startRow;
-    for (Direction direction : m_directions) {
-        switch (direction) {
+    std::int64_t i = startRow;
+    std::uint64_t fullWords = directions.size() >> 5;
+    for (std::uint64_t k = 0; k < fullWords; k++) {
+        std::uint64_t word = directions.word(k);
+        for (std::uint32_t t = 0; t < 8; t++) {
+            DirectionByteSummary const &summary = directionByteTable[word & 0xff];
+            result += i * summary.columnChange + summary.integralOffset;
+            i += summary.rowChange;
+            word >>= 8;
+        }
+    }
+    for (std::uint64_t k = fullWords << 5; k < directions.size(); k++) {
+        switch (directions.get(k)) {
             case Up:
                 i--;
                 break;
@@ -732,4 +1148,276 @@ std::int64_t Path::integral() const
         }
     }
     return result;
+}
+
+Path::Statistics Path::stats() const
+{
+    Statistics statistics{0, m_startRow, m_startRow, m_startColumn, m_startColumn,
+        {0, 0, 0, 0}, 0, 0, 0};
+    std::int64_t i = m_startRow;
+    std::int64_t j = m_startColumn;
+    std::int64_t minRow = i;
+    std::int64_t maxRow = i;
+    std::int64_t minColumn = j;
+    std::int64_t maxColumn = j;
+    // Direction of the previous step, or 4 before the first step.
+    std::uint32_t previous = 4;
+    std::uint64_t fullWords = m_directions.size() >> 5;
+    for (std::uint64_t k = 0; k < fullWords; k++) {
+        std::uint64_t word = m_directions.word(k);
+        // Low and high bits of the 32 directions.
+        std::uint64_t low = word & 0x5555555555555555;
+        std::uint64_t high = (word >> 1) & 0x5555555555555555;
+        std::uint32_t downCount = BitPlanes::bitCount(low & ~high);
+        std::uint32_t leftCount = BitPlanes::bitCount(high & ~low);
+        std::uint32_t rightCount = BitPlanes::bitCount(low & high);
+        statistics.directionCounts[Up] += 32 - downCount - leftCount - rightCount;
+        statistics.directionCounts[Down] += downCount;
+        statistics.directionCounts[Left] += leftCount;
+        statistics.directionCounts[Right] += rightCount;
+        // Turns between the 31 pairs of consecutive directions in the word: a step
+        // turns if exactly one of the two directions is horizontal (high bit set), and
+        // the turn is to the left if the low bits differ exactly when the first is.
+        std::uint64_t nextLow = low >> 2;
+        std::uint64_t nextHigh = high >> 2;
+        std::uint64_t turns = (high ^ nextHigh) & 0x1555555555555555;
+        std::uint64_t rightTurns = turns & (low ^ nextLow ^ high);
+        statistics.leftTurns += BitPlanes::bitCount(turns & ~rightTurns);
+        statistics.rightTurns += BitPlanes::bitCount(rightTurns);
+        if (previous != 4) {
+            std::int8_t turn = directionTurns[(previous << 2) | (word & 3)];
+            statistics.leftTurns += turn > 0 ? 1 : 0;
+            statistics.rightTurns += turn < 0 ? 1 : 0;
+        }
+        previous = word >> 62;
+        for (std::uint32_t t = 0; t < 8; t++) {
+            DirectionByteSummary const &summary = directionByteTable[word & 0xff];
+            statistics.integral += i * summary.columnChange + summary.integralOffset;
+            minRow = std::min(minRow, i + summary.minRow);
+            maxRow = std::max(maxRow, i + summary.maxRow);
+            minColumn = std::min(minColumn, j + summary.minColumn);
+            maxColumn = std::max(maxColumn, j + summary.maxColumn);
+            i += summary.rowChange;
+            j += summary.columnChange;
+            word >>= 8;
+        }
+    }
+    for (std::uint64_t k = fullWords << 5; k < m_directions.size(); k++) {
+        Direction direction = m_directions.get(k);
+        switch (direction) {
+            case Up:
+                i--;
+                break;
+            case Down:
+                i++;
+                break;
+            case Left:
+                j--;
+                statistics.integral -= i;
+                break;
+            default:
+                j++;
+                statistics.integral += i;
+        }
+        minRow = std::min(minRow, i);
+        maxRow = std::max(maxRow, i);
+        minColumn = std::min(minColumn, j);
+        maxColumn = std::max(maxColumn, j);
+        statistics.directionCounts[direction]++;
+        if (previous != 4) {
+            std::int8_t turn = directionTurns[(previous << 2) | direction];
+            statistics.leftTurns += turn > 0 ? 1 : 0;
+            statistics.rightTurns += turn < 0 ? 1 : 0;
+        }
+        previous = direction;
+    }
+    statistics.minRow = static_cast<std::uint32_t>(minRow);
+    statistics.maxRow = static_cast<std::uint32_t>(maxRow);
+    statistics.minColumn = static_cast<std::uint32_t>(minColumn);
+    statistics.maxColumn = static_cast<std::uint32_t>(maxColumn);
+    statistics.rotation = static_cast<std::int64_t>(statistics.leftTurns) -
+        static_cast<std::int64_t>(statistics.rightTurns);
+    return statistics;
+}
+
+PathCells::PathCells(Path const &path) :
+    m_rowOffsets(static_cast<std::uint64_t>(path.getHeight()) + 1)
+{
+    std::uint32_t height = path.getHeight();
+    m_cells.reserve(path.length() + 1);
+    PathRowCursor cursor(path);
+    for (std::uint32_t i = 0; i < height; i++) {
+        PathCellRow row = cursor.next();
+        m_cells.insert(m_cells.end(), row.begin(), row.end());
+        m_rowOffsets[i + 1] = m_cells.size();
+    }
+}
+
+std::uint32_t PathCells::getHeight() const
+{
+    return m_rowOffsets.size() - 1;
+}
+
+PathRowCursor::PathRowCursor(Path const &path, bool upward) :
+    m_path{path},
+    m_upward{upward},
+    m_row{upward ? path.getHeight() - 1 : 0},
+    m_band{std::min(bandHeight, path.getHeight()), path.getWidth(), 3},
+    m_bandIndex{UINT32_MAX},
+    m_firstWords(bandHeight, UINT32_MAX),
+    m_lastWords(bandHeight, 0)
+{
+    std::uint32_t height = path.getHeight();
+    m_entryOffsets.resize((height + bandHeight - 1) / bandHeight + 1);
+    if (height == 0) {
+        return;
+    }
+    // Collect entries in order of the path, then sort them by bands.
+    std::vector<Entry> entries;
+    std::uint64_t cell = 0;
+    std::uint32_t i = path.getStartRow();
+    std::uint32_t j = path.getStartColumn();
+    entries.push_back({cell, i, j});
+    path.directions().forEach([&](Path::Direction direction) {
+        std::uint32_t band = i / bandHeight;
+        switch (direction) {
+            case Path::Up:
+                i--;
+                break;
+            case Path::Down:
+                i++;
+                break;
+            case Path::Left:
+                j--;
+                break;
+            default:
+                j++;
+        }
+        cell++;
+        if (i / bandHeight != band) {
+            entries.push_back({cell, i, j});
+        }
+    });
+    for (Entry const &entry : entries) {
+        m_entryOffsets[entry.row / bandHeight + 1]++;
+    }
+    for (std::uint64_t b = 1; b < m_entryOffsets.size(); b++) {
+        m_entryOffsets[b] += m_entryOffsets[b - 1];
+    }
+    m_entries.resize(entries.size());
+    for (Entry const &entry : entries) {
+        m_entries[m_entryOffsets[entry.row / bandHeight]++] = entry;
+    }
+    // Storing entries advanced the offset of each band to the offset of the next one.
+    for (std::uint64_t b = m_entryOffsets.size() - 1; b > 0; b--) {
+        m_entryOffsets[b] = m_entryOffsets[b - 1];
+    }
+    m_entryOffsets[0] = 0;
+}
+
+void PathRowCursor::loadBand(std::uint32_t band)
+{
+    Path::Directions const &directions = m_path.directions();
+    std::uint64_t length = directions.size();
+    std::uint32_t firstRow = band * bandHeight;
+    std::uint32_t rowCount = std::min(bandHeight, m_path.getHeight() - firstRow);
+    for (std::uint64_t e = m_entryOffsets[band]; e < m_entryOffsets[band + 1]; e++) {
+        std::uint64_t cell = m_entries[e].cell;
+        std::uint32_t i = m_entries[e].row;
+        std::uint32_t j = m_entries[e].column;
+        // Directions before the first and after the last cell are replaced by ones
+        // which do not connect the cell above or left.
+        Path::Direction before = cell != 0 ? directions.get(cell - 1) : Path::Up;
+        while (i - firstRow < rowCount) {
+            Path::Direction after = cell != length ? directions.get(cell) : Path::Down;
+            std::uint32_t r = i - firstRow;
+            std::uint64_t bit = static_cast<std::uint64_t>(1) << (j & 63);
+            m_band.row(r, Cells)[j >> 6] |= bit;
+            if (before == Path::Down || after == Path::Up) {
+                m_band.row(r, CellsAbove)[j >> 6] |= bit;
+            }
+            if (before == Path::Right || after == Path::Left) {
+                m_band.row(r, CellsLeft)[j >> 6] |= bit;
+            }
+            m_firstWords[r] = std::min(m_firstWords[r], j >> 6);
+            m_lastWords[r] = std::max(m_lastWords[r], j >> 6);
+            if (cell == length) {
+                break;
+            }
+            switch (after) {
+                case Path::Up:
+                    i--;
+                    break;
+                case Path::Down:
+                    i++;
+                    break;
+                case Path::Left:
+                    j--;
+                    break;
+                default:
+                    j++;
+            }
+            before = after;
+            cell++;
+        }
+    }
+}
+
+PathCellRow PathRowCursor::next()
+{
+    std::uint32_t band = m_row / bandHeight;
+    if (band != m_bandIndex) {
+        loadBand(band);
+        m_bandIndex = band;
+    }
+    std::uint32_t r = m_row - band * bandHeight;
+    m_rowCells.clear();
+    for (std::uint32_t w = m_firstWords[r]; w <= m_lastWords[r] && w != UINT32_MAX; w++) {
+        std::uint64_t &cells = m_band.row(r, Cells)[w];
+        std::uint64_t &above = m_band.row(r, CellsAbove)[w];
+        std::uint64_t &left = m_band.row(r, CellsLeft)[w];
+        while (cells != 0) {
+            std::uint32_t bit = BitPlanes::bitCount((cells & (~cells + 1)) - 1);
+            m_rowCells.push_back({(w << 6) + bit,
+                static_cast<bool>((above >> bit) & 1), static_cast<bool>((left >> bit) & 1)});
+            cells &= cells - 1;
+        }
+        above = 0;
+        left = 0;
+    }
+    m_firstWords[r] = UINT32_MAX;
+    m_lastWords[r] = 0;
+    m_row += m_upward ? -1 : 1;
+    return {m_rowCells.data(), m_rowCells.size()};
+}
+
+void PathRowCursor::seek(std::uint32_t row)
+{
+    if (row == m_row) {
+        return;
+    }
+    // Rows returned by next are cleared and the others are still marked, so the band
+    // of the row is loaded again, and the rows which next would have returned before
+    // the row are cleared, as they would be when it returns them.
+    m_band.clear();
+    std::fill(m_firstWords.begin(), m_firstWords.end(), UINT32_MAX);
+    std::fill(m_lastWords.begin(), m_lastWords.end(), 0);
+    m_row = row;
+    m_bandIndex = UINT32_MAX;
+    if (row >= m_path.getHeight()) {
+        return;
+    }
+    m_bandIndex = row / bandHeight;
+    loadBand(m_bandIndex);
+    std::uint32_t firstRow = m_bandIndex * bandHeight;
+    std::uint32_t rowCount = std::min(bandHeight, m_path.getHeight() - firstRow);
+    for (std::uint32_t r = 0; r < rowCount; r++) {
+        if (m_upward ? firstRow + r > row : firstRow + r < row) {
+            for (std::uint32_t plane = Cells; plane <= CellsLeft; plane++) {
+                std::fill_n(m_band.row(r, plane), m_band.getRowWords(), 0);
+            }
+            m_firstWords[r] = UINT32_MAX;
+            m_lastWords[r] = 0;
+        }
+    }
 }
\ No newline at end of file
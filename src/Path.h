@@ -4,6 +4,8 @@
 #include <cstdint>
 #include <vector>
 #include <string>
+#include <PackedDirections.h>
+#include <BitPlanes.h>
 
 // Path cell in a maze.
 struct PathCell {
@@ -12,6 +14,33 @@ struct PathCell {
     bool left; // true if the cell is connected to the cell left to it
 };
 
+// Path cells in one row of a maze, sorted from left to right.
+class PathCellRow {
+
+    PathCell const *m_cells;
+
+    std::uint64_t m_size;
+
+public:
+
+    PathCellRow(PathCell const *cells, std::uint64_t size);
+
+    PathCell const *data() const;
+
+    std::uint64_t size() const;
+
+    bool empty() const;
+
+    PathCell const &operator[](std::uint64_t k) const;
+
+    PathCell const *begin() const;
+
+    PathCell const *end() const;
+
+};
+
+class PathCells;
+
 // Path in a maze.
 class Path {
 
@@ -19,6 +48,27 @@ public:
 
     enum Direction {Up, Down, Left, Right};
 
+    // Summary of a path, computed in one pass over its directions.
+    struct Statistics {
+        // Integral of the path (see integral).
+        std::int64_t integral;
+        // Bounding box of the path cells.
+        std::uint32_t minRow;
+        std::uint32_t maxRow;
+        std::uint32_t minColumn;
+        std::uint32_t maxColumn;
+        // Number of steps toward each direction, indexed by Direction.
+        std::uint64_t directionCounts[4];
+        // Number of left and right turns between consecutive steps.
+        std::uint64_t leftTurns;
+        std::uint64_t rightTurns;
+        // Rotation number in quarter turns: left turns minus right turns.
+        std::int64_t rotation;
+    };
+
+    // Directions packed with 2 bits per step.
+    using Directions = PackedDirections<Direction>;
+
 private:
 
     // Maze height.
@@ -34,7 +84,7 @@ private:
     std::uint32_t m_startColumn;
 
     // Path directions.
-    std::vector<Direction> m_directions;
+    Directions m_directions;
 
 public:
 
@@ -42,18 +92,27 @@ public:
 
     std::uint32_t getWidth() const;
 
+    std::uint32_t getStartRow() const;
+
+    std::uint32_t getStartColumn() const;
+
     // Path length.
     std::uint64_t length() const;
 
+    // Path directions.
+    Directions const &directions() const;
+
     // Empty path.
     Path();
 
     // Path with given start cell position and directions.
     Path(std::uint32_t height, std::uint32_t width,
         std::uint32_t startRow, std::uint32_t startColumn,
-        std::vector<Direction> const &directions);
+        Directions directions);
 
     // Read path from a BMP file. Return empty path if failed.
+    // Rows are decoded one at a time and only cells with connections are kept,
+    // so that memory follows the path length and the image width, not its area.
     Path(std::string const &fileName);
 
     // Random path in a table of size height x width from
@@ -65,15 +124,16 @@ public:
         std::uint32_t i1, std::uint32_t j1, std::uint32_t i2, std::uint32_t j2,
         std::uint16_t pastDecisionCount, std::uint16_t pastDecisionRelevance);
 
-    // Cells contained in the path, where i-th element of the return vector
-    // contains all cells in i-th row, sorted from left to right.
-    std::vector<std::vector<PathCell>> cells() const;
+    // Cells contained in the path, where the i-th row contains
+    // all cells in the i-th row of the maze, sorted from left to right.
+    PathCells cells() const;
 
     // View path as a string.
     std::string toString() const;
 
-    // Save as BMP file. Return false if failed.
-    bool toBMP(std::string const &fileName) const;
+    // Save as BMP file, encoding bands of rows by up to threadCount threads (all hardware
+    // threads if threadCount = 0), as Maze::toBMP. Return false if failed.
+    bool toBMP(std::string const &fileName, std::uint32_t threadCount = 0) const;
 
     // The integral of a path is the sum of i-components of point in the path
     // having predecessor on the left minus the sum of i-components of points
@@ -81,6 +141,132 @@ public:
     // signed area above the path curve.
     std::int64_t integral() const;
 
+    // Integral of a path starting in row startRow with given directions.
+    static std::int64_t integral(std::uint32_t startRow, Directions const &directions);
+
+    // Integral, bounding box, direction counts and turns of the path,
+    // reading four directions at a time through a lookup table.
+    Statistics stats() const;
+
+};
+
+// Cells of a path, grouped by rows (see Path::cells), stored in one array
+// with the offset of the first cell of each row.
+class PathCells {
+
+    // Offset of the first cell of each row, and the number of cells.
+    std::vector<std::uint64_t> m_rowOffsets;
+
+    // Cells of all rows.
+    std::vector<PathCell> m_cells;
+
+public:
+
+    // Cells of given path, copied row by row from a PathRowCursor.
+    PathCells(Path const &path);
+
+    std::uint32_t getHeight() const;
+
+    // Cells in the i-th row.
+    PathCellRow operator[](std::uint32_t i) const;
+
+};
+
+// Cells of a path one row at a time, from the top row down or from the bottom row up,
+// without building PathCells. Rows are processed in bands of bandHeight rows: the path
+// is walked once to find where it enters each band, then for each band only the parts
+// of the path inside the band are walked and their cells marked in bit-planes, which
+// are read row by row in order of columns. Apart from the path, memory usage is
+// O(width + number of times the path enters a band).
+class PathRowCursor {
+
+    // Position of the path cell of given index, where the path enters a band.
+    struct Entry {
+        std::uint64_t cell;
+        std::uint32_t row;
+        std::uint32_t column;
+    };
+
+    // Planes of cells of the current band.
+    enum CellPlane {Cells, CellsAbove, CellsLeft};
+
+    static constexpr std::uint32_t bandHeight = 64;
+
+    Path const &m_path;
+
+    bool m_upward;
+
+    // Index of the next row.
+    std::uint32_t m_row;
+
+    // Entries of all bands, band b having entries [m_entryOffsets[b], m_entryOffsets[b + 1]).
+    std::vector<std::uint64_t> m_entryOffsets;
+    std::vector<Entry> m_entries;
+
+    // Marked cells of the current band, and the range of marked words in each of its rows.
+    BitPlanes m_band;
+    std::uint32_t m_bandIndex;
+    std::vector<std::uint32_t> m_firstWords;
+    std::vector<std::uint32_t> m_lastWords;
+
+    // Cells of the last returned row.
+    std::vector<PathCell> m_rowCells;
+
+    // Mark cells of the given band.
+    void loadBand(std::uint32_t band);
+
+public:
+
+    // Cursor over rows of path, starting from row 0 or, if upward is true,
+    // from the last row. The path must outlive the cursor.
+    PathRowCursor(Path const &path, bool upward = false);
+
+    // Cells in the next row, valid until the next call.
+    PathCellRow next();
+
+    // Make the given row the next one.
+    void seek(std::uint32_t row);
+
 };
 
+inline PathCellRow::PathCellRow(PathCell const *cells, std::uint64_t size) :
+    m_cells{cells},
+    m_size{size}
+{}
+
+inline PathCell const *PathCellRow::data() const
+{
+    return m_cells;
+}
+
+inline std::uint64_t PathCellRow::size() const
+{
+    return m_size;
+}
+
+inline bool PathCellRow::empty() const
+{
+    return m_size == 0;
+}
+
+inline PathCell const &PathCellRow::operator[](std::uint64_t k) const
+{
+    return m_cells[k];
+}
+
+inline PathCell const *PathCellRow::begin() const
+{
+    return m_cells;
+}
+
+inline PathCell const *PathCellRow::end() const
+{
+    return m_cells + m_size;
+}
+
+inline PathCellRow PathCells::operator[](std::uint32_t i) const
+{
+    return {m_cells.data() + m_rowOffsets[i], m_rowOffsets[i + 1] - m_rowOffsets[i]};
+}
+
 #endif
\ No newline at end of file
@@ -0,0 +1,105 @@
+#include <cstdint>
+#include <string>
+#include <algorithm>
+#include <PositionalFile.h>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/types.h>
+#include <unistd.h>
+#endif
+
+namespace {
+
+#ifndef _WIN32
+    // File descriptors are stored shifted by 1, so that nullptr is no file.
+    int descriptor(void *handle)
+    {
+        return static_cast<int>(reinterpret_cast<std::intptr_t>(handle) - 1);
+    }
+#endif
+
+}
+
+PositionalFile::PositionalFile(std::string const &fileName, std::uint64_t size) :
+    m_handle{nullptr}
+{
+#ifdef _WIN32
+    HANDLE file = CreateFileA(fileName.c_str(), GENERIC_WRITE, 0, nullptr,
+        OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE) {
+        return;
+    }
+    m_handle = file;
+    LARGE_INTEGER end;
+    end.QuadPart = static_cast<LONGLONG>(size);
+    if (!SetFilePointerEx(file, end, nullptr, FILE_BEGIN) || !SetEndOfFile(file)) {
+        close();
+    }
+#else
+    int file = ::open(fileName.c_str(), O_WRONLY);
+    if (file < 0) {
+        return;
+    }
+    m_handle = reinterpret_cast<void *>(static_cast<std::intptr_t>(file) + 1);
+    if (ftruncate(file, static_cast<off_t>(size)) != 0) {
+        close();
+    }
+#endif
+}
+
+PositionalFile::~PositionalFile()
+{
+    close();
+}
+
+void PositionalFile::close()
+{
+    if (m_handle != nullptr) {
+#ifdef _WIN32
+        CloseHandle(m_handle);
+#else
+        ::close(descriptor(m_handle));
+#endif
+    }
+    m_handle = nullptr;
+}
+
+bool PositionalFile::isOpen() const
+{
+    return m_handle != nullptr;
+}
+
+bool PositionalFile::write(std::uint64_t offset, char const *data, std::uint64_t size) const
+{
+    if (m_handle == nullptr) {
+        return false;
+    }
+    // Writes may be shorter than asked for, and are limited to 1 GiB each.
+    while (size != 0) {
+        std::uint64_t chunk = std::min<std::uint64_t>(size, static_cast<std::uint64_t>(1) << 30);
+#ifdef _WIN32
+        OVERLAPPED position = {};
+        position.Offset = static_cast<DWORD>(offset);
+        position.OffsetHigh = static_cast<DWORD>(offset >> 32);
+        DWORD written;
+        if (!WriteFile(m_handle, data, static_cast<DWORD>(chunk), &written, &position) ||
+            written == 0)
+        {
+            return false;
+        }
+#else
+        ssize_t written = pwrite(descriptor(m_handle), data, static_cast<std::size_t>(chunk),
+            static_cast<off_t>(offset));
+        if (written <= 0) {
+            return false;
+        }
+#endif
+        offset += static_cast<std::uint64_t>(written);
+        data += written;
+        size -= static_cast<std::uint64_t>(written);
+    }
+    return true;
+}
\ No newline at end of file
@@ -0,0 +1,38 @@
+#ifndef POSITIONALFILE_H
+#define POSITIONALFILE_H
+
+#include <cstdint>
+#include <string>
+
+// File opened for writing at given offsets (pwrite, or WriteFile with an offset on Windows),
+// so that several threads can write different parts of it at once without seeking.
+class PositionalFile {
+
+    // Operating system handle of the file (a file descriptor stored in a pointer
+    // outside Windows), or nullptr if not open.
+    void *m_handle;
+
+    void close();
+
+public:
+
+    // Open an existing file for writing, keeping its contents, and extend or truncate it
+    // to given size. Result is not open if failed.
+    PositionalFile(std::string const &fileName, std::uint64_t size);
+
+    PositionalFile(PositionalFile const &) = delete;
+
+    PositionalFile &operator=(PositionalFile const &) = delete;
+
+    ~PositionalFile();
+
+    // Return true if the file is open.
+    bool isOpen() const;
+
+    // Write size bytes of data at given offset. May be called by several threads at once
+    // for ranges which do not overlap. Return false if failed.
+    bool write(std::uint64_t offset, char const *data, std::uint64_t size) const;
+
+};
+
+#endif
\ No newline at end of file
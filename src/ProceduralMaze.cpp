@@ -0,0 +1,269 @@
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <sstream>
+#include <fstream>
+#include <filesystem>
+#include <algorithm>
+#include <Utilities.h>
+#include <Path.h>
+#include <BitPlanes.h>
+#include <TreeMazeGenerator.h>
+#include <MazeSolver.h>
+#include <ProceduralMaze.h>
+
+namespace {
+
+    // Checkpoint file: signature, then a header of 32-bit values identifying the maze
+    // (see checkpointHeader), then for each checkpoint its size in bytes and its bytes.
+    char const checkpointSignature[4] = {'L', 'M', 'Z', 'C'};
+
+    constexpr std::uint32_t checkpointHeaderSize = 14;
+
+    // Hash of the packed directions of a path, so that checkpoints of another path
+    // with the same size, start, end and length are not taken for its own.
+    std::uint64_t directionsHash(Path::Directions const &directions)
+    {
+        std::uint64_t hash = directions.size();
+        for (std::uint64_t k = 0; k < directions.wordCount(); k++) {
+            hash = (hash ^ directions.word(k)) * 0x9e3779b97f4a7c15;
+            hash ^= hash >> 32;
+        }
+        return hash;
+    }
+
+    void checkpointHeader(Path const &path, std::int32_t seed,
+        std::vector<std::uint8_t> const &probabilitySet, std::uint32_t checkpointInterval,
+        std::uint32_t *header)
+    {
+        std::uint8_t probabilities[8] = {};
+        std::copy_n(probabilitySet.begin(), std::min<std::size_t>(probabilitySet.size(), 6),
+            probabilities);
+        std::uint64_t length = path.length();
+        Path::Statistics statistics = path.stats();
+        std::uint64_t hash = directionsHash(path.directions());
+        header[0] = path.getHeight();
+        header[1] = path.getWidth();
+        header[2] = static_cast<std::uint32_t>(seed);
+        header[3] = checkpointInterval;
+        header[4] = path.getStartRow();
+        header[5] = path.getStartColumn();
+        header[6] = static_cast<std::uint32_t>(length);
+        header[7] = static_cast<std::uint32_t>(length >> 32);
+        header[8] = probabilities[0] | probabilities[1] << 8 | probabilities[2] << 16 |
+            static_cast<std::uint32_t>(probabilities[3]) << 24;
+        header[9] = probabilities[4] | probabilities[5] << 8;
+        header[10] = static_cast<std::uint32_t>(path.getStartRow() +
+            statistics.directionCounts[Path::Down] - statistics.directionCounts[Path::Up]);
+        header[11] = static_cast<std::uint32_t>(path.getStartColumn() +
+            statistics.directionCounts[Path::Right] - statistics.directionCounts[Path::Left]);
+        header[12] = static_cast<std::uint32_t>(hash);
+        header[13] = static_cast<std::uint32_t>(hash >> 32);
+    }
+
+    // Read checkpoints from a checkpoint file with given header, up to the last complete one.
+    // Return the size of the file up to there, or 0 if the file is missing or has another header.
+    std::uint64_t readCheckpoints(std::string const &fileName, std::uint32_t const *header,
+        std::vector<std::string> &checkpoints)
+    {
+        std::ifstream file(fileName, std::ios::binary);
+        char signature[sizeof(checkpointSignature)];
+        std::uint32_t fileHeader[checkpointHeaderSize];
+        if (!file.read(signature, sizeof(signature)) ||
+            !std::equal(signature, signature + sizeof(signature), checkpointSignature) ||
+            !Utilities::readUint32s(file, fileHeader, checkpointHeaderSize) ||
+            !std::equal(fileHeader, fileHeader + checkpointHeaderSize, header))
+        {
+            return 0;
+        }
+        std::uint64_t size = sizeof(signature) + (checkpointHeaderSize << 2);
+        std::uint32_t checkpointSize;
+        while (Utilities::readUint32s(file, &checkpointSize, 1)) {
+            std::string checkpoint(checkpointSize, '\0');
+            if (!file.read(checkpoint.data(), checkpointSize)) {
+                break;
+            }
+            checkpoints.push_back(std::move(checkpoint));
+            size += 4 + static_cast<std::uint64_t>(checkpointSize);
+        }
+        return size;
+    }
+
+}
+
+ProceduralMaze::ProceduralMaze(Path const &path, std::int32_t seed,
+    std::vector<std::uint8_t> const &probabilitySet, std::uint32_t checkpointInterval,
+    std::string const &checkpointFileName, std::uint32_t blockHeight, std::uint32_t cacheBlocks) :
+    m_path{path},
+    m_checkpointInterval{std::max(checkpointInterval, 1u)},
+    m_blockHeight{std::max(blockHeight, 1u)},
+    m_cursor{m_path},
+    m_generator{m_path.getWidth(), seed, probabilitySet},
+    m_nextRow{0},
+    m_clock{0},
+    m_block{nullptr}
+{
+    std::uint32_t height = getHeight();
+    std::uint32_t width = getWidth();
+    std::uint32_t header[checkpointHeaderSize];
+    checkpointHeader(m_path, seed, probabilitySet, m_checkpointInterval, header);
+    std::ofstream file;
+    if (!checkpointFileName.empty()) {
+        // Continue from the last complete checkpoint of an earlier run, dropping
+        // a checkpoint which was being written when it stopped.
+        std::uint64_t size = readCheckpoints(checkpointFileName, header, m_checkpoints);
+        while (!m_checkpoints.empty()) {
+            std::istringstream stream(m_checkpoints.back());
+            if (m_generator.load(stream)) {
+                break;
+            }
+            size -= 4 + m_checkpoints.back().size();
+            m_checkpoints.pop_back();
+        }
+        if (size != 0) {
+            std::filesystem::resize_file(checkpointFileName, size);
+            file.open(checkpointFileName, std::ios::binary | std::ios::app);
+        }
+        else {
+            file.open(checkpointFileName, std::ios::binary);
+            file.write(checkpointSignature, sizeof(checkpointSignature));
+            Utilities::writeUint32s(file, header, checkpointHeaderSize);
+        }
+        if (!m_checkpoints.empty()) {
+            m_nextRow = static_cast<std::uint32_t>(std::min<std::uint64_t>(height,
+                static_cast<std::uint64_t>(m_checkpoints.size() - 1) * m_checkpointInterval));
+            m_cursor.seek(m_nextRow);
+        }
+    }
+    std::vector<std::uint64_t> verticalWalls((width + 63) >> 6);
+    std::vector<std::uint64_t> horizontalWalls((width + 63) >> 6);
+    while (m_nextRow < height) {
+        if (m_nextRow % m_checkpointInterval == 0 &&
+            m_nextRow / m_checkpointInterval == m_checkpoints.size())
+        {
+            std::ostringstream stream;
+            m_generator.save(stream);
+            m_checkpoints.push_back(stream.str());
+            if (file.is_open()) {
+                std::uint32_t checkpointSize = static_cast<std::uint32_t>(m_checkpoints.back().size());
+                Utilities::writeUint32s(file, &checkpointSize, 1);
+                file.write(m_checkpoints.back().data(), checkpointSize);
+                file.flush();
+            }
+        }
+        generateRow(verticalWalls.data(), horizontalWalls.data());
+    }
+    m_blocks.reserve(std::max(cacheBlocks, 1u));
+    for (std::uint32_t k = 0; k < std::max(cacheBlocks, 1u); k++) {
+        m_blocks.push_back({UINT32_MAX, 0, BitPlanes(std::min(m_blockHeight, height), width, 2)});
+    }
+}
+
+std::uint32_t ProceduralMaze::getCheckpointInterval() const
+{
+    return m_checkpointInterval;
+}
+
+std::uint32_t ProceduralMaze::checkpointCount() const
+{
+    return static_cast<std::uint32_t>(m_checkpoints.size());
+}
+
+std::uint64_t ProceduralMaze::checkpointBytes() const
+{
+    std::uint64_t bytes = 0;
+    for (std::string const &checkpoint : m_checkpoints) {
+        bytes += checkpoint.size();
+    }
+    return bytes;
+}
+
+ProceduralMaze::Statistics const &ProceduralMaze::getStatistics() const
+{
+    return m_statistics;
+}
+
+void ProceduralMaze::resetStatistics()
+{
+    m_statistics = Statistics();
+}
+
+void ProceduralMaze::generateRow(std::uint64_t *verticalWalls, std::uint64_t *horizontalWalls) const
+{
+    PathCellRow rowCells = m_cursor.next();
+    m_generator.generateRow(rowCells.data(), rowCells.size(), verticalWalls, horizontalWalls);
+    if (m_nextRow == getHeight() - 1) {
+        m_generator.finish(verticalWalls);
+    }
+    if (m_nextRow == 0) {
+        std::fill_n(horizontalWalls, (getWidth() + 63) >> 6, 0);
+    }
+    m_nextRow++;
+}
+
+void ProceduralMaze::enterBlock(std::uint32_t i) const
+{
+    std::uint32_t firstRow = i - i % m_blockHeight;
+    m_statistics.blockLookups++;
+    Block *block = &m_blocks[0];
+    for (Block &cached : m_blocks) {
+        if (cached.firstRow == firstRow) {
+            block = &cached;
+            break;
+        }
+        if (cached.lastUse < block->lastUse) {
+            block = &cached;
+        }
+    }
+    if (block->firstRow == firstRow) {
+        m_statistics.hits++;
+    }
+    else {
+        // Continue the generator if it is between the nearest checkpoint and the block,
+        // otherwise restore it from the checkpoint.
+        std::uint32_t checkpoint = firstRow / m_checkpointInterval;
+        std::uint32_t checkpointRow = checkpoint * m_checkpointInterval;
+        if (m_nextRow > firstRow || m_nextRow < checkpointRow) {
+            std::istringstream stream(m_checkpoints[checkpoint]);
+            m_generator.load(stream);
+            m_nextRow = checkpointRow;
+            m_cursor.seek(checkpointRow);
+            m_statistics.replays++;
+        }
+        std::uint32_t rowEnd = std::min(getHeight() - firstRow, m_blockHeight) + firstRow;
+        m_statistics.generatedRows += rowEnd - m_nextRow;
+        while (m_nextRow < firstRow) {
+            generateRow(block->walls.row(0, 0), block->walls.row(0, 1));
+        }
+        while (m_nextRow < rowEnd) {
+            std::uint32_t r = m_nextRow - firstRow;
+            generateRow(block->walls.row(r, 0), block->walls.row(r, 1));
+        }
+        block->firstRow = firstRow;
+    }
+    block->lastUse = ++m_clock;
+    m_block = block;
+}
+
+void ProceduralMaze::decodeRow(std::uint32_t i,
+    std::uint64_t *verticalWalls, std::uint64_t *horizontalWalls) const
+{
+    if (m_block == nullptr || i - m_block->firstRow >= m_blockHeight) {
+        enterBlock(i);
+    }
+    std::uint32_t r = i - m_block->firstRow;
+    std::copy_n(m_block->walls.row(r, 0), (getWidth() + 63) >> 6, verticalWalls);
+    std::copy_n(m_block->walls.row(r, 1), (getWidth() + 63) >> 6, horizontalWalls);
+}
+
+Path ProceduralMaze::solve(std::uint32_t i1, std::uint32_t j1,
+    std::uint32_t i2, std::uint32_t j2, MazeSolver::Statistics *statistics) const
+{
+    return MazeSolver::wallFollower(*this, i1, j1, i2, j2, statistics);
+}
+
+Path ProceduralMaze::solveAStar(std::uint32_t i1, std::uint32_t j1,
+    std::uint32_t i2, std::uint32_t j2, MazeSolver::Statistics *statistics) const
+{
+    return MazeSolver::pagedBidirectionalAStar(*this, i1, j1, i2, j2, statistics);
+}
\ No newline at end of file
@@ -0,0 +1,174 @@
+#ifndef PROCEDURALMAZE_H
+#define PROCEDURALMAZE_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <Path.h>
+#include <BitPlanes.h>
+#include <TreeMazeGenerator.h>
+#include <MazeSolver.h>
+
+// Tree maze as in Maze(path, seed, probabilitySet), stored as checkpoints of its generator
+// instead of walls. The state TreeMazeGenerator carries between rows is saved before every
+// checkpointInterval-th row, and blocks of rows are generated again on demand, continuing
+// from the last generated row or from the nearest checkpoint above, into a small cache.
+// Each checkpoint takes about 16 * width bytes, instead of checkpointInterval * width / 4
+// bytes of walls. Queries modify the cache, so a ProceduralMaze must not be queried by
+// several threads at once.
+class ProceduralMaze {
+
+public:
+
+    // Work done by queries since construction or the last resetStatistics.
+    struct Statistics {
+        // Queries in another block of rows than the previous query,
+        // and those of them which found the block in the cache.
+        std::uint64_t blockLookups = 0;
+        std::uint64_t hits = 0;
+        // Generator states restored from checkpoints, and rows generated again.
+        std::uint64_t replays = 0;
+        std::uint64_t generatedRows = 0;
+    };
+
+private:
+
+    // Cached block of rows.
+    struct Block {
+        std::uint32_t firstRow;
+        std::uint64_t lastUse;
+        BitPlanes walls;
+    };
+
+    Path m_path;
+
+    std::uint32_t m_checkpointInterval;
+
+    std::uint32_t m_blockHeight;
+
+    // Saved generator states before rows 0, checkpointInterval, 2 * checkpointInterval, ...
+    std::vector<std::string> m_checkpoints;
+
+    // Generator and path cursor positioned before row m_nextRow.
+    mutable PathRowCursor m_cursor;
+    mutable TreeMazeGenerator m_generator;
+    mutable std::uint32_t m_nextRow;
+
+    // Cached blocks, with planes 0 (vertical walls) and 1 (horizontal walls).
+    mutable std::vector<Block> m_blocks;
+
+    // Counter of block lookups, giving lastUse of cached blocks.
+    mutable std::uint64_t m_clock;
+
+    // Block of the last query.
+    mutable Block const *m_block;
+
+    mutable Statistics m_statistics;
+
+    // Generate the next row into given words, finishing the maze after the last row.
+    void generateRow(std::uint64_t *verticalWalls, std::uint64_t *horizontalWalls) const;
+
+    // Make the block containing row i the current block.
+    void enterBlock(std::uint32_t i) const;
+
+    // Bit (i, j) of the vertical walls (plane 0) or horizontal walls (plane 1),
+    // see Maze::verticalWalls and Maze::horizontalWalls.
+    bool wallBit(std::uint32_t i, std::uint32_t j, std::uint32_t plane) const;
+
+public:
+
+    static constexpr std::uint32_t defaultCheckpointInterval = 1024;
+
+    static constexpr std::uint32_t defaultBlockHeight = 64;
+
+    static constexpr std::uint32_t defaultCacheBlocks = 4;
+
+    // Run the generator of Maze(path, seed, probabilitySet) once over all rows, saving
+    // a checkpoint before every checkpointInterval-th row. Rows are then cached in blocks
+    // of blockHeight rows, up to cacheBlocks blocks.
+    // If checkpointFileName is not empty, each checkpoint is also appended to that file as
+    // soon as it is saved; if the file already holds checkpoints of the same maze (for
+    // example from an interrupted run), generation continues from the last complete one.
+    ProceduralMaze(Path const &path, std::int32_t seed,
+        std::vector<std::uint8_t> const &probabilitySet = {163, 118, 123, 123, 94, 103},
+        std::uint32_t checkpointInterval = defaultCheckpointInterval,
+        std::string const &checkpointFileName = "",
+        std::uint32_t blockHeight = defaultBlockHeight,
+        std::uint32_t cacheBlocks = defaultCacheBlocks);
+
+    // The cursor refers to the stored path.
+    ProceduralMaze(ProceduralMaze const &) = delete;
+    ProceduralMaze &operator=(ProceduralMaze const &) = delete;
+
+    std::uint32_t getHeight() const;
+
+    std::uint32_t getWidth() const;
+
+    std::uint32_t getCheckpointInterval() const;
+
+    // Number of checkpoints and their total size in bytes.
+    std::uint32_t checkpointCount() const;
+
+    std::uint64_t checkpointBytes() const;
+
+    Statistics const &getStatistics() const;
+
+    void resetStatistics();
+
+    // Return true if the (i, j)-th cell cannot be left toward given direction,
+    // either because of a wall or because of the maze border.
+    bool hasWall(std::uint32_t i, std::uint32_t j, Path::Direction direction) const;
+
+    // Decode walls of the i-th row into verticalWalls and horizontalWalls
+    // (see Maze::verticalWalls and Maze::horizontalWalls),
+    // overwriting their first (width + 63) / 64 words.
+    void decodeRow(std::uint32_t i,
+        std::uint64_t *verticalWalls, std::uint64_t *horizontalWalls) const;
+
+    // Find path between given cells using "always turn left" algoritm (see Maze::solve).
+    Path solve(std::uint32_t i1, std::uint32_t j1, std::uint32_t i2, std::uint32_t j2,
+        MazeSolver::Statistics *statistics = nullptr) const;
+
+    // Find a shortest path between given cells using bidirectional A* search
+    // (see Maze::solveAStar), generating only rows with expanded cells. The search state
+    // is kept only for pages of cells it reaches (see MazeSolver::pagedBidirectionalAStar),
+    // so memory follows the number of expanded cells, not the maze size.
+    Path solveAStar(std::uint32_t i1, std::uint32_t j1, std::uint32_t i2, std::uint32_t j2,
+        MazeSolver::Statistics *statistics = nullptr) const;
+
+};
+
+inline std::uint32_t ProceduralMaze::getHeight() const
+{
+    return m_path.getHeight();
+}
+
+inline std::uint32_t ProceduralMaze::getWidth() const
+{
+    return m_path.getWidth();
+}
+
+inline bool ProceduralMaze::wallBit(std::uint32_t i, std::uint32_t j, std::uint32_t plane) const
+{
+    if (m_block == nullptr || i - m_block->firstRow >= m_blockHeight) {
+        enterBlock(i);
+    }
+    return m_block->walls.get(i - m_block->firstRow, j, plane);
+}
+
+inline bool ProceduralMaze::hasWall(std::uint32_t i, std::uint32_t j,
+    Path::Direction direction) const
+{
+    switch (direction) {
+        case Path::Up:
+            return i == 0 || wallBit(i, j, 1);
+        case Path::Down:
+            return i == getHeight() - 1 || wallBit(i + 1, j, 1);
+        case Path::Left:
+            return j == 0 || wallBit(i, j, 0);
+        default:
+            return j == getWidth() - 1 || wallBit(i, j + 1, 0);
+    }
+}
+
+#endif
\ No newline at end of file
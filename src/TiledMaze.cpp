@@ -0,0 +1,131 @@
+#include <cstdint>
+#include <cstdlib>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <LMZFile.h>
+#include <MazeSolver.h>
+#include <TiledMaze.h>
+
+double TiledMaze::CacheStatistics::hitRate() const
+{
+    return tileLookups == 0 ? 1 : static_cast<double>(hits) / tileLookups;
+}
+
+TiledMaze::TiledMaze(std::string const &fileName, std::uint64_t cacheBytes) :
+    m_file(fileName),
+    m_capacity{0},
+    m_clock{0},
+    m_tile{nullptr},
+    m_tileTop{0},
+    m_tileLeft{0},
+    m_tileHeight{0},
+    m_tileWidth{0},
+    m_prefetchedTile{UINT64_MAX}
+{
+    std::uint64_t tileBytes = isOpen() ? m_file.tileWords(0) << 3 : 1;
+    std::uint64_t tileCount = static_cast<std::uint64_t>(m_file.tileRows()) * m_file.tileColumns();
+    m_capacity = static_cast<std::uint32_t>(std::max<std::uint64_t>(4,
+        std::min(cacheBytes / tileBytes, tileCount)));
+    m_cache.reserve(m_capacity);
+}
+
+bool TiledMaze::isOpen() const
+{
+    return m_file.isOpen();
+}
+
+std::uint32_t TiledMaze::getCacheCapacity() const
+{
+    return m_capacity;
+}
+
+TiledMaze::CacheStatistics const &TiledMaze::getStatistics() const
+{
+    return m_statistics;
+}
+
+void TiledMaze::resetStatistics()
+{
+    m_statistics = CacheStatistics();
+}
+
+void TiledMaze::enterTile(std::uint32_t i, std::uint32_t j) const
+{
+    std::uint32_t tileRow = i / m_file.getTileHeight();
+    std::uint32_t tileColumn = j / m_file.getTileWidth();
+    std::uint64_t tile = static_cast<std::uint64_t>(tileRow) * m_file.tileColumns() + tileColumn;
+    m_statistics.tileLookups++;
+    std::uint32_t slot;
+    auto found = m_slots.find(tile);
+    if (found != m_slots.end()) {
+        m_statistics.hits++;
+        slot = found->second;
+    }
+    else {
+        m_statistics.misses++;
+        if (m_cache.size() < m_capacity) {
+            slot = static_cast<std::uint32_t>(m_cache.size());
+            m_cache.push_back({tile, 0, std::vector<std::uint64_t>(m_file.tileWords(0))});
+        }
+        else {
+            slot = 0;
+            for (std::uint32_t k = 1; k < m_cache.size(); k++) {
+                if (m_cache[k].lastUse < m_cache[slot].lastUse) {
+                    slot = k;
+                }
+            }
+            m_slots.erase(m_cache[slot].tile);
+            m_cache[slot].tile = tile;
+            m_statistics.evictions++;
+        }
+        m_slots[tile] = slot;
+        std::vector<std::uint64_t> &words = m_cache[slot].words;
+        if (!m_file.readTile(tileRow, tileColumn, words.data())) {
+            std::fill(words.begin(), words.end(), ~static_cast<std::uint64_t>(0));
+            m_statistics.corruptTiles++;
+        }
+        m_statistics.bytesRead += m_file.tileBytes(tileRow, tileColumn);
+        m_statistics.bytesDecoded += m_file.tileWords(tileRow) << 3;
+        // Prefetch the next tile in the direction from the previous tile to this one.
+        if (m_tile != nullptr) {
+            std::int64_t nextRow = 2 * static_cast<std::int64_t>(tileRow) -
+                m_tileTop / m_file.getTileHeight();
+            std::int64_t nextColumn = 2 * static_cast<std::int64_t>(tileColumn) -
+                m_tileLeft / m_file.getTileWidth();
+            if (nextRow >= 0 && nextRow < m_file.tileRows() &&
+                nextColumn >= 0 && nextColumn < m_file.tileColumns() &&
+                std::abs(nextRow - tileRow) <= 1 && std::abs(nextColumn - tileColumn) <= 1)
+            {
+                std::uint32_t prefetchRow = static_cast<std::uint32_t>(nextRow);
+                std::uint32_t prefetchColumn = static_cast<std::uint32_t>(nextColumn);
+                std::uint64_t nextTile = static_cast<std::uint64_t>(prefetchRow) *
+                    m_file.tileColumns() + prefetchColumn;
+                if (nextTile != m_prefetchedTile && m_slots.count(nextTile) == 0) {
+                    m_file.prefetchTile(prefetchRow, prefetchColumn);
+                    m_prefetchedTile = nextTile;
+                    m_statistics.prefetches++;
+                    m_statistics.bytesPrefetched += m_file.tileBytes(prefetchRow, prefetchColumn);
+                }
+            }
+        }
+    }
+    m_cache[slot].lastUse = ++m_clock;
+    m_tile = m_cache[slot].words.data();
+    m_tileTop = tileRow * m_file.getTileHeight();
+    m_tileLeft = tileColumn * m_file.getTileWidth();
+    m_tileHeight = m_file.tileRowHeight(tileRow);
+    m_tileWidth = m_file.getTileWidth();
+}
+
+Path TiledMaze::solve(std::uint32_t i1, std::uint32_t j1,
+    std::uint32_t i2, std::uint32_t j2, MazeSolver::Statistics *statistics) const
+{
+    return MazeSolver::wallFollower(*this, i1, j1, i2, j2, statistics);
+}
+
+Path TiledMaze::solveAStar(std::uint32_t i1, std::uint32_t j1,
+    std::uint32_t i2, std::uint32_t j2, MazeSolver::Statistics *statistics) const
+{
+    return MazeSolver::pagedBidirectionalAStar(*this, i1, j1, i2, j2, statistics);
+}
\ No newline at end of file
@@ -0,0 +1,163 @@
+#ifndef TILEDMAZE_H
+#define TILEDMAZE_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <LMZFile.h>
+#include <Path.h>
+#include <MazeSolver.h>
+
+// Maze stored in a tiled maze file (see LMZFile), of which only a bounded number of
+// decoded tiles is kept in memory, so that mazes larger than the memory can be solved.
+// Tiles are decoded into a cache when walls in them are first queried, evicting the least
+// recently used tile when the cache is full. When a query moves into a tile which is not
+// cached, the coded bytes of the next tile in the same direction are prefetched from the file.
+// Queries modify the cache, so a TiledMaze must not be queried by several threads at once.
+class TiledMaze {
+
+public:
+
+    // Cache activity since construction or the last resetStatistics.
+    // Only queries in another tile than the previous query are counted as tile lookups;
+    // each of them is either a hit in the cache or a miss which decodes the tile.
+    struct CacheStatistics {
+        std::uint64_t tileLookups = 0;
+        std::uint64_t hits = 0;
+        std::uint64_t misses = 0;
+        std::uint64_t evictions = 0;
+        // Coded bytes of the tiles decoded, and their decoded size.
+        std::uint64_t bytesRead = 0;
+        std::uint64_t bytesDecoded = 0;
+        // Tiles prefetched, and their coded bytes.
+        std::uint64_t prefetches = 0;
+        std::uint64_t bytesPrefetched = 0;
+        // Tiles which could not be decoded and are treated as all walls.
+        std::uint64_t corruptTiles = 0;
+
+        // Fraction of tile lookups which were hits, 1 if there were none.
+        double hitRate() const;
+    };
+
+private:
+
+    // Decoded tile in the cache.
+    struct CachedTile {
+        std::uint64_t tile;
+        std::uint64_t lastUse;
+        std::vector<std::uint64_t> words;
+    };
+
+    LMZFile m_file;
+
+    // Maximum number of cached tiles.
+    std::uint32_t m_capacity;
+
+    mutable std::vector<CachedTile> m_cache;
+
+    // Cache slot of each cached tile, by tile number (tile row * tile columns + tile column).
+    mutable std::unordered_map<std::uint64_t, std::uint32_t> m_slots;
+
+    // Counter of tile lookups, giving lastUse of cached tiles.
+    mutable std::uint64_t m_clock;
+
+    // Words of the current tile (of the last query), its upper left cell and size.
+    mutable std::uint64_t const *m_tile;
+    mutable std::uint32_t m_tileTop;
+    mutable std::uint32_t m_tileLeft;
+    mutable std::uint32_t m_tileHeight;
+    mutable std::uint32_t m_tileWidth;
+
+    // Last tile prefetched, prefetched again only after another one.
+    mutable std::uint64_t m_prefetchedTile;
+
+    mutable CacheStatistics m_statistics;
+
+    // Bit (i, j) of the vertical walls (plane 0) or horizontal walls (plane 1),
+    // see Maze::verticalWalls and Maze::horizontalWalls.
+    bool wallBit(std::uint32_t i, std::uint32_t j, std::uint32_t plane) const;
+
+    // Make the tile containing cell (i, j) the current tile.
+    void enterTile(std::uint32_t i, std::uint32_t j) const;
+
+public:
+
+    // Default memory for decoded tiles.
+    static constexpr std::uint64_t defaultCacheBytes = static_cast<std::uint64_t>(64) << 20;
+
+    // Open maze from a tiled maze file, with cache of decoded tiles of about cacheBytes
+    // (at least 4 tiles). Return 1 x 1 maze if could not read file.
+    TiledMaze(std::string const &fileName, std::uint64_t cacheBytes = defaultCacheBytes);
+
+    // Return true if the file has been read successfully.
+    bool isOpen() const;
+
+    std::uint32_t getHeight() const;
+
+    std::uint32_t getWidth() const;
+
+    // Maximum number of cached tiles.
+    std::uint32_t getCacheCapacity() const;
+
+    CacheStatistics const &getStatistics() const;
+
+    void resetStatistics();
+
+    // Return true if the (i, j)-th cell cannot be left toward given direction,
+    // either because of a wall or because of the maze border.
+    bool hasWall(std::uint32_t i, std::uint32_t j, Path::Direction direction) const;
+
+    // Find path between given cells using "always turn left" algoritm (see Maze::solve).
+    Path solve(std::uint32_t i1, std::uint32_t j1, std::uint32_t i2, std::uint32_t j2,
+        MazeSolver::Statistics *statistics = nullptr) const;
+
+    // Find a shortest path between given cells using bidirectional A* search
+    // (see Maze::solveAStar), decoding only tiles with expanded cells. The search state
+    // is kept only for pages of cells it reaches (see MazeSolver::pagedBidirectionalAStar),
+    // so memory follows the number of expanded cells, not the maze size.
+    Path solveAStar(std::uint32_t i1, std::uint32_t j1, std::uint32_t i2, std::uint32_t j2,
+        MazeSolver::Statistics *statistics = nullptr) const;
+
+};
+
+inline std::uint32_t TiledMaze::getHeight() const
+{
+    return m_file.getHeight();
+}
+
+inline std::uint32_t TiledMaze::getWidth() const
+{
+    return m_file.getWidth();
+}
+
+inline bool TiledMaze::wallBit(std::uint32_t i, std::uint32_t j, std::uint32_t plane) const
+{
+    std::uint32_t row = i - m_tileTop;
+    std::uint32_t column = j - m_tileLeft;
+    if (row >= m_tileHeight || column >= m_tileWidth) {
+        enterTile(i, j);
+        row = i - m_tileTop;
+        column = j - m_tileLeft;
+    }
+    std::uint32_t rowWords = m_tileWidth >> 6;
+    std::uint64_t word = m_tile[(static_cast<std::uint64_t>(row) * rowWords << 1) +
+        plane * rowWords + (column >> 6)];
+    return (word >> (column & 63)) & 1;
+}
+
+inline bool TiledMaze::hasWall(std::uint32_t i, std::uint32_t j, Path::Direction direction) const
+{
+    switch (direction) {
+        case Path::Up:
+            return i == 0 || wallBit(i, j, 1);
+        case Path::Down:
+            return i == getHeight() - 1 || wallBit(i + 1, j, 1);
+        case Path::Left:
+            return j == 0 || wallBit(i, j, 0);
+        default:
+            return j == getWidth() - 1 || wallBit(i, j + 1, 0);
+    }
+}
+
+#endif
\ No newline at end of file
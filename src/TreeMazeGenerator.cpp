@@ -0,0 +1,566 @@
+#include <cstdint>
+#include <vector>
+#include <utility>
+#include <algorithm>
+#include <Utilities.h>
+#include <Path.h>
+#include <BitPlanes.h>
+#include <Metrics.h>
+#include <TreeMazeGenerator.h>
+
+namespace {
+
+// Connected components of a horizontal strip of a maze, as seen from its first and last row.
+struct StripComponents {
+
+    // Component of each cell in the first and in the last row of the strip,
+    // numbered from 0 to the number of components - 1.
+    std::vector<std::uint32_t> firstRow;
+    std::vector<std::uint32_t> lastRow;
+
+    // Nonzero for each component containing a solution path cell.
+    std::vector<std::uint8_t> solution;
+
+};
+
+// Find components of rows [begin, end) of a maze, ignoring walls above the first row.
+// Rows are scanned from top to bottom, and only O(width) set elements are kept: cells
+// of the first row and components started in later rows, which are renumbered when
+// there is no room for another row.
+StripComponents stripComponents(BitPlanes const &walls,
+    std::uint32_t verticalPlane, std::uint32_t horizontalPlane,
+    PathCells const &solutionCells, std::uint32_t begin, std::uint32_t end)
+{
+    std::uint32_t width = walls.getWidth();
+    // Elements [0, width) are cells of the first row, and components started
+    // in later rows are elements [width, next).
+    std::vector<std::uint32_t> parents(5 * static_cast<std::uint64_t>(width));
+    std::vector<std::uint8_t> solution(parents.size());
+    std::vector<std::uint32_t> labels(width);
+    std::vector<std::uint32_t> numbers(parents.size(), UINT32_MAX);
+    std::uint32_t next = width;
+    std::vector<std::uint32_t> roots(width);
+    std::vector<std::uint8_t> rootSolution(width);
+    for (std::uint32_t i = begin; i < end; i++) {
+        std::uint64_t const *verticalWalls = walls.row(i, verticalPlane);
+        std::uint64_t const *horizontalWalls = walls.row(i, horizontalPlane);
+        PathCellRow cells = solutionCells[i];
+        std::uint64_t cellIndex = 0;
+        std::uint32_t root = 0;
+        for (std::uint32_t j = 0; j < width; j++) {
+            bool left = j != 0 && !((verticalWalls[j >> 6] >> (j & 63)) & 1);
+            bool above = i != begin && !((horizontalWalls[j >> 6] >> (j & 63)) & 1);
+            if (above) {
+                std::uint32_t aboveRoot = DisjointSetForest::find(parents, labels[j]);
+                if (!left) {
+                    root = aboveRoot;
+                }
+                else if (aboveRoot != root) {
+                    std::uint8_t rootsSolution = solution[root] | solution[aboveRoot];
+                    root = DisjointSetForest::join(parents, root, aboveRoot);
+                    solution[root] = rootsSolution;
+                }
+            }
+            else if (!left) {
+                root = i == begin ? j : next++;
+                parents[root] = root;
+                solution[root] = 0;
+            }
+            else if (i == begin) {
+                parents[j] = root;
+            }
+            if (cellIndex < cells.size() && cells[cellIndex].column == j) {
+                solution[root] = 1;
+                cellIndex++;
+            }
+            labels[j] = root;
+        }
+        // Renumber components of the row which do not contain a first row cell
+        // as elements [width, width + count).
+        if (next - width <= parents.size() - 2 * width) {
+            continue;
+        }
+        std::uint32_t count = 0;
+        for (std::uint32_t j = 0; j < width; j++) {
+            std::uint32_t root = DisjointSetForest::find(parents, labels[j]);
+            if (root >= width) {
+                if (numbers[root - width] == UINT32_MAX) {
+                    numbers[root - width] = count;
+                    roots[count] = root;
+                    rootSolution[count] = solution[root];
+                    count++;
+                }
+                root = width + numbers[root - width];
+            }
+            labels[j] = root;
+        }
+        for (std::uint32_t k = 0; k < count; k++) {
+            numbers[roots[k] - width] = UINT32_MAX;
+            parents[width + k] = width + k;
+            solution[width + k] = rootSolution[k];
+        }
+        next = width + count;
+    }
+    StripComponents components;
+    components.firstRow.resize(width);
+    components.lastRow.resize(width);
+    for (std::uint32_t j = 0; j < 2 * width; j++) {
+        std::uint32_t &row = j < width ? components.firstRow[j] : components.lastRow[j - width];
+        std::uint32_t root = DisjointSetForest::find(parents, j < width ? j : labels[j - width]);
+        if (numbers[root] == UINT32_MAX) {
+            numbers[root] = components.solution.size();
+            components.solution.push_back(solution[root]);
+        }
+        row = numbers[root];
+    }
+    return components;
+}
+
+}
+
+TreeMazeGenerator::TreeMazeGenerator(std::uint32_t width, std::int32_t seed,
+    std::vector<std::uint8_t> const &probabilitySet) :
+    m_width{width},
+    m_seed{seed},
+    m_pool{width + 2}
+{
+    std::uint8_t probability2 = probabilitySet[1];
+    std::uint8_t probability4 = probabilitySet[3];
+    std::uint8_t probability5 = probabilitySet[4];
+    m_probability1 = probabilitySet[0];
+    m_probability3 = probabilitySet[2];
+    m_probability6 = probabilitySet[5];
+    m_probability12 =
+        static_cast<std::uint16_t>(m_probability1) * static_cast<std::uint16_t>(probability2) / 256;
+    m_probability34 = m_probability3 -
+        static_cast<std::uint16_t>(m_probability3) * static_cast<std::uint16_t>(probability4) / 256 +
+        probability4;
+    m_probability35 =
+        static_cast<std::uint16_t>(m_probability3) * static_cast<std::uint16_t>(probability5) / 256;
+
+    m_solutionIndex = m_pool.pop(0);
+    m_borderIndex = m_pool.pop(0);
+    m_cellIndices.resize(m_width);
+    for (std::uint32_t j = 0; j < m_width; j++) {
+        m_cellIndices[j] = m_pool.pop(1);
+    }
+}
+
+void TreeMazeGenerator::generateRow(PathCell const *solutionCells, std::uint64_t solutionCellCount,
+    std::uint64_t *verticalWalls, std::uint64_t *horizontalWalls)
+{
+    std::fill_n(verticalWalls, (m_width + 63) >> 6, 0);
+    std::fill_n(horizontalWalls, (m_width + 63) >> 6, 0);
+    std::uint32_t nextSolutionCellIndex = 0;
+    std::uint32_t nextSolutionCellColumn = solutionCellCount == 0 ?
+        m_width : solutionCells[0].column;
+    m_borderIndex = m_pool.get(m_borderIndex);
+    if (m_pool.degree(m_borderIndex) != 0) {
+        m_borderIndex = m_pool.pop(0);
+    }
+    std::uint32_t index = m_borderIndex;
+    for (std::uint32_t j = 0; j < m_width; j++) {
+        std::uint64_t cellBit = static_cast<std::uint64_t>(1) << (j & 63);
+        std::uint32_t aboveIndex = m_pool.get(m_cellIndices[j]);
+        std::uint8_t randValue = Utilities::randUint8(m_seed);
+        if (j == nextSolutionCellColumn) {
+            m_solutionIndex = m_pool.get(m_solutionIndex);
+            if (index == m_solutionIndex) {
+                if (!solutionCells[nextSolutionCellIndex].left) {
+                    verticalWalls[j >> 6] |= cellBit;
+                }
+                if (aboveIndex == m_solutionIndex) {
+                    if (!solutionCells[nextSolutionCellIndex].above) {
+                        horizontalWalls[j >> 6] |= cellBit;
+                    }
+                }
+                else if (m_pool.degree(aboveIndex) == 1 ||
+                    randValue < m_probability35 || randValue >= m_probability34)
+                {
+                    m_pool.join(index, aboveIndex);
+                }
+                else {
+                    horizontalWalls[j >> 6] |= cellBit;
+                    m_pool.degree(aboveIndex)--;
+                    m_pool.degree(index)++;
+                }
+            }
+            else if (aboveIndex == m_solutionIndex) {
+                if (!solutionCells[nextSolutionCellIndex].above) {
+                    horizontalWalls[j >> 6] |= cellBit;
+                }
+                if ((randValue >= m_probability35 && randValue < m_probability3) ||
+                    randValue >= m_probability34)
+                {
+                    m_pool.join(index, m_solutionIndex);
+                }
+                else {
+                    verticalWalls[j >> 6] |= cellBit;
+                    index = m_solutionIndex;
+                }
+            }
+            else if (aboveIndex == index) {
+                if (randValue < m_probability12) {
+                    horizontalWalls[j >> 6] |= cellBit;
+                    verticalWalls[j >> 6] |= cellBit;
+                    m_pool.degree(index)--;
+                    m_pool.degree(m_solutionIndex)++;
+                    index = m_solutionIndex;
+                }
+                else {
+                    if (randValue < m_probability1) {
+                        horizontalWalls[j >> 6] |= cellBit;
+                    }
+                    else {
+                        verticalWalls[j >> 6] |= cellBit;
+                    }
+                    m_pool.join(index,m_solutionIndex);
+                }
+            }
+            else if (m_pool.degree(aboveIndex) == 1) {
+                m_pool.join(m_solutionIndex,aboveIndex);
+                if (randValue < m_probability6) {
+                    verticalWalls[j >> 6] |= cellBit;
+                    index = m_solutionIndex;
+                }
+                else {
+                    m_pool.join(index, m_solutionIndex);
+                }
+            }
+            else if (randValue < m_probability35) {
+                verticalWalls[j >> 6] |= cellBit;
+                m_pool.join(m_solutionIndex, aboveIndex);
+                index = m_solutionIndex;
+            }
+            else if (randValue < m_probability3) {
+                horizontalWalls[j >> 6] |= cellBit;
+                m_pool.degree(aboveIndex)--;
+                m_pool.degree(index)++;
+                m_pool.join(index, m_solutionIndex);
+            }
+            else if (randValue < m_probability34) {
+                verticalWalls[j >> 6] |= cellBit;
+                horizontalWalls[j >> 6] |= cellBit;
+                m_pool.degree(aboveIndex)--;
+                m_pool.degree(m_solutionIndex)++;
+                index = m_solutionIndex;
+            }
+            else {
+                m_pool.join(index, m_solutionIndex);
+                m_pool.join(index, aboveIndex);
+            }
+            nextSolutionCellIndex++;
+            nextSolutionCellColumn =
+                nextSolutionCellIndex == solutionCellCount ?
+                m_width : solutionCells[nextSolutionCellIndex].column;
+        }
+        else if (index == aboveIndex) {
+            if (randValue < m_probability12) {
+                horizontalWalls[j >> 6] |= cellBit;
+                verticalWalls[j >> 6] |= cellBit;
+                m_pool.degree(aboveIndex)--;
+                index = m_pool.pop(1);
+            }
+            else if (randValue < m_probability1) {
+                horizontalWalls[j >> 6] |= cellBit;
+            }
+            else {
+                verticalWalls[j >> 6] |= cellBit;
+            }
+        }
+        else if (m_pool.degree(aboveIndex) == 1) {
+            if (randValue < m_probability6) {
+                verticalWalls[j >> 6] |= cellBit;
+                index = aboveIndex;
+            }
+            else {
+                m_pool.join(index, aboveIndex);
+            }
+        }
+        else if (randValue < m_probability35) {
+            verticalWalls[j >> 6] |= cellBit;
+            index = aboveIndex;
+        }
+        else if (randValue < m_probability3) {
+            horizontalWalls[j >> 6] |= cellBit;
+            m_pool.degree(aboveIndex)--;
+            m_pool.degree(index)++;
+        }
+        else if (randValue < m_probability34) {
+            verticalWalls[j >> 6] |= cellBit;
+            horizontalWalls[j >> 6] |= cellBit;
+            m_pool.degree(aboveIndex)--;
+            index = m_pool.pop(1);
+        }
+        else {
+            m_pool.join(index, aboveIndex);
+        }
+        m_cellIndices[j] = index;
+    }
+    if (m_width != 0) {
+        verticalWalls[0] &= ~static_cast<std::uint64_t>(1);
+    }
+}
+
+void TreeMazeGenerator::finish(std::uint64_t *verticalWalls)
+{
+    std::uint32_t index = m_pool.get(m_borderIndex);
+    for (std::uint32_t j = 0; j < m_width; j++) {
+        std::uint32_t aboveIndex = m_pool.get(m_cellIndices[j]);
+        if (index != aboveIndex) {
+            std::uint8_t randValue = Utilities::randUint8(m_seed);
+            if ((m_pool.degree(index) + 1) * randValue < 256) {
+                verticalWalls[j >> 6] &= ~(static_cast<std::uint64_t>(1) << (j & 63));
+                m_pool.join(index, aboveIndex);
+            }
+            else {
+                index = aboveIndex;
+            }
+        }
+        m_pool.degree(index)--;
+    }
+}
+
+bool TreeMazeGenerator::save(std::ostream &stream) const
+{
+    std::uint32_t header[4] = {m_width, static_cast<std::uint32_t>(m_seed),
+        m_solutionIndex, m_borderIndex};
+    return Utilities::writeUint32s(stream, header, 4) &&
+        Utilities::writeUint32s(stream, m_cellIndices.data(), m_width) &&
+        m_pool.save(stream);
+}
+
+bool TreeMazeGenerator::load(std::istream &stream)
+{
+    std::uint32_t header[4];
+    if (!Utilities::readUint32s(stream, header, 4) || header[0] != m_width) {
+        return false;
+    }
+    std::vector<std::uint32_t> cellIndices(m_width);
+    Pool pool(0);
+    if (!Utilities::readUint32s(stream, cellIndices.data(), m_width) || !pool.load(stream) ||
+        pool.size() != m_width + 2 || header[2] >= pool.size() || header[3] >= pool.size() ||
+        std::any_of(cellIndices.begin(), cellIndices.end(),
+            [&](std::uint32_t index) { return index >= pool.size(); }))
+    {
+        return false;
+    }
+    m_seed = static_cast<std::int32_t>(header[1]);
+    m_solutionIndex = header[2];
+    m_borderIndex = header[3];
+    m_cellIndices = std::move(cellIndices);
+    m_pool = std::move(pool);
+    return true;
+}
+
+bool TreeMazeGenerator::generate(Path const &path, std::int32_t seed,
+    std::vector<std::uint8_t> const &probabilitySet, MazeRowSink &sink)
+{
+    std::uint32_t height = path.getHeight();
+    std::uint32_t width = path.getWidth();
+    if (!sink.begin(height, width)) {
+        return false;
+    }
+    PathRowCursor solutionCells(path);
+    TreeMazeGenerator generator(width, seed, probabilitySet);
+    std::vector<std::uint64_t> verticalWalls((width + 63) >> 6);
+    std::vector<std::uint64_t> horizontalWalls((width + 63) >> 6);
+    for (std::uint32_t i = 0; i < height; i++) {
+        {
+            Metrics::PhaseTimer timer(Metrics::Generate);
+            PathCellRow rowCells = solutionCells.next();
+            generator.generateRow(rowCells.data(), rowCells.size(),
+                verticalWalls.data(), horizontalWalls.data());
+            if (i == height - 1) {
+                generator.finish(verticalWalls.data());
+            }
+        }
+        if (!sink.writeRow(verticalWalls.data(), horizontalWalls.data())) {
+            return false;
+        }
+    }
+    return sink.end();
+}
+
+void TreeMazeGenerator::generateStrips(Path const &path, std::int32_t seed,
+    std::vector<std::uint8_t> const &probabilitySet, std::uint32_t stripCount,
+    std::uint32_t threadCount, BitPlanes &walls,
+    std::uint32_t verticalPlane, std::uint32_t horizontalPlane)
+{
+    std::uint32_t height = path.getHeight();
+    std::uint32_t width = path.getWidth();
+    if (height == 0 || width == 0) {
+        return;
+    }
+    PathCells solutionCells = path.cells();
+    stripCount = std::min(Utilities::threadCount(stripCount), height);
+    if (stripCount == 1) {
+        TreeMazeGenerator generator(width, seed, probabilitySet);
+        for (std::uint32_t i = 0; i < height; i++) {
+            generator.generateRow(solutionCells[i].data(), solutionCells[i].size(),
+                walls.row(i, verticalPlane), walls.row(i, horizontalPlane));
+        }
+        generator.finish(walls.row(height - 1, verticalPlane));
+        std::fill_n(walls.row(0, horizontalPlane), walls.getRowWords(), 0);
+        return;
+    }
+
+    // Generate strips. The first strip continues the sequence of the serial generator.
+    std::vector<std::uint32_t> stripBegins(stripCount + 1);
+    std::vector<std::int32_t> stripSeeds(stripCount);
+    std::int32_t nextSeed = seed;
+    for (std::uint32_t s = 0; s <= stripCount; s++) {
+        stripBegins[s] = static_cast<std::uint64_t>(height) * s / stripCount;
+        if (s < stripCount) {
+            stripSeeds[s] = s == 0 ? seed : static_cast<std::int32_t>(Utilities::randUint32(nextSeed));
+        }
+    }
+    std::vector<StripComponents> components(stripCount);
+    Utilities::parallelFor(stripCount, 1, threadCount,
+        [&](std::uint64_t begin, std::uint64_t end) {
+            for (std::uint64_t s = begin; s < end; s++) {
+                TreeMazeGenerator generator(width, stripSeeds[s], probabilitySet);
+                for (std::uint32_t i = stripBegins[s]; i < stripBegins[s + 1]; i++) {
+                    generator.generateRow(solutionCells[i].data(), solutionCells[i].size(),
+                        walls.row(i, verticalPlane), walls.row(i, horizontalPlane));
+                }
+                components[s] = stripComponents(walls, verticalPlane, horizontalPlane,
+                    solutionCells, stripBegins[s], stripBegins[s + 1]);
+            }
+        });
+
+    // Disjoint sets of components of all strips. Components containing solution path
+    // cells are joined beforehand, since the path connecting them is never broken.
+    std::vector<std::uint32_t> offsets(stripCount + 1);
+    for (std::uint32_t s = 0; s < stripCount; s++) {
+        offsets[s + 1] = offsets[s] + components[s].solution.size();
+    }
+    std::vector<std::uint32_t> sets(offsets[stripCount] + 1);
+    for (std::uint32_t k = 0; k < sets.size(); k++) {
+        sets[k] = k;
+    }
+    std::uint32_t solutionSet = offsets[stripCount];
+    for (std::uint32_t s = 0; s < stripCount; s++) {
+        for (std::uint32_t k = 0; k < components[s].solution.size(); k++) {
+            if (components[s].solution[k]) {
+                std::uint32_t root1 = DisjointSetForest::find(sets, offsets[s] + k);
+                std::uint32_t root2 = DisjointSetForest::find(sets, solutionSet);
+                if (root1 != root2) {
+                    DisjointSetForest::join(sets, root1, root2);
+                }
+            }
+        }
+    }
+
+    // Stitch strips from top to bottom. The first row of a strip is generated with
+    // walls above it open. Keep walls open only between distinct sets, so that no loop
+    // is made, then make sure each set in the last row of the upper strip has a way
+    // down, as TreeMazeGenerator::generateRow does for each row.
+    std::vector<std::uint8_t> opened(sets.size());
+    std::vector<std::uint32_t> degrees(sets.size());
+    std::vector<std::uint8_t> pathAbove(width);
+    std::int32_t stitchSeed = static_cast<std::int32_t>(Utilities::randUint32(nextSeed));
+    for (std::uint32_t s = 1; s < stripCount; s++) {
+        std::uint32_t i = stripBegins[s];
+        std::uint64_t *horizontalWalls = walls.row(i, horizontalPlane);
+        std::uint32_t const *upperRow = components[s - 1].lastRow.data();
+        std::uint32_t const *lowerRow = components[s].firstRow.data();
+        std::uint32_t upperOffset = offsets[s - 1];
+        std::uint32_t lowerOffset = offsets[s];
+        PathCellRow cells = solutionCells[i];
+        for (PathCell const &cell : solutionCells[i - 1]) {
+            pathAbove[cell.column] = 1;
+        }
+        std::uint64_t cellIndex = 0;
+        for (std::uint32_t j = 0; j < width; j++) {
+            std::uint64_t cellBit = static_cast<std::uint64_t>(1) << (j & 63);
+            bool solutionCell = cellIndex < cells.size() && cells[cellIndex].column == j;
+            if (solutionCell && pathAbove[j]) {
+                if (cells[cellIndex].above) {
+                    horizontalWalls[j >> 6] &= ~cellBit;
+                }
+                else {
+                    horizontalWalls[j >> 6] |= cellBit;
+                }
+            }
+            else if (!(horizontalWalls[j >> 6] & cellBit)) {
+                std::uint32_t upper = DisjointSetForest::find(sets, upperOffset + upperRow[j]);
+                std::uint32_t lower = DisjointSetForest::find(sets, lowerOffset + lowerRow[j]);
+                if (upper != lower) {
+                    DisjointSetForest::join(sets, upper, lower);
+                }
+                else {
+                    horizontalWalls[j >> 6] |= cellBit;
+                }
+            }
+            if (solutionCell) {
+                cellIndex++;
+            }
+        }
+        for (std::uint32_t j = 0; j < width; j++) {
+            std::uint32_t upper = DisjointSetForest::find(sets, upperOffset + upperRow[j]);
+            degrees[upper]++;
+            if (!((horizontalWalls[j >> 6] >> (j & 63)) & 1)) {
+                opened[upper] = 1;
+            }
+        }
+        // Open a wall below a set with probability 1 / (number of its remaining cells),
+        // and below its first cell left if none was opened.
+        for (std::uint8_t pass = 0; pass < 2; pass++) {
+            for (std::uint32_t j = 0; j < width; j++) {
+                std::uint32_t upper = DisjointSetForest::find(sets, upperOffset + upperRow[j]);
+                if (!opened[upper]) {
+                    std::uint32_t lower = DisjointSetForest::find(sets, lowerOffset + lowerRow[j]);
+                    if (upper != lower && (pass == 1 ||
+                        degrees[upper] * Utilities::randUint8(stitchSeed) < 256))
+                    {
+                        horizontalWalls[j >> 6] &= ~(static_cast<std::uint64_t>(1) << (j & 63));
+                        std::uint32_t degree = degrees[upper] + degrees[lower];
+                        upper = DisjointSetForest::join(sets, upper, lower);
+                        degrees[upper] = degree;
+                        opened[upper] = 1;
+                    }
+                }
+                if (pass == 0) {
+                    degrees[upper]--;
+                }
+            }
+        }
+        for (std::uint32_t j = 0; j < width; j++) {
+            std::uint32_t upper = DisjointSetForest::find(sets, upperOffset + upperRow[j]);
+            std::uint32_t lower = DisjointSetForest::find(sets, lowerOffset + lowerRow[j]);
+            opened[upper] = opened[lower] = 0;
+            degrees[upper] = degrees[lower] = 0;
+        }
+        for (PathCell const &cell : solutionCells[i - 1]) {
+            pathAbove[cell.column] = 0;
+        }
+    }
+
+    // Join the remaining sets in the last row as TreeMazeGenerator::finish does.
+    std::uint64_t *verticalWalls = walls.row(height - 1, verticalPlane);
+    std::uint32_t const *lastRow = components[stripCount - 1].lastRow.data();
+    std::uint32_t lastOffset = offsets[stripCount - 1];
+    for (std::uint32_t j = 0; j < width; j++) {
+        degrees[DisjointSetForest::find(sets, lastOffset + lastRow[j])]++;
+    }
+    std::uint32_t index = DisjointSetForest::find(sets, lastOffset + lastRow[0]);
+    degrees[index]--;
+    for (std::uint32_t j = 1; j < width; j++) {
+        std::uint32_t aboveIndex = DisjointSetForest::find(sets, lastOffset + lastRow[j]);
+        if (index != aboveIndex) {
+            std::uint8_t randValue = Utilities::randUint8(stitchSeed);
+            if ((degrees[index] + 1) * randValue < 256) {
+                verticalWalls[j >> 6] &= ~(static_cast<std::uint64_t>(1) << (j & 63));
+                std::uint32_t degree = degrees[index] + degrees[aboveIndex];
+                index = DisjointSetForest::join(sets, index, aboveIndex);
+                degrees[index] = degree;
+            }
+            else {
+                index = aboveIndex;
+            }
+        }
+        degrees[index]--;
+    }
+    std::fill_n(walls.row(0, horizontalPlane), walls.getRowWords(), 0);
+}
\ No newline at end of file
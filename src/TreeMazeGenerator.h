@@ -0,0 +1,130 @@
+#ifndef TREEMAZEGENERATOR_H
+#define TREEMAZEGENERATOR_H
+
+#include <cstdint>
+#include <vector>
+#include <istream>
+#include <ostream>
+#include <Path.h>
+#include <BitPlanes.h>
+#include <DisjointSets.h>
+#include <Metrics.h>
+
+// Counting policy of Pool (see DisjointSetPolicy), adding its operations to Metrics counters.
+struct PoolCounting {
+    static void get() { Metrics::add(Metrics::PoolGets); }
+    static void hop() { Metrics::add(Metrics::PoolGetHops); }
+    static void join() { Metrics::add(Metrics::PoolJoins); }
+    static void pop() { Metrics::add(Metrics::PoolPops); }
+};
+
+// Disjoint sets of cells with recycled set indices, used by the tree maze generator.
+// The degree of a set is the number of references to it (cells of the last row
+// and the left border), and a set index is recycled once it has been joined.
+using Pool = DisjointSets<DisjointSetPolicy::PathHalving, DisjointSetPolicy::UnionByDegree,
+    DisjointSetPolicy::SeparateArrays, PoolCounting>;
+
+// Receiver of maze rows, generated from top to bottom.
+class MazeRowSink {
+
+public:
+
+    virtual ~MazeRowSink() = default;
+
+    // Called once before the first row. Return false if failed.
+    virtual bool begin(std::uint32_t height, std::uint32_t width) = 0;
+
+    // Receive the next row, where bit (j & 63) of the (j >> 6)-th word of verticalWalls
+    // (horizontalWalls) is set if the j-th cell of the row has wall left to it (above it).
+    // Return false if failed.
+    virtual bool writeRow(std::uint64_t const *verticalWalls,
+        std::uint64_t const *horizontalWalls) = 0;
+
+    // Called once after the last row. Return false if failed.
+    virtual bool end() = 0;
+
+};
+
+// Generator of tree mazes (see Maze), producing one row at a time.
+// Apart from the solution path, the generator keeps only O(width) state
+// between rows: the pool of cell sets and set indices of cells in the last row.
+class TreeMazeGenerator {
+
+    // Width.
+    std::uint32_t m_width;
+
+    // Random seed.
+    std::int32_t m_seed;
+
+    // Probability set and derived probabilities.
+    std::uint8_t m_probability1;
+    std::uint8_t m_probability3;
+    std::uint8_t m_probability6;
+    std::uint8_t m_probability12;
+    std::uint8_t m_probability34;
+    std::uint8_t m_probability35;
+
+    // Cell sets.
+    Pool m_pool;
+
+    // Set indices of cells in the last generated row.
+    std::vector<std::uint32_t> m_cellIndices;
+
+    // Set index of the solution path cells.
+    std::uint32_t m_solutionIndex;
+
+    // Set index of the left border.
+    std::uint32_t m_borderIndex;
+
+public:
+
+    // Generator of a maze with given width, random seed and probability set (6 values).
+    // Maximum width is UINT32_MAX - 2.
+    TreeMazeGenerator(std::uint32_t width, std::int32_t seed,
+        std::vector<std::uint8_t> const &probabilitySet);
+
+    // Generate the next row, given solution path cells in the row sorted from left to right.
+    // Overwrite the first (width + 63) / 64 words of verticalWalls and horizontalWalls
+    // with walls of the row (see MazeRowSink::writeRow). Horizontal walls of the first
+    // row are meaningless.
+    void generateRow(PathCell const *solutionCells, std::uint64_t solutionCellCount,
+        std::uint64_t *verticalWalls, std::uint64_t *horizontalWalls);
+
+    // Remove vertical walls in the last generated row so that each two cells
+    // of the maze are connected by exactly one path.
+    void finish(std::uint64_t *verticalWalls);
+
+    // Write the state carried between rows (random seed, cell sets and set indices)
+    // to a binary stream, so that a generator of the same width and probability set
+    // can continue from it. Return false if failed.
+    bool save(std::ostream &stream) const;
+
+    // Read a state written by save, replacing the state of this generator.
+    // Return false if failed or if the state is not of a generator of the same width.
+    bool load(std::istream &stream);
+
+    // Generate a tree maze as in Maze(path, seed, probabilitySet), sending rows to sink
+    // as they are finished. Apart from the path and the points where it enters bands
+    // of rows (see PathRowCursor), memory usage is O(width).
+    // Return false if failed.
+    static bool generate(Path const &path, std::int32_t seed,
+        std::vector<std::uint8_t> const &probabilitySet, MazeRowSink &sink);
+
+    // Generate a tree maze into planes verticalPlane and horizontalPlane of walls
+    // (of size path.getHeight() x path.getWidth(), see MazeRowSink::writeRow), splitting
+    // the rows into stripCount horizontal strips generated independently by up to
+    // threadCount threads (all hardware threads if threadCount = 0). Strips are then
+    // stitched together: walls between strips and in the last row are opened or closed
+    // using disjoint sets of boundary components, so that each two cells are connected
+    // by exactly one path, and the solution path is kept open. The result depends on
+    // stripCount; stripCount = 1 gives the same maze as Maze(path, seed, probabilitySet),
+    // and stripCount = 0 stands for one strip per hardware thread.
+    // Maximum maze width is UINT32_MAX / 5.
+    static void generateStrips(Path const &path, std::int32_t seed,
+        std::vector<std::uint8_t> const &probabilitySet, std::uint32_t stripCount,
+        std::uint32_t threadCount, BitPlanes &walls,
+        std::uint32_t verticalPlane, std::uint32_t horizontalPlane);
+
+};
+
+#endif
\ No newline at end of file
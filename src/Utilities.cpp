@@ -1,6 +1,8 @@
 #include <cstdint>
 #include <string>
 #include <fstream>
+#include <thread>
+#include <algorithm>
 #include <Utilities.h>
 
 std::uint8_t Utilities::randUint8(std::int32_t &seed)
@@ -14,6 +16,24 @@ std::uint32_t Utilities::randUint32(std::int32_t &seed)
         (randUint8(seed) << 8) + randUint8(seed);
 }
 
+void Utilities::skipRand(std::int32_t &seed, std::uint64_t count)
+{
+    // Compose x -> multiplier * x + increment with itself modulo 2^32
+    // for each bit of count.
+    std::uint32_t multiplier = 214013;
+    std::uint32_t increment = 2531011;
+    std::uint32_t value = static_cast<std::uint32_t>(seed);
+    while (count != 0) {
+        if (count & 1) {
+            value = value * multiplier + increment;
+        }
+        increment = increment * multiplier + increment;
+        multiplier *= multiplier;
+        count >>= 1;
+    }
+    seed = static_cast<std::int32_t>(value);
+}
+
 bool Utilities::writeBMP(std::string const &fileName,
     std::int32_t width, std::int32_t height, std::ofstream &file)
 {
@@ -22,7 +42,7 @@ bool Utilities::writeBMP(std::string const &fileName,
         return false;
     }
     std::uint32_t widthBytes = (((width - 1) >> 5) + 1) << 2;
-    std::uint32_t imageSize = static_cast<std::uint32_t>(height) * widthBytes;
+    std::uint32_t imageSize = static_cast<std::uint32_t>(height < 0 ? -height : height) * widthBytes;
     std::uint32_t fileSize = imageSize + 14 + 40 + 8;
     char const fileHeader[14] = {
         'B', 'M',
@@ -70,11 +90,11 @@ bool Utilities::readBMP(std::string const &fileName,
         height <<= 8;
         height |= static_cast<std::uint8_t>(infoHeader[11 - i]);
     }
-    if (width < 0 || height < 0) {
+    if (width < 0 || height == INT32_MIN) {
         return false;
     }
     std::uint32_t widthBytes = (((width - 1) >> 5) + 1) << 2;
-    std::uint32_t imageSize = static_cast<std::uint32_t>(height) * widthBytes;
+    std::uint32_t imageSize = static_cast<std::uint32_t>(height < 0 ? -height : height) * widthBytes;
     std::uint32_t fileSize = imageSize + 14 + 40 + 8;
     return fileHeader[0] == 'B' && fileHeader[1] == 'M' &&
         fileHeader[2] == char(fileSize) &&
@@ -117,4 +137,53 @@ bool Utilities::readBMP(std::string const &fileName,
         palette[5] == char(0xff) &&
         palette[6] == char(0xff) &&
         palette[7] == 0;
+}
+
+bool Utilities::writeUint32s(std::ostream &stream, std::uint32_t const *values, std::uint64_t count)
+{
+    char buffer[4096];
+    while (count != 0) {
+        std::uint64_t chunk = std::min<std::uint64_t>(count, sizeof(buffer) >> 2);
+        for (std::uint64_t k = 0; k < chunk; k++) {
+            buffer[k << 2] = char(values[k]);
+            buffer[(k << 2) + 1] = char(values[k] >> 8);
+            buffer[(k << 2) + 2] = char(values[k] >> 16);
+            buffer[(k << 2) + 3] = char(values[k] >> 24);
+        }
+        if (!stream.write(buffer, chunk << 2)) {
+            return false;
+        }
+        values += chunk;
+        count -= chunk;
+    }
+    return true;
+}
+
+bool Utilities::readUint32s(std::istream &stream, std::uint32_t *values, std::uint64_t count)
+{
+    char buffer[4096];
+    while (count != 0) {
+        std::uint64_t chunk = std::min<std::uint64_t>(count, sizeof(buffer) >> 2);
+        if (!stream.read(buffer, chunk << 2)) {
+            return false;
+        }
+        for (std::uint64_t k = 0; k < chunk; k++) {
+            values[k] = static_cast<std::uint8_t>(buffer[k << 2]) |
+                static_cast<std::uint32_t>(static_cast<std::uint8_t>(buffer[(k << 2) + 1])) << 8 |
+                static_cast<std::uint32_t>(static_cast<std::uint8_t>(buffer[(k << 2) + 2])) << 16 |
+                static_cast<std::uint32_t>(static_cast<std::uint8_t>(buffer[(k << 2) + 3])) << 24;
+        }
+        values += chunk;
+        count -= chunk;
+    }
+    return true;
+}
+
+std::uint32_t Utilities::threadCount(std::uint32_t threadCount)
+{
+    if (threadCount != 0) {
+        return threadCount;
+    }
+    std::uint32_t hardwareThreads = std::thread::hardware_concurrency();
+    return hardwareThreads == 0 ? 1 : hardwareThreads;
 }
\ No newline at end of file
@@ -4,6 +4,12 @@
 #include <cstdint>
 #include <string>
 #include <fstream>
+#include <istream>
+#include <ostream>
+#include <vector>
+#include <thread>
+#include <atomic>
+#include <algorithm>
 
 namespace Utilities {
 
@@ -13,17 +19,88 @@ namespace Utilities {
     // Update seed and return a random 32-bit unsigned integer.
     std::uint32_t randUint32(std::int32_t &seed);
 
+    // Update seed as if randUint8 were called count times, in O(log count) steps.
+    void skipRand(std::int32_t &seed, std::uint64_t count);
+
     // Create (or overwrite) a binary file and write BMP file header,
     // Windows NT bitmap info header and color palette for a monochrome BMP file.
+    // Negative height stands for a top-down image.
     // Return file stream class of an open file. Return false if failed.
     bool writeBMP(std::string const &fileName,
         std::int32_t width, std::int32_t height, std::ofstream &file);
 
     // Open and read a monochrome Windows BMP file's file header, info header and palette.
-    // Return image data. Return false if illegal file format or failed reading.
+    // Return image data. Height is negative if the image is stored top-down.
+    // Return false if illegal file format or failed reading.
     bool readBMP(std::string const &fileName,
         std::int32_t &width, std::int32_t &height, std::ifstream &file);
 
+    // Write count 32-bit values to a binary stream, each lowest byte first.
+    // Return false if failed.
+    bool writeUint32s(std::ostream &stream, std::uint32_t const *values, std::uint64_t count);
+
+    // Read count 32-bit values written by writeUint32s. Return false if failed.
+    bool readUint32s(std::istream &stream, std::uint32_t *values, std::uint64_t count);
+
+    // Return threadCount, or the number of hardware threads if threadCount = 0.
+    std::uint32_t threadCount(std::uint32_t threadCount);
+
+    // Split [0, count) into consecutive blocks of blockSize elements and call
+    // function(begin, end) for each block, distributing blocks among up to
+    // threadCount threads (all hardware threads if threadCount = 0).
+    template <typename Function>
+    void parallelFor(std::uint64_t count, std::uint64_t blockSize,
+        std::uint32_t threadCount, Function const &function);
+
+    // As parallelFor, but call function(thread, begin, end), where thread is the index
+    // of the calling thread, smaller than the number of threads used.
+    template <typename Function>
+    void indexedParallelFor(std::uint64_t count, std::uint64_t blockSize,
+        std::uint32_t threadCount, Function const &function);
+
+}
+
+template <typename Function>
+void Utilities::parallelFor(std::uint64_t count, std::uint64_t blockSize,
+    std::uint32_t threadCount, Function const &function)
+{
+    indexedParallelFor(count, blockSize, threadCount,
+        [&](std::uint32_t, std::uint64_t begin, std::uint64_t end) {
+            function(begin, end);
+        });
+}
+
+template <typename Function>
+void Utilities::indexedParallelFor(std::uint64_t count, std::uint64_t blockSize,
+    std::uint32_t threadCount, Function const &function)
+{
+    if (blockSize == 0) {
+        blockSize = 1;
+    }
+    std::uint64_t blockCount = (count + blockSize - 1) / blockSize;
+    threadCount = static_cast<std::uint32_t>(
+        std::min<std::uint64_t>(Utilities::threadCount(threadCount), blockCount));
+    if (threadCount <= 1) {
+        if (count != 0) {
+            function(0, 0, count);
+        }
+        return;
+    }
+    std::atomic<std::uint64_t> nextBlock{0};
+    auto worker = [&](std::uint32_t thread) {
+        for (std::uint64_t block = nextBlock++; block < blockCount; block = nextBlock++) {
+            std::uint64_t begin = block * blockSize;
+            function(thread, begin, std::min(begin + blockSize, count));
+        }
+    };
+    std::vector<std::thread> threads;
+    for (std::uint32_t k = 1; k < threadCount; k++) {
+        threads.emplace_back(worker, k);
+    }
+    worker(0);
+    for (std::thread &thread : threads) {
+        thread.join();
+    }
 }
 
 #endif
\ No newline at end of file